@@ -0,0 +1,50 @@
+// Interposes the glibc allocator, the same idea as the firmware's
+// src/diagnostics/alloc_tracker.cpp but without per-task accounting.
+
+#include "alloc_counter.h"
+#include <atomic>
+#include <cstddef>
+
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void __libc_free(void *ptr);
+}
+
+namespace
+{
+    std::atomic<uint64_t> allocations{0};
+}
+
+uint64_t allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+extern "C"
+{
+    void *malloc(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void *ptr)
+    {
+        __libc_free(ptr);
+    }
+}
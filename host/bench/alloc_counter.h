@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+
+// Heap allocations made by this process so far. alloc_counter.cpp replaces
+// malloc and friends for the whole executable, so allocations made inside
+// libstdc++ (operator new) and ArduinoJson are both counted.
+uint64_t allocationCount();
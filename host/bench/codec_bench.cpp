@@ -0,0 +1,321 @@
+// Micro-benchmarks for the serial codec and the publish/receive pipeline.
+//
+//   codec_bench [--json] [--filter <substring>] [--min-ms <batch ms>]
+//
+// SerialIO itself needs the Arduino UART, the LED task and the telemetry
+// history, so the publish and process_packet benchmarks run the same steps
+// as SerialIO::publish and SerialIO::_processPacket through the shared
+// serial_coms functions, with the UART replaced by a memory sink.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ArduinoJson.h>
+#include "alloc_counter.h"
+#include "motor_control/dshot_encoder.h"
+#include "serial_coms/cobs_transcoder.h"
+#include "serial_coms/crc8_calc.h"
+#include "serial_coms/frame_codec.h"
+#include "serial_coms/msgpack_transcoder.h"
+
+#ifndef BRIDGE_VERSION
+#define BRIDGE_VERSION "unknown"
+#endif
+
+namespace
+{
+    struct Options
+    {
+        bool json = false;
+        const char *filter = nullptr;
+        double batchMs = 20;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::string payload;
+        size_t bytes; // Input bytes per operation
+        uint64_t iterations;
+        double nsPerOp;
+        double allocsPerOp;
+    };
+
+    const int BATCHES = 5;
+
+    // Keeps the compiler from dropping work whose result is unused
+    inline void keep(const void *p)
+    {
+        asm volatile("" : : "g"(p) : "memory");
+    }
+
+    double runBatch(const std::function<void()> &op, uint64_t iterations)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            op();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    class Bench
+    {
+    public:
+        explicit Bench(const Options &options) : _options(options) {}
+
+        void run(const char *name, const std::string &payload, size_t bytes, const std::function<void()> &op)
+        {
+            std::string id = std::string(name) + "/" + payload;
+            if (_options.filter != nullptr && id.find(_options.filter) == std::string::npos)
+                return;
+
+            // Grow the batch until it takes batchMs, then keep the median of BATCHES
+            uint64_t iterations = 1;
+            double targetNs = _options.batchMs * 1e6;
+            for (;;)
+            {
+                double ns = runBatch(op, iterations);
+                if (ns >= targetNs)
+                    break;
+                iterations = ns > targetNs / 100 ? static_cast<uint64_t>(iterations * targetNs / ns * 1.1) : iterations * 10;
+            }
+
+            double samples[BATCHES];
+            uint64_t allocsBefore = allocationCount();
+            for (double &sample : samples)
+                sample = runBatch(op, iterations) / iterations;
+            uint64_t allocs = allocationCount() - allocsBefore;
+            std::sort(samples, samples + BATCHES);
+
+            Result result{name, payload, bytes, iterations * BATCHES, samples[BATCHES / 2],
+                          static_cast<double>(allocs) / (iterations * BATCHES)};
+            _results.push_back(result);
+            if (!_options.json)
+            {
+                printf("%-22s %-10s %6zu B %10.1f ns/op %10.2f MB/s %6.2f allocs/op\n", name, payload.c_str(), bytes,
+                       result.nsPerOp, bytes * 1e3 / result.nsPerOp, result.allocsPerOp);
+            }
+        }
+
+        void printJson() const
+        {
+            printf("{\"version\":\"%s\",\"compiler\":\"%s\",\"results\":[", BRIDGE_VERSION, __VERSION__);
+            for (size_t i = 0; i < _results.size(); ++i)
+            {
+                const Result &r = _results[i];
+                printf("%s\n{\"name\":\"%s\",\"payload\":\"%s\",\"bytes\":%zu,\"iterations\":%llu,"
+                       "\"ns_per_op\":%.2f,\"bytes_per_sec\":%.0f,\"allocs_per_op\":%.3f}",
+                       i ? "," : "", r.name.c_str(), r.payload.c_str(), r.bytes,
+                       static_cast<unsigned long long>(r.iterations), r.nsPerOp, r.bytes * 1e9 / r.nsPerOp,
+                       r.allocsPerOp);
+            }
+            printf("\n]}\n");
+        }
+
+    private:
+        const Options &_options;
+        std::vector<Result> _results;
+    };
+
+    struct Payload
+    {
+        std::string name;
+        uint8_t channel;
+        JsonDocument doc;
+    };
+
+    // Shapes and magnitudes of what the device publishes, see the README
+    std::vector<Payload> makePayloads()
+    {
+        std::vector<Payload> payloads(6);
+
+        payloads[0].name = "imu";
+        payloads[0].channel = 3;
+        payloads[0].doc["x"] = 0.0412f;
+        payloads[0].doc["y"] = -0.1187f;
+        payloads[0].doc["z"] = 9.8123f;
+
+        payloads[1].name = "bme280";
+        payloads[1].channel = 2;
+        payloads[1].doc["a"] = 46;
+        payloads[1].doc["t"] = 22.57f;
+        payloads[1].doc["h"] = 45.12f;
+        payloads[1].doc["p"] = 101325.4f;
+
+        payloads[2].name = "motors8";
+        payloads[2].channel = 1;
+        for (int i = 0; i < 8; ++i)
+            payloads[2].doc[std::to_string(i)] = 0.125f * i - 0.4f;
+
+        payloads[3].name = "orient";
+        payloads[3].channel = 9;
+        const char *keys[] = {"w", "x", "y", "z", "r", "p", "h"};
+        const float values[] = {0.9981f, 0.0123f, -0.0432f, 0.0417f, 0.0241f, -0.0866f, 0.0839f};
+        for (int i = 0; i < 7; ++i)
+            payloads[3].doc[keys[i]] = values[i];
+
+        // Deferred log batches, the largest frames the device sends
+        const int batches[] = {8, 32};
+        for (int b = 0; b < 2; ++b)
+        {
+            Payload &p = payloads[4 + b];
+            p.name = "log" + std::to_string(batches[b]);
+            p.channel = 10;
+            JsonArray records = p.doc["l"].to<JsonArray>();
+            for (int i = 0; i < batches[b]; ++i)
+            {
+                JsonArray record = records.add<JsonArray>();
+                record.add(1234567u + i * 1000u);
+                record.add(2 + i % 5);
+                record.add(46);
+                record.add(1110704128u + i);
+            }
+        }
+        return payloads;
+    }
+
+    // Raw blocks for the byte-level codecs, one zero in 16 bytes on average
+    std::vector<uint8_t> makeBlock(size_t size, std::mt19937 &rng)
+    {
+        std::vector<uint8_t> block(size);
+        for (uint8_t &b : block)
+            b = rng() % 16 == 0 ? 0 : 1 + rng() % 255;
+        return block;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            options.json = true;
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            options.filter = argv[++i];
+        else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc)
+            options.batchMs = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--json] [--filter <substring>] [--min-ms <batch ms>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Bench bench(options);
+    std::mt19937 rng(1);
+
+    // Byte-level codecs across block sizes
+    for (size_t size : {16, 64, 256, 1024})
+    {
+        std::string label = std::to_string(size);
+        std::vector<uint8_t> block = makeBlock(size, rng);
+        std::vector<uint8_t> encoded = cobs_transcoder::encode(block);
+        std::vector<uint8_t> out(cobs_transcoder::maxEncodedSize(size));
+
+        bench.run("crc8", label, size, [&]()
+                  { volatile uint8_t crc = crc8(block.data(), block.size()); (void)crc; });
+        bench.run("cobs_encode", label, size, [&]()
+                  { auto e = cobs_transcoder::encode(block); keep(e.data()); });
+        bench.run("cobs_encode_buf", label, size, [&]()
+                  { keep(out.data() + cobs_transcoder::encode(block.data(), block.size(), out.data())); });
+        bench.run("cobs_decode", label, encoded.size(), [&]()
+                  { auto d = cobs_transcoder::decode(encoded); keep(d.data()); });
+        bench.run("cobs_decode_buf", label, encoded.size(), [&]()
+                  { keep(out.data() + cobs_transcoder::decode(encoded.data(), encoded.size(), out.data())); });
+    }
+
+    // DShot frame building, the per ESC work of DShotDriver::stageValue on every frame. The
+    // timing is the firmware's, 80 MHz APB clock divided by DSHOT_RMT_CLK_DIV (2)
+    for (uint32_t kbit : {150, 300, 600})
+    {
+        std::string label = "dshot" + std::to_string(kbit);
+        const DShotEncoder::Timing timing = DShotEncoder::timing(kbit, 40000000);
+        DShotEncoder::Symbol symbols[DShotEncoder::FRAME_BITS];
+        float throttle = -1.0f;
+
+        bench.run("dshot_encode", label, sizeof(uint16_t), [&]()
+                  {
+                      throttle = throttle >= 1.0f ? -1.0f : throttle + 0.01f;
+                      uint16_t frame = DShotEncoder::makeFrame(DShotEncoder::throttleToValue(throttle, true), false);
+                      DShotEncoder::encode(frame, timing, symbols);
+                      keep(symbols); });
+    }
+
+    std::vector<Payload> payloads = makePayloads();
+    std::vector<uint8_t> sink(64 * 1024);
+    size_t sinkPos = 0;
+    auto write = [&](const uint8_t *data, size_t size)
+    {
+        if (sinkPos + size > sink.size())
+            sinkPos = 0;
+        memcpy(sink.data() + sinkPos, data, size);
+        sinkPos += size;
+    };
+
+    // Receive side subscribers, as registered in main.cpp
+    std::unordered_map<uint8_t, std::function<void(const JsonDocument &doc)>> callbacks;
+    for (const Payload &p : payloads)
+        callbacks[p.channel] = [](const JsonDocument &doc)
+        { keep(&doc); };
+
+    for (Payload &p : payloads)
+    {
+        std::vector<uint8_t> msgpack = encodeToMsgPack(p.doc);
+        std::vector<uint8_t> frame(frame_codec::maxFrameSize(msgpack.size()));
+        frame.resize(frame_codec::encode(p.channel, msgpack.data(), msgpack.size(), frame.data()) - 1);
+        std::vector<uint8_t> scratch(frame.size());
+        JsonDocument reused;
+
+        bench.run("msgpack_encode", p.name, msgpack.size(), [&]()
+                  { auto m = encodeToMsgPack(p.doc); keep(m.data()); });
+        bench.run("msgpack_decode", p.name, msgpack.size(), [&]()
+                  { decodeFromMsgPack(msgpack.data(), msgpack.size(), reused); keep(&reused); });
+        bench.run("frame_encode", p.name, msgpack.size(), [&]()
+                  { keep(sink.data() + frame_codec::encode(p.channel, msgpack.data(), msgpack.size(), sink.data())); });
+        bench.run("frame_decode", p.name, frame.size(), [&]()
+                  {
+                      // Decoding is in place, so every run starts from a fresh copy
+                      memcpy(scratch.data(), frame.data(), frame.size());
+                      frame_codec::Frame decoded;
+                      frame_codec::decode(scratch.data(), scratch.size(), decoded);
+                      keep(decoded.payload); });
+
+        // SerialIO::publish: MsgPack, framing into a vector, UART write
+        bench.run("publish", p.name, msgpack.size(), [&]()
+                  {
+                      auto m = encodeToMsgPack(p.doc);
+                      std::vector<uint8_t> out(frame_codec::maxFrameSize(m.size()));
+                      out.resize(frame_codec::encode(p.channel, m.data(), m.size(), out.data()));
+                      write(out.data(), out.size()); });
+
+        // SerialIO::updateSubscribers and _processPacket: bytes collected into
+        // the frame buffer, decoded in place, a fresh document and the callback
+        std::vector<uint8_t> rxBuffer;
+        rxBuffer.reserve(1024);
+        bench.run("process_packet", p.name, frame.size() + 1, [&]()
+                  {
+                      rxBuffer.clear();
+                      for (uint8_t byte : frame)
+                          rxBuffer.push_back(byte);
+                      frame_codec::Frame decoded;
+                      if (frame_codec::decode(rxBuffer.data(), rxBuffer.size(), decoded) != frame_codec::Status::Ok)
+                          abort();
+                      JsonDocument doc;
+                      if (!decodeFromMsgPack(decoded.payload, decoded.size, doc))
+                          abort();
+                      auto it = callbacks.find(decoded.channel);
+                      if (it != callbacks.end())
+                          it->second(doc); });
+    }
+
+    if (options.json)
+        bench.printJson();
+    return 0;
+}
@@ -0,0 +1,223 @@
+// Python bindings for SerialLink. Payloads are exchanged as dicts, the API
+// mirrors SeaPort so existing scripts only need to swap the constructor:
+//
+//   link = bridge_link.Link("/dev/ttyUSB0", 115200)
+//   link.subscribe(2, lambda data: print(data))
+//   link.start()
+//   link.publish(254, {"cmd": "ping"})
+
+#include <pybind11/functional.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <thread>
+#include "capture.h"
+#include "serial_link.h"
+
+namespace py = pybind11;
+
+namespace
+{
+    py::object toPython(JsonVariantConst v)
+    {
+        if (v.is<JsonObjectConst>())
+        {
+            py::dict dict;
+            for (JsonPairConst kv : v.as<JsonObjectConst>())
+                dict[py::str(kv.key().c_str())] = toPython(kv.value());
+            return std::move(dict);
+        }
+        if (v.is<JsonArrayConst>())
+        {
+            py::list list;
+            for (JsonVariantConst item : v.as<JsonArrayConst>())
+                list.append(toPython(item));
+            return std::move(list);
+        }
+        if (v.is<bool>())
+            return py::bool_(v.as<bool>());
+        if (v.is<int64_t>())
+            return py::int_(v.as<int64_t>());
+        if (v.is<uint64_t>())
+            return py::int_(v.as<uint64_t>());
+        if (v.is<double>())
+            return py::float_(v.as<double>());
+        if (v.is<const char *>())
+            return py::str(v.as<const char *>());
+        return py::none();
+    }
+
+    void fromPython(py::handle obj, JsonVariant v)
+    {
+        if (py::isinstance<py::dict>(obj))
+        {
+            JsonObject out = v.to<JsonObject>();
+            for (auto item : py::reinterpret_borrow<py::dict>(obj))
+                fromPython(item.second, out[py::str(item.first).cast<std::string>()]);
+        }
+        else if (py::isinstance<py::list>(obj) || py::isinstance<py::tuple>(obj))
+        {
+            JsonArray out = v.to<JsonArray>();
+            for (auto item : obj)
+                fromPython(item, out.add<JsonVariant>());
+        }
+        else if (py::isinstance<py::bool_>(obj))
+            v.set(obj.cast<bool>());
+        else if (py::isinstance<py::int_>(obj))
+            v.set(obj.cast<int64_t>());
+        else if (py::isinstance<py::float_>(obj))
+            v.set(obj.cast<double>());
+        else if (py::isinstance<py::str>(obj))
+            v.set(obj.cast<std::string>());
+        else if (obj.is_none())
+            v.clear();
+        else
+            throw py::type_error("Unsupported payload type " + std::string(py::str(obj.get_type())));
+    }
+
+    // Owns the background thread started by start(). Subscribers are called on
+    // the polling thread and take the GIL themselves, so subscribe before start().
+    class PyLink
+    {
+    public:
+        PyLink(const std::string &path, uint32_t baud)
+        {
+            if (!_link.open(path, baud))
+                throw py::value_error(_link.lastError());
+        }
+        ~PyLink() { stop(); }
+
+        void subscribe(uint8_t channel, py::function cb)
+        {
+            _link.subscribe(channel, [cb](const JsonDocument &doc)
+                            {
+                                py::gil_scoped_acquire gil;
+                                call(cb, toPython(doc.as<JsonVariantConst>())); });
+        }
+
+        void subscribeRaw(uint8_t channel, py::function cb)
+        {
+            _link.subscribeRaw(channel, [cb](uint8_t, const uint8_t *payload, size_t size)
+                               {
+                                   py::gil_scoped_acquire gil;
+                                   call(cb, py::bytes(reinterpret_cast<const char *>(payload), size)); });
+        }
+
+        bool publish(uint8_t channel, py::handle payload)
+        {
+            JsonDocument doc;
+            fromPython(payload, doc.to<JsonVariant>());
+            py::gil_scoped_release release;
+            return _link.publish(channel, doc);
+        }
+
+        bool publishRaw(uint8_t channel, py::bytes payload)
+        {
+            std::string data = payload;
+            py::gil_scoped_release release;
+            return _link.publishRaw(channel, reinterpret_cast<const uint8_t *>(data.data()), data.size());
+        }
+
+        int poll(int timeoutMs)
+        {
+            int frames;
+            {
+                py::gil_scoped_release release;
+                frames = _link.poll(timeoutMs);
+            }
+            if (frames < 0)
+                throw py::value_error(_link.lastError());
+            return frames;
+        }
+
+        void start()
+        {
+            if (_thread.joinable())
+                return;
+            _thread = std::thread([this]()
+                                  { _link.run(); });
+        }
+
+        void stop()
+        {
+            if (!_thread.joinable())
+                return;
+            _link.stop();
+            py::gil_scoped_release release; // Callbacks may be waiting for the GIL
+            _thread.join();
+        }
+
+        void startCapture(const std::string &path)
+        {
+            if (_thread.joinable())
+                throw py::value_error("Start the capture before start()");
+            if (!_capture.open(path))
+                throw py::value_error(_capture.lastError());
+            _link.setCapture(&_capture);
+        }
+
+        void stopCapture()
+        {
+            if (_thread.joinable())
+                throw py::value_error("Stop the link before the capture");
+            _link.setCapture(nullptr);
+            _capture.close();
+        }
+
+        py::dict stats() const
+        {
+            SerialLink::Stats s = _link.stats();
+            py::dict d;
+            d["rx_bytes"] = s.rxBytes;
+            d["rx_frames"] = s.rxFrames;
+            d["tx_bytes"] = s.txBytes;
+            d["tx_frames"] = s.txFrames;
+            d["cobs_errors"] = s.cobsErrors;
+            d["crc_errors"] = s.crcErrors;
+            d["short_frames"] = s.shortFrames;
+            d["decode_errors"] = s.decodeErrors;
+            d["overflows"] = s.overflows;
+            d["tx_dropped"] = s.txDropped;
+            return d;
+        }
+
+    private:
+        template <typename Arg>
+        static void call(const py::function &cb, Arg &&arg);
+
+        CaptureWriter _capture; // Outlives _link, which may still be recording into it
+        SerialLink _link;
+        std::thread _thread;
+    };
+
+    template <typename Arg>
+    void PyLink::call(const py::function &cb, Arg &&arg)
+    {
+        // Exceptions must not unwind into the poll loop
+        try
+        {
+            cb(std::forward<Arg>(arg));
+        }
+        catch (py::error_already_set &e)
+        {
+            e.discard_as_unraisable("bridge_link subscriber");
+        }
+    }
+} // namespace
+
+PYBIND11_MODULE(bridge_link, m)
+{
+    m.doc() = "Native serial link to the ESP32 bridge";
+
+    py::class_<PyLink>(m, "Link")
+        .def(py::init<const std::string &, uint32_t>(), py::arg("path"), py::arg("baud") = 115200)
+        .def("subscribe", &PyLink::subscribe, py::arg("channel"), py::arg("callback"))
+        .def("subscribe_raw", &PyLink::subscribeRaw, py::arg("channel"), py::arg("callback"))
+        .def("publish", &PyLink::publish, py::arg("channel"), py::arg("payload"))
+        .def("publish_raw", &PyLink::publishRaw, py::arg("channel"), py::arg("payload"))
+        .def("poll", &PyLink::poll, py::arg("timeout_ms") = -1)
+        .def("start", &PyLink::start)
+        .def("stop", &PyLink::stop)
+        .def("start_capture", &PyLink::startCapture, py::arg("path"))
+        .def("stop_capture", &PyLink::stopCapture)
+        .def("stats", &PyLink::stats);
+}
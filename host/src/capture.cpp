@@ -0,0 +1,228 @@
+#include "capture.h"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t WRITE_BUFFER_SIZE = 1024 * 1024;
+
+    void put16(uint8_t *out, uint16_t value)
+    {
+        out[0] = value;
+        out[1] = value >> 8;
+    }
+
+    void put32(uint8_t *out, uint32_t value)
+    {
+        put16(out, value);
+        put16(out + 2, value >> 16);
+    }
+
+    void put64(uint8_t *out, uint64_t value)
+    {
+        put32(out, value);
+        put32(out + 4, value >> 32);
+    }
+
+    uint16_t get16(const uint8_t *in)
+    {
+        return in[0] | (in[1] << 8);
+    }
+
+    uint32_t get32(const uint8_t *in)
+    {
+        return get16(in) | (static_cast<uint32_t>(get16(in + 2)) << 16);
+    }
+
+    uint64_t get64(const uint8_t *in)
+    {
+        return get32(in) | (static_cast<uint64_t>(get32(in + 4)) << 32);
+    }
+
+    uint64_t clockNs(clockid_t clock)
+    {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+} // namespace
+
+uint64_t captureClockNs()
+{
+    return clockNs(CLOCK_MONOTONIC);
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const std::string &path)
+{
+    close();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _file = fopen(path.c_str(), "wbe");
+    if (_file == nullptr)
+    {
+        _lastError = path + ": " + std::strerror(errno);
+        return false;
+    }
+    _fileBuffer.resize(WRITE_BUFFER_SIZE);
+    setvbuf(_file, _fileBuffer.data(), _IOFBF, _fileBuffer.size());
+
+    uint8_t header[FILE_HEADER_SIZE];
+    put32(header, MAGIC);
+    put16(header + 4, VERSION);
+    put16(header + 6, FILE_HEADER_SIZE);
+    put64(header + 8, clockNs(CLOCK_REALTIME));
+    fwrite(header, 1, sizeof(header), _file);
+
+    _startNs = captureClockNs();
+    _records = 0;
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_file != nullptr)
+    {
+        fclose(_file);
+        _file = nullptr;
+    }
+}
+
+void CaptureWriter::record(CaptureDirection direction, const uint8_t *frame, size_t size)
+{
+    if (size > MAX_RECORD_SIZE)
+    {
+        return;
+    }
+
+    uint8_t header[RECORD_HEADER_SIZE];
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_file == nullptr)
+    {
+        return;
+    }
+    // Taken under the lock so records stay in time order across threads
+    put64(header, captureClockNs() - _startNs);
+    put16(header + 8, size);
+    header[10] = static_cast<uint8_t>(direction);
+    header[11] = 0; // Flags, reserved
+    fwrite(header, 1, sizeof(header), _file);
+    fwrite(frame, 1, size, _file);
+    _records++;
+}
+
+void CaptureWriter::flush()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_file != nullptr)
+    {
+        fflush(_file);
+    }
+}
+
+CaptureReader::~CaptureReader()
+{
+    close();
+}
+
+bool CaptureReader::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        _lastError = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < CaptureWriter::FILE_HEADER_SIZE)
+    {
+        _lastError = path + ": not a capture";
+        ::close(fd);
+        return false;
+    }
+
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+        _lastError = path + ": " + std::strerror(errno);
+        return false;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    _map = static_cast<const uint8_t *>(map);
+    _mapSize = st.st_size;
+
+    uint16_t headerSize = get16(_map + 6);
+    if (get32(_map) != CaptureWriter::MAGIC || get16(_map + 4) != CaptureWriter::VERSION ||
+        headerSize < CaptureWriter::FILE_HEADER_SIZE || headerSize > _mapSize)
+    {
+        _lastError = path + ": not a capture or unsupported version";
+        close();
+        return false;
+    }
+    _startNs = get64(_map + 8);
+
+    // Records carry no index, build one in a single pass
+    size_t offset = headerSize;
+    while (offset + CaptureWriter::RECORD_HEADER_SIZE <= _mapSize)
+    {
+        size_t end = offset + CaptureWriter::RECORD_HEADER_SIZE + get16(_map + offset + 8);
+        if (end > _mapSize)
+            break;
+        _offsets.push_back(offset);
+        offset = end;
+    }
+    _truncated = offset != _mapSize;
+    return true;
+}
+
+void CaptureReader::close()
+{
+    if (_map != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(_map), _mapSize);
+        _map = nullptr;
+    }
+    _mapSize = 0;
+    _startNs = 0;
+    _truncated = false;
+    _offsets.clear();
+}
+
+CaptureRecord CaptureReader::operator[](size_t index) const
+{
+    const uint8_t *header = _map + _offsets[index];
+    CaptureRecord record;
+    record.timeNs = get64(header);
+    record.size = get16(header + 8);
+    record.direction = static_cast<CaptureDirection>(header[10]);
+    record.data = header + CaptureWriter::RECORD_HEADER_SIZE;
+    return record;
+}
+
+size_t CaptureReader::find(uint64_t timeNs) const
+{
+    // Timestamps come from a monotonic clock, so records are sorted by time
+    size_t low = 0;
+    size_t high = _offsets.size();
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (get64(_map + _offsets[mid]) < timeNs)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
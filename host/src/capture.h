@@ -0,0 +1,95 @@
+// capture.h
+//
+// Append-only capture of raw link frames in both directions. Frames are stored
+// as they were on the wire (COBS encoded, without the delimiter), so captures
+// reproduce corrupted traffic too. All fields are little endian:
+//
+//   file header  "BCAP", u16 version, u16 header size, u64 start time (ns since epoch)
+//   record       u64 time (ns since start), u16 length, u8 direction, u8 flags, frame
+//
+// Records have no padding and no index. A reader maps the file and indexes it
+// in one pass, stopping at a tail record that was cut short by a crash.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class CaptureDirection : uint8_t
+{
+    Rx = 0, // Device to host
+    Tx = 1, // Host to device
+};
+
+struct CaptureRecord
+{
+    uint64_t timeNs;
+    CaptureDirection direction;
+    const uint8_t *data;
+    size_t size;
+};
+
+class CaptureWriter
+{
+public:
+    static constexpr uint32_t MAGIC = 0x50414342; // "BCAP"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t FILE_HEADER_SIZE = 16;
+    static constexpr size_t RECORD_HEADER_SIZE = 12;
+    static constexpr size_t MAX_RECORD_SIZE = 0xFFFF;
+
+    ~CaptureWriter();
+
+    // Creates or truncates the capture
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return _file != nullptr; }
+    const std::string &lastError() const { return _lastError; }
+
+    // Thread safe. Frames longer than MAX_RECORD_SIZE are not recorded.
+    void record(CaptureDirection direction, const uint8_t *frame, size_t size);
+    void flush();
+
+    uint64_t records() const { return _records; }
+
+private:
+    std::mutex _mutex;
+    FILE *_file = nullptr;
+    std::vector<char> _fileBuffer;
+    uint64_t _startNs = 0;
+    uint64_t _records = 0;
+    std::string _lastError;
+};
+
+class CaptureReader
+{
+public:
+    ~CaptureReader();
+
+    bool open(const std::string &path);
+    void close();
+    const std::string &lastError() const { return _lastError; }
+
+    size_t size() const { return _offsets.size(); }
+    CaptureRecord operator[](size_t index) const;
+    // Index of the first record at or after timeNs, size() if there is none
+    size_t find(uint64_t timeNs) const;
+
+    uint64_t startTimeNs() const { return _startNs; }
+    // True when the last record was incomplete and has been ignored
+    bool truncated() const { return _truncated; }
+
+private:
+    const uint8_t *_map = nullptr;
+    size_t _mapSize = 0;
+    uint64_t _startNs = 0;
+    bool _truncated = false;
+    std::vector<size_t> _offsets;
+    std::string _lastError;
+};
+
+// Nanoseconds on the monotonic clock, used for capture timestamps
+uint64_t captureClockNs();
@@ -0,0 +1,111 @@
+#include "link_impairment.h"
+
+namespace
+{
+    const uint64_t NEVER = UINT64_MAX;
+    const uint32_t BITS_PER_BYTE = 10; // Start bit, 8 data bits, stop bit
+} // namespace
+
+LinkImpairment::LinkImpairment(const ImpairmentConfig &config)
+    : _config(config),
+      _byteNs(BITS_PER_BYTE * 1000000000ull / config.baud),
+      _ring(config.bufferSize),
+      _rng(config.seed)
+{
+    // Errors are drawn as gaps between events, so clean bytes cost nothing
+    _bytesToLoss = nextGap(config.lossRate);
+    _bitsToError = nextGap(config.bitErrorRate);
+    _nextBurstNs = NEVER;
+    if (config.burstsPerSec > 0 && config.burstLength > 0)
+    {
+        _nextBurstNs = std::exponential_distribution<double>(config.burstsPerSec)(_rng) * 1e9;
+    }
+}
+
+uint64_t LinkImpairment::nextGap(double probability)
+{
+    if (probability <= 0)
+        return NEVER;
+    if (probability >= 1)
+        return 0;
+    return std::geometric_distribution<uint64_t>(probability)(_rng);
+}
+
+size_t LinkImpairment::push(const uint8_t *data, size_t size, uint64_t nowNs)
+{
+    if (_count == 0 && _lineNs < nowNs)
+    {
+        // The line was idle, the first byte starts now
+        _lineNs = nowNs;
+    }
+
+    size_t accepted = 0;
+    while (accepted < size && _count < _ring.size())
+    {
+        _ring[(_head + _count) % _ring.size()] = data[accepted++];
+        _count++;
+    }
+    _stats.bytesIn += size;
+    _stats.overflowed += size - accepted;
+    return accepted;
+}
+
+size_t LinkImpairment::pull(uint64_t nowNs, uint8_t *out, size_t capacity)
+{
+    size_t written = 0;
+    while (_count > 0 && written < capacity && _lineNs + _byteNs <= nowNs)
+    {
+        uint8_t byte = _ring[_head];
+        _head = (_head + 1) % _ring.size();
+        _count--;
+        _lineNs += _byteNs; // This byte's finish time, the start of the next one
+
+        if (_lineNs >= _nextBurstNs)
+        {
+            _burstRemaining = _config.burstLength;
+            _stats.bursts++;
+            _nextBurstNs = _lineNs + std::exponential_distribution<double>(_config.burstsPerSec)(_rng) * 1e9;
+        }
+        if (_burstRemaining > 0)
+        {
+            _burstRemaining--;
+            _stats.burstBytes++;
+            byte = static_cast<uint8_t>(_rng());
+        }
+
+        if (_bitsToError < 8)
+        {
+            // Flip every error that falls inside this byte's data bits
+            uint64_t bit = _bitsToError;
+            while (bit < 8)
+            {
+                byte ^= 1u << bit;
+                _stats.bitFlips++;
+                bit += 1 + nextGap(_config.bitErrorRate);
+            }
+            _bitsToError = bit - 8;
+        }
+        else if (_bitsToError != NEVER)
+        {
+            _bitsToError -= 8;
+        }
+
+        if (_bytesToLoss == 0)
+        {
+            _stats.lost++;
+            _bytesToLoss = nextGap(_config.lossRate);
+            continue;
+        }
+        if (_bytesToLoss != NEVER)
+            _bytesToLoss--;
+
+        out[written++] = byte;
+        _stats.bytesOut++;
+    }
+    return written;
+}
+
+uint64_t LinkImpairment::nextDeliveryNs() const
+{
+    return _count > 0 ? _lineNs + _byteNs : NEVER;
+}
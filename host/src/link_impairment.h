@@ -0,0 +1,67 @@
+// link_impairment.h
+//
+// One direction of a simulated UART. Bytes are paced at the configured baud
+// rate (8N1, 10 bit times per byte) through a bounded buffer and can be lost,
+// have bits flipped or be overwritten by bursts of noise. Time is passed in
+// by the caller, so the model has no I/O and can be stepped deterministically.
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct ImpairmentConfig
+{
+    uint32_t baud = 115200;
+    double lossRate = 0;      // Probability that a byte is lost
+    double bitErrorRate = 0;  // Probability that a bit is flipped
+    double burstsPerSec = 0;  // Mean rate of noise bursts
+    uint32_t burstLength = 0; // Bytes replaced by noise per burst
+    size_t bufferSize = 4096; // Bytes queued before new ones are dropped
+    uint32_t seed = 1;
+};
+
+class LinkImpairment
+{
+public:
+    struct Stats
+    {
+        uint64_t bytesIn;
+        uint64_t bytesOut;
+        uint64_t overflowed; // Dropped because the buffer was full
+        uint64_t lost;
+        uint64_t bitFlips;
+        uint64_t bursts;
+        uint64_t burstBytes;
+    };
+
+    explicit LinkImpairment(const ImpairmentConfig &config);
+
+    // Queues bytes written into the link at nowNs, returns how many fit
+    size_t push(const uint8_t *data, size_t size, uint64_t nowNs);
+    // Moves the bytes that finished transmission by nowNs into out
+    size_t pull(uint64_t nowNs, uint8_t *out, size_t capacity);
+    // When the next queued byte finishes, UINT64_MAX while idle
+    uint64_t nextDeliveryNs() const;
+
+    size_t queued() const { return _count; }
+    const Stats &stats() const { return _stats; }
+
+private:
+    uint64_t nextGap(double probability);
+
+    ImpairmentConfig _config;
+    uint64_t _byteNs;
+    std::vector<uint8_t> _ring;
+    size_t _head = 0;
+    size_t _count = 0;
+    uint64_t _lineNs = 0; // When the byte at _head starts transmission, it is delivered at _lineNs + _byteNs
+
+    std::mt19937_64 _rng;
+    uint64_t _bytesToLoss;    // Bytes until the next lost byte
+    uint64_t _bitsToError;    // Bits until the next flipped bit
+    uint64_t _nextBurstNs;    // Line time when the next burst starts
+    uint32_t _burstRemaining = 0;
+    Stats _stats = {};
+};
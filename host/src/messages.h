@@ -0,0 +1,211 @@
+// messages.h
+//
+// Typed views of the channel payloads documented in the README. fromJson()
+// returns false when a required key is missing, toJson() builds the payload
+// for messages the host sends.
+
+#pragma once
+#include <ArduinoJson.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <initializer_list>
+#include <map>
+
+enum Channel : uint8_t
+{
+    CHANNEL_MOTORS = 1,
+    CHANNEL_BME280 = 2,
+    CHANNEL_ACCEL = 3,
+    CHANNEL_GYRO = 4,
+    CHANNEL_IMU_META = 5,
+    CHANNEL_ANALOG = 6,
+    CHANNEL_DIGITAL = 7,
+    CHANNEL_BOARD_EVENTS = 8,
+    CHANNEL_ORIENTATION = 9,
+    CHANNEL_LOG = 10,
+    CHANNEL_HISTORY = 11,
+    CHANNEL_FAILSAFE = 12,
+    CHANNEL_HOLD = 13,
+    CHANNEL_WRENCH = 14,
+    CHANNEL_CPU = 15,
+    CHANNEL_SIGNALING = 254,
+};
+
+// Channel 2
+struct Bme280Sample
+{
+    uint8_t address;
+    float temperature; // Celsius
+    float humidity;    // Percent
+    float pressure;    // Pascals
+};
+
+// Channels 3 and 4
+struct Vector3
+{
+    float x;
+    float y;
+    float z;
+};
+
+// Channel 5
+struct ImuMeta
+{
+    float temperature;
+    uint64_t time; // Picoseconds
+};
+
+// Channels 6 and 7
+struct InputSample
+{
+    uint8_t address;
+    uint8_t index;
+    uint16_t value;
+};
+
+// Channel 8
+struct BoardEvent
+{
+    bool attached;
+    uint8_t address;
+    uint8_t digitalOutputs;
+    uint8_t digitalInputs;
+    uint8_t analogInputs;
+    uint8_t bme280s;
+    uint8_t leds;
+};
+
+// Channel 9
+struct Orientation
+{
+    float w, x, y, z;
+    float roll, pitch, heading; // Radians
+};
+
+// Channel 12
+struct FailsafeEvent
+{
+    uint8_t esc;
+    float value;
+    uint32_t timeoutMs;
+    uint32_t trips;
+};
+
+// Channel 1, ESC index to setpoint
+struct MotorCommand
+{
+    std::map<uint8_t, float> setpoints;
+};
+
+inline bool hasKeys(JsonVariantConst v, std::initializer_list<const char *> keys)
+{
+    for (const char *key : keys)
+    {
+        if (v[key].isNull())
+            return false;
+    }
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, Bme280Sample &m)
+{
+    if (!hasKeys(v, {"a", "t", "h", "p"}))
+        return false;
+    m.address = v["a"];
+    m.temperature = v["t"];
+    m.humidity = v["h"];
+    m.pressure = v["p"];
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, Vector3 &m)
+{
+    if (!hasKeys(v, {"x", "y", "z"}))
+        return false;
+    m.x = v["x"];
+    m.y = v["y"];
+    m.z = v["z"];
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, ImuMeta &m)
+{
+    if (!hasKeys(v, {"t", "ti"}))
+        return false;
+    m.temperature = v["t"];
+    m.time = v["ti"];
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, InputSample &m)
+{
+    if (!hasKeys(v, {"a", "i", "v"}))
+        return false;
+    m.address = v["a"];
+    m.index = v["i"];
+    m.value = v["v"];
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, BoardEvent &m)
+{
+    if (!hasKeys(v, {"e", "a"}))
+        return false;
+    m.attached = v["e"].as<int>() != 0;
+    m.address = v["a"];
+    m.digitalOutputs = v["do"] | 0;
+    m.digitalInputs = v["di"] | 0;
+    m.analogInputs = v["ai"] | 0;
+    m.bme280s = v["b"] | 0;
+    m.leds = v["l"] | 0;
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, Orientation &m)
+{
+    if (!hasKeys(v, {"w", "x", "y", "z"}))
+        return false;
+    m.w = v["w"];
+    m.x = v["x"];
+    m.y = v["y"];
+    m.z = v["z"];
+    m.roll = v["r"] | 0.0f;
+    m.pitch = v["p"] | 0.0f;
+    m.heading = v["h"] | 0.0f;
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, FailsafeEvent &m)
+{
+    if (!hasKeys(v, {"e", "v"}))
+        return false;
+    m.esc = v["e"];
+    m.value = v["v"];
+    m.timeoutMs = v["ms"] | 0u;
+    m.trips = v["n"] | 0u;
+    return true;
+}
+
+inline bool fromJson(JsonVariantConst v, MotorCommand &m)
+{
+    JsonObjectConst obj = v.as<JsonObjectConst>();
+    if (obj.isNull())
+        return false;
+    m.setpoints.clear();
+    for (JsonPairConst kv : obj)
+    {
+        m.setpoints[static_cast<uint8_t>(atoi(kv.key().c_str()))] = kv.value().as<float>();
+    }
+    return true;
+}
+
+inline void toJson(const MotorCommand &m, JsonDocument &doc)
+{
+    char key[4];
+    for (const auto &setpoint : m.setpoints)
+    {
+        snprintf(key, sizeof(key), "%u", setpoint.first);
+        doc[key] = setpoint.second;
+    }
+}
@@ -0,0 +1,484 @@
+#include "serial_link.h"
+#include "capture.h"
+#include "serial_coms/frame_codec.h"
+#include "serial_coms/msgpack_transcoder.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+    struct BaudRate
+    {
+        uint32_t baud;
+        speed_t speed;
+    };
+
+    const BaudRate BAUD_RATES[] = {
+        {9600, B9600},
+        {19200, B19200},
+        {38400, B38400},
+        {57600, B57600},
+        {115200, B115200},
+        {230400, B230400},
+        {460800, B460800},
+        {500000, B500000},
+        {576000, B576000},
+        {921600, B921600},
+        {1000000, B1000000},
+        {1152000, B1152000},
+        {1500000, B1500000},
+        {2000000, B2000000},
+        {2500000, B2500000},
+        {3000000, B3000000},
+        {3500000, B3500000},
+        {4000000, B4000000},
+    };
+
+    bool toSpeed(uint32_t baud, speed_t &speed)
+    {
+        for (const BaudRate &rate : BAUD_RATES)
+        {
+            if (rate.baud == baud)
+            {
+                speed = rate.speed;
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+SerialLink::SerialLink() : _rx(MAX_FRAME_SIZE + READ_BATCH_SIZE)
+{
+}
+
+SerialLink::~SerialLink()
+{
+    close();
+}
+
+void SerialLink::setError(const char *what)
+{
+    _lastError = std::string(what) + ": " + std::strerror(errno);
+}
+
+int openSerialPort(const std::string &path, uint32_t baud, std::string &error)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+    {
+        error = path + ": " + std::strerror(errno);
+        return -1;
+    }
+    if (!isatty(fd))
+    {
+        return fd;
+    }
+
+    speed_t speed;
+    if (!toSpeed(baud, speed))
+    {
+        error = "Unsupported baud rate " + std::to_string(baud);
+        ::close(fd);
+        return -1;
+    }
+
+    termios tio;
+    if (tcgetattr(fd, &tio) != 0)
+    {
+        error = std::string("tcgetattr: ") + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~CRTSCTS;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        error = std::string("tcsetattr: ") + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+    return fd;
+}
+
+bool SerialLink::open(const std::string &path, uint32_t baud)
+{
+    close();
+    int fd = openSerialPort(path, baud, _lastError);
+    return fd >= 0 && attach(fd);
+}
+
+bool SerialLink::attach(int fd)
+{
+    if (fd != _fd)
+    {
+        close();
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        setError("fcntl");
+        ::close(fd);
+        return false;
+    }
+
+    _fd = fd;
+    _rxUsed = 0;
+    _discarding = false;
+    if (!setupEpoll())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool SerialLink::setupEpoll()
+{
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    _wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_epoll < 0 || _wake < 0)
+    {
+        setError("epoll");
+        return false;
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = _fd;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _fd, &ev) != 0)
+    {
+        setError("epoll_ctl");
+        return false;
+    }
+    ev.data.fd = _wake;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _wake, &ev) != 0)
+    {
+        setError("epoll_ctl");
+        return false;
+    }
+    _writeArmed = false;
+    return true;
+}
+
+void SerialLink::close()
+{
+    std::lock_guard<std::mutex> lock(_txMutex);
+    for (int *fd : {&_fd, &_epoll, &_wake})
+    {
+        if (*fd >= 0)
+        {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    _tx.clear();
+    _txSent = 0;
+    _rxUsed = 0;
+}
+
+void SerialLink::subscribe(uint8_t channel, Callback cb)
+{
+    _json[channel] = std::move(cb);
+}
+
+void SerialLink::subscribeRaw(uint8_t channel, RawCallback cb)
+{
+    _raw[channel] = std::move(cb);
+}
+
+void SerialLink::unsubscribe(uint8_t channel)
+{
+    _json[channel] = nullptr;
+    _raw[channel] = nullptr;
+}
+
+bool SerialLink::publish(uint8_t channel, const JsonDocument &doc)
+{
+    auto payload = encodeToMsgPack(doc);
+    return publishRaw(channel, payload.data(), payload.size());
+}
+
+bool SerialLink::publishRaw(uint8_t channel, const uint8_t *payload, size_t size)
+{
+    std::lock_guard<std::mutex> lock(_txMutex);
+    if (_fd < 0)
+    {
+        return false;
+    }
+
+    size_t frameSize = frame_codec::maxFrameSize(size);
+    if (_tx.size() - _txSent + frameSize > MAX_TX_QUEUE)
+    {
+        _txDropped++;
+        return false;
+    }
+
+    // Encode straight into the queue behind whatever is still pending
+    size_t offset = _tx.size();
+    _tx.resize(offset + frameSize);
+    size_t length = frame_codec::encode(channel, payload, size, _tx.data() + offset);
+    _tx.resize(offset + length);
+    _txFrames++;
+    if (_capture != nullptr)
+        _capture->record(CaptureDirection::Tx, _tx.data() + offset, length - 1); // Without the delimiter
+    return flushTxLocked();
+}
+
+bool SerialLink::flushTxLocked()
+{
+    while (_txSent < _tx.size())
+    {
+        ssize_t n = ::write(_fd, _tx.data() + _txSent, _tx.size() - _txSent);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            return false;
+        }
+        _txSent += n;
+        _txBytes += n;
+    }
+
+    if (_txSent == _tx.size())
+    {
+        _tx.clear();
+        _txSent = 0;
+    }
+    else if (_txSent > MAX_TX_QUEUE / 2)
+    {
+        _tx.erase(_tx.begin(), _tx.begin() + _txSent);
+        _txSent = 0;
+    }
+    updateWriteInterest(!_tx.empty());
+    return true;
+}
+
+void SerialLink::updateWriteInterest(bool wanted)
+{
+    if (wanted == _writeArmed)
+    {
+        return;
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    if (wanted)
+        ev.events |= EPOLLOUT;
+    ev.data.fd = _fd;
+    if (epoll_ctl(_epoll, EPOLL_CTL_MOD, _fd, &ev) == 0)
+    {
+        _writeArmed = wanted;
+    }
+}
+
+int SerialLink::poll(int timeoutMs)
+{
+    if (_fd < 0)
+    {
+        _lastError = "Link is not open";
+        return -1;
+    }
+
+    epoll_event events[2];
+    int n = epoll_wait(_epoll, events, 2, timeoutMs);
+    if (n < 0)
+    {
+        if (errno == EINTR)
+            return 0;
+        setError("epoll_wait");
+        return -1;
+    }
+
+    int frames = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        if (events[i].data.fd == _wake)
+        {
+            uint64_t value;
+            (void)!::read(_wake, &value, sizeof(value));
+            continue;
+        }
+        if (events[i].events & EPOLLOUT)
+        {
+            std::lock_guard<std::mutex> lock(_txMutex);
+            if (!flushTxLocked())
+            {
+                setError("write");
+                return -1;
+            }
+        }
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        {
+            if (!readAvailable(frames))
+                return -1;
+        }
+    }
+    return frames;
+}
+
+void SerialLink::run()
+{
+    while (!_stop.load())
+    {
+        if (poll(-1) < 0)
+            break;
+    }
+    _stop = false;
+}
+
+void SerialLink::stop()
+{
+    _stop = true;
+    if (_wake >= 0)
+    {
+        uint64_t one = 1;
+        (void)!::write(_wake, &one, sizeof(one));
+    }
+}
+
+bool SerialLink::readAvailable(int &frames)
+{
+    for (;;)
+    {
+        size_t space = _rx.size() - _rxUsed;
+        ssize_t n = ::read(_fd, _rx.data() + _rxUsed, space);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                return true;
+            setError("read");
+            return false;
+        }
+        if (n == 0)
+        {
+            _lastError = "Link closed";
+            return false;
+        }
+
+        _rxBytes += n;
+        size_t scanFrom = _rxUsed;
+        _rxUsed += n;
+        frames += sliceFrames(scanFrom);
+
+        // A short read means the kernel buffer is drained
+        if (static_cast<size_t>(n) < space)
+            return true;
+    }
+}
+
+// Splits the receive buffer at every delimiter after scanFrom and decodes each
+// frame where it lies. Only the unterminated tail is moved to the front.
+size_t SerialLink::sliceFrames(size_t scanFrom)
+{
+    uint8_t *begin = _rx.data();
+    uint8_t *end = begin + _rxUsed;
+    uint8_t *start = begin;
+    uint8_t *cursor = begin + scanFrom;
+    size_t frames = 0;
+
+    while (cursor < end)
+    {
+        uint8_t *delimiter = static_cast<uint8_t *>(memchr(cursor, frame_codec::DELIMITER, end - cursor));
+        if (delimiter == nullptr)
+            break;
+
+        size_t size = delimiter - start;
+        if (_capture != nullptr && size > 0 && !_discarding)
+            _capture->record(CaptureDirection::Rx, start, size);
+        if (_discarding)
+            _discarding = false;
+        else if (size > MAX_FRAME_SIZE)
+            _overflows++;
+        else if (size > 0 && dispatch(start, size))
+            frames++;
+        start = cursor = delimiter + 1;
+    }
+
+    size_t tail = end - start;
+    if (!_discarding && tail > MAX_FRAME_SIZE)
+    {
+        _overflows++;
+        _discarding = true;
+    }
+    if (_discarding)
+        tail = 0;
+    else if (tail > 0 && start != begin)
+        memmove(begin, start, tail);
+    _rxUsed = tail;
+    return frames;
+}
+
+bool SerialLink::dispatch(uint8_t *data, size_t size)
+{
+    frame_codec::Frame frame;
+    switch (frame_codec::decode(data, size, frame))
+    {
+    case frame_codec::Status::Ok:
+        break;
+    case frame_codec::Status::BadCobs:
+        _cobsErrors++;
+        return false;
+    case frame_codec::Status::BadCrc:
+        _crcErrors++;
+        return false;
+    case frame_codec::Status::TooShort:
+        _shortFrames++;
+        return false;
+    }
+    _rxFrames++;
+
+    if (_raw[frame.channel])
+    {
+        _raw[frame.channel](frame.channel, frame.payload, frame.size);
+    }
+    if (_json[frame.channel])
+    {
+        if (!decodeFromMsgPack(frame.payload, frame.size, _doc))
+        {
+            _decodeErrors++;
+            return true;
+        }
+        _json[frame.channel](_doc);
+    }
+    return true;
+}
+
+SerialLink::Stats SerialLink::stats() const
+{
+    Stats s;
+    s.rxBytes = _rxBytes;
+    s.rxFrames = _rxFrames;
+    s.txBytes = _txBytes;
+    s.txFrames = _txFrames;
+    s.cobsErrors = _cobsErrors;
+    s.crcErrors = _crcErrors;
+    s.shortFrames = _shortFrames;
+    s.decodeErrors = _decodeErrors;
+    s.overflows = _overflows;
+    s.txDropped = _txDropped;
+    return s;
+}
+
+void SerialLink::resetStats()
+{
+    for (std::atomic<uint64_t> *counter : {&_rxBytes, &_rxFrames, &_txBytes, &_txFrames, &_cobsErrors,
+                                           &_crcErrors, &_shortFrames, &_decodeErrors, &_overflows, &_txDropped})
+    {
+        *counter = 0;
+    }
+}
@@ -0,0 +1,150 @@
+// serial_link.h
+//
+// Linux host side of the bridge link. Frames are encoded and decoded with the
+// firmware's own src/serial_coms sources so both ends share one codec.
+
+#pragma once
+#include <ArduinoJson.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CaptureWriter;
+
+// Opens a serial device raw and non-blocking, anything that is not a tty is
+// returned as is. Returns -1 and sets error on failure.
+int openSerialPort(const std::string &path, uint32_t baud, std::string &error);
+
+class SerialLink
+{
+public:
+    static constexpr size_t READ_BATCH_SIZE = 64 * 1024;  // Bytes requested per read()
+    static constexpr size_t MAX_FRAME_SIZE = 4096;        // Larger frames are dropped as overflows
+    static constexpr size_t MAX_TX_QUEUE = 1024 * 1024;   // Bytes queued before publish() refuses
+
+    // payload points into the receive buffer and is only valid during the call
+    using RawCallback = std::function<void(uint8_t channel, const uint8_t *payload, size_t size)>;
+    using Callback = std::function<void(const JsonDocument &doc)>;
+
+    struct Stats
+    {
+        uint64_t rxBytes;
+        uint64_t rxFrames;
+        uint64_t txBytes;
+        uint64_t txFrames;
+        uint64_t cobsErrors;
+        uint64_t crcErrors;
+        uint64_t shortFrames;
+        uint64_t decodeErrors;
+        uint64_t overflows;
+        uint64_t txDropped;
+    };
+
+    SerialLink();
+    ~SerialLink();
+    SerialLink(const SerialLink &) = delete;
+    SerialLink &operator=(const SerialLink &) = delete;
+
+    // Opens a serial device in raw mode. Anything that is not a tty (pipes,
+    // sockets) is used as is, baud is then ignored.
+    bool open(const std::string &path, uint32_t baud);
+    // Takes ownership of an already open descriptor
+    bool attach(int fd);
+    void close();
+    bool isOpen() const { return _fd >= 0; }
+    int fd() const { return _fd; }
+    const std::string &lastError() const { return _lastError; }
+
+    // One subscriber per channel, like SerialIO on the device. Raw subscribers
+    // get the MsgPack payload without a JsonDocument being built.
+    void subscribe(uint8_t channel, Callback cb);
+    void subscribeRaw(uint8_t channel, RawCallback cb);
+    void unsubscribe(uint8_t channel);
+
+    // Typed subscribe for the messages in messages.h, frames that do not
+    // parse as T are counted as decode errors
+    template <typename T>
+    void subscribe(uint8_t channel, std::function<void(const T &)> cb)
+    {
+        subscribe(channel, [this, cb](const JsonDocument &doc)
+                  {
+                      T msg;
+                      if (fromJson(doc.as<JsonVariantConst>(), msg))
+                          cb(msg);
+                      else
+                          _decodeErrors++; });
+    }
+
+    // Thread safe, the frame is written immediately when the descriptor accepts
+    // it and queued otherwise. Returns false when the queue is full.
+    bool publish(uint8_t channel, const JsonDocument &doc);
+    bool publishRaw(uint8_t channel, const uint8_t *payload, size_t size);
+
+    template <typename T>
+    bool publish(uint8_t channel, const T &msg)
+    {
+        JsonDocument doc;
+        toJson(msg, doc);
+        return publish(channel, doc);
+    }
+
+    // Waits up to timeoutMs (-1 forever) for I/O and dispatches every complete
+    // frame. Returns the number of frames dispatched, -1 on error.
+    int poll(int timeoutMs);
+    // Polls until stop() is called from any thread or the link fails
+    void run();
+    void stop();
+
+    // Records every frame slice received and every frame published, including
+    // the ones that fail to decode. Set before polling, nullptr stops recording.
+    void setCapture(CaptureWriter *capture) { _capture = capture; }
+
+    Stats stats() const;
+    void resetStats();
+
+private:
+    bool setupEpoll();
+    void setError(const char *what);
+    bool readAvailable(int &frames);
+    size_t sliceFrames(size_t scanFrom);
+    bool dispatch(uint8_t *frame, size_t size);
+    bool flushTxLocked();
+    void updateWriteInterest(bool wanted);
+
+    int _fd = -1;
+    int _epoll = -1;
+    int _wake = -1;
+    std::string _lastError;
+    std::atomic<bool> _stop{false};
+    CaptureWriter *_capture = nullptr;
+
+    RawCallback _raw[256];
+    Callback _json[256];
+    JsonDocument _doc; // Reused for every frame, subscribers must not keep it
+
+    // Receive side, bytes [0, _rxUsed) are the unterminated tail of the stream
+    std::vector<uint8_t> _rx;
+    size_t _rxUsed = 0;
+    bool _discarding = false; // Inside an oversized frame, skip to the next delimiter
+
+    // Transmit side
+    std::mutex _txMutex;
+    std::vector<uint8_t> _tx;
+    size_t _txSent = 0;
+    bool _writeArmed = false;
+
+    std::atomic<uint64_t> _rxBytes{0};
+    std::atomic<uint64_t> _rxFrames{0};
+    std::atomic<uint64_t> _txBytes{0};
+    std::atomic<uint64_t> _txFrames{0};
+    std::atomic<uint64_t> _cobsErrors{0};
+    std::atomic<uint64_t> _crcErrors{0};
+    std::atomic<uint64_t> _shortFrames{0};
+    std::atomic<uint64_t> _decodeErrors{0};
+    std::atomic<uint64_t> _overflows{0};
+    std::atomic<uint64_t> _txDropped{0};
+};
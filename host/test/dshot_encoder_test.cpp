@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include "motor_control/dshot_encoder.h"
+
+TEST(DShotEncoder, CrcOfReferenceFrame)
+{
+    // Throttle 1046 without telemetry is 0x82C6 on the wire
+    EXPECT_EQ(DShotEncoder::makeFrame(1046, false), 0x82C6);
+    EXPECT_EQ(DShotEncoder::crc(1046 << 1), 0x6);
+}
+
+TEST(DShotEncoder, TelemetryBitChangesCrc)
+{
+    uint16_t frame = DShotEncoder::makeFrame(1046, true);
+    EXPECT_EQ(frame >> 5, 1046);
+    EXPECT_EQ((frame >> 4) & 1, 1);
+    EXPECT_EQ(frame & 0x0F, DShotEncoder::crc((1046 << 1) | 1));
+}
+
+TEST(DShotEncoder, CrcMatchesNibbleXorForEveryValue)
+{
+    for (uint16_t value = 0; value <= DShotEncoder::MAX_VALUE; ++value)
+    {
+        uint16_t frame = DShotEncoder::makeFrame(value, false);
+        uint16_t x = frame ^ (frame >> 4) ^ (frame >> 8) ^ (frame >> 12);
+        EXPECT_EQ(x & 0x0F, 0) << "value " << value;
+    }
+}
+
+TEST(DShotEncoder, ValueIsClamped)
+{
+    EXPECT_EQ(DShotEncoder::makeFrame(5000, false), DShotEncoder::makeFrame(DShotEncoder::MAX_VALUE, false));
+}
+
+TEST(DShotEncoder, UnidirectionalThrottle)
+{
+    EXPECT_EQ(DShotEncoder::throttleToValue(0.0f, false), 0);
+    EXPECT_EQ(DShotEncoder::throttleToValue(-0.5f, false), 0);
+    EXPECT_EQ(DShotEncoder::throttleToValue(1.0f, false), DShotEncoder::MAX_VALUE);
+    EXPECT_EQ(DShotEncoder::throttleToValue(2.0f, false), DShotEncoder::MAX_VALUE);
+    EXPECT_EQ(DShotEncoder::throttleToValue(0.5f, false), 1048);
+    EXPECT_EQ(DShotEncoder::throttleToValue(1e-4f, false), DShotEncoder::MIN_THROTTLE);
+}
+
+TEST(DShotEncoder, ThreeDThrottleMapping)
+{
+    // Neutral is disarmed, reverse is 48-1047 and forward 1048-2047
+    EXPECT_EQ(DShotEncoder::throttleToValue(0.0f, true), 0);
+    EXPECT_EQ(DShotEncoder::throttleToValue(1e-4f, true), DShotEncoder::NEUTRAL_3D);
+    EXPECT_EQ(DShotEncoder::throttleToValue(1.0f, true), DShotEncoder::MAX_VALUE);
+    EXPECT_EQ(DShotEncoder::throttleToValue(-1e-4f, true), DShotEncoder::MIN_THROTTLE);
+    EXPECT_EQ(DShotEncoder::throttleToValue(-1.0f, true), DShotEncoder::NEUTRAL_3D - 1);
+    EXPECT_EQ(DShotEncoder::throttleToValue(-3.0f, true), DShotEncoder::NEUTRAL_3D - 1);
+
+    // Both directions increase with speed and never overlap
+    uint16_t previousForward = DShotEncoder::NEUTRAL_3D;
+    uint16_t previousReverse = DShotEncoder::MIN_THROTTLE;
+    for (int i = 1; i <= 100; ++i)
+    {
+        uint16_t forward = DShotEncoder::throttleToValue(i / 100.0f, true);
+        uint16_t reverse = DShotEncoder::throttleToValue(-i / 100.0f, true);
+        EXPECT_GE(forward, previousForward);
+        EXPECT_GE(reverse, previousReverse);
+        EXPECT_LT(reverse, DShotEncoder::NEUTRAL_3D);
+        previousForward = forward;
+        previousReverse = reverse;
+    }
+}
+
+TEST(DShotEncoder, BitTimings)
+{
+    // 25 ns RMT ticks as configured by DSHOT_RMT_CLK_DIV
+    const uint32_t tickHz = 40000000;
+
+    DShotEncoder::Timing dshot600 = DShotEncoder::timing(600, tickHz);
+    EXPECT_EQ(dshot600.bit, 67);  // 1.67 us
+    EXPECT_EQ(dshot600.t0h, 25);  // 0.625 us
+    EXPECT_EQ(dshot600.t1h, 50);  // 1.25 us
+
+    DShotEncoder::Timing dshot300 = DShotEncoder::timing(300, tickHz);
+    EXPECT_EQ(dshot300.bit, 133);
+    EXPECT_EQ(dshot300.t0h, 50);
+    EXPECT_EQ(dshot300.t1h, 100);
+
+    DShotEncoder::Timing dshot150 = DShotEncoder::timing(150, tickHz);
+    EXPECT_EQ(dshot150.bit, 267);
+    EXPECT_EQ(dshot150.t0h, 100);
+    EXPECT_EQ(dshot150.t1h, 200);
+}
+
+TEST(DShotEncoder, EncodeSendsMsbFirst)
+{
+    DShotEncoder::Timing timing = DShotEncoder::timing(600, 40000000);
+    DShotEncoder::Symbol symbols[DShotEncoder::FRAME_BITS];
+    uint16_t frame = 0x82C6;
+    DShotEncoder::encode(frame, timing, symbols);
+    for (size_t i = 0; i < DShotEncoder::FRAME_BITS; ++i)
+    {
+        bool one = (frame >> (15 - i)) & 1;
+        EXPECT_EQ(symbols[i].high, one ? timing.t1h : timing.t0h) << "bit " << i;
+        EXPECT_EQ(symbols[i].high + symbols[i].low, timing.bit) << "bit " << i;
+    }
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include "orientation/mahony_ahrs.h"
+
+static const float G = 9.80665f;
+static const float DT = 0.01f; // AHRS_SAMPLE_RATE_HZ
+
+// Accelerometer reading of a vehicle at rest with the given roll and pitch
+static void gravity(float roll, float pitch, float &ax, float &ay, float &az)
+{
+    ax = -G * sinf(pitch);
+    ay = G * sinf(roll) * cosf(pitch);
+    az = G * cosf(roll) * cosf(pitch);
+}
+
+static void run(MahonyAHRS &ahrs, float seconds, float gx, float gy, float gz, float ax, float ay, float az)
+{
+    int steps = static_cast<int>(seconds / DT);
+    for (int i = 0; i < steps; ++i)
+    {
+        ahrs.update(gx, gy, gz, ax, ay, az, DT);
+    }
+}
+
+TEST(MahonyAHRS, AlignsToGravityOnFirstSample)
+{
+    MahonyAHRS ahrs;
+    float ax, ay, az;
+    gravity(0.3f, -0.2f, ax, ay, az);
+    EXPECT_FALSE(ahrs.isInitialized());
+    ahrs.update(0.0f, 0.0f, 0.0f, ax, ay, az, DT);
+    EXPECT_TRUE(ahrs.isInitialized());
+
+    MahonyAHRS::Euler e = ahrs.getEuler();
+    EXPECT_NEAR(e.roll, 0.3f, 1e-4f);
+    EXPECT_NEAR(e.pitch, -0.2f, 1e-4f);
+    EXPECT_NEAR(e.yaw, 0.0f, 1e-4f);
+}
+
+TEST(MahonyAHRS, ConvergesToNewTilt)
+{
+    MahonyAHRS ahrs;
+    run(ahrs, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, G);
+
+    // The vehicle was tilted while the gyro missed it, the accelerometer pulls the estimate over
+    float ax, ay, az;
+    gravity(0.4f, 0.25f, ax, ay, az);
+    run(ahrs, 10.0f, 0.0f, 0.0f, 0.0f, ax, ay, az);
+
+    MahonyAHRS::Euler e = ahrs.getEuler();
+    EXPECT_NEAR(e.roll, 0.4f, 0.01f);
+    EXPECT_NEAR(e.pitch, 0.25f, 0.01f);
+
+    MahonyAHRS::Quaternion q = ahrs.getQuaternion();
+    EXPECT_NEAR(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z, 1.0f, 1e-5f);
+}
+
+TEST(MahonyAHRS, EstimatesGyroBias)
+{
+    MahonyAHRS ahrs;
+    run(ahrs, 120.0f, 0.02f, -0.01f, 0.0f, 0.0f, 0.0f, G);
+
+    MahonyAHRS::Vector3 bias = ahrs.getGyroBias();
+    EXPECT_NEAR(bias.x, 0.02f, 0.002f);
+    EXPECT_NEAR(bias.y, -0.01f, 0.002f);
+
+    MahonyAHRS::Euler e = ahrs.getEuler();
+    EXPECT_NEAR(e.roll, 0.0f, 0.005f);
+    EXPECT_NEAR(e.pitch, 0.0f, 0.005f);
+}
+
+TEST(MahonyAHRS, IgnoresLinearAcceleration)
+{
+    MahonyAHRS ahrs;
+    run(ahrs, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, G);
+
+    // 1.5 g pointing 0.4 rad off vertical is acceleration, not tilt
+    float ax, ay, az;
+    gravity(0.4f, 0.0f, ax, ay, az);
+    run(ahrs, 1.0f, 0.0f, 0.0f, 0.0f, 1.5f * ax, 1.5f * ay, 1.5f * az);
+    EXPECT_NEAR(ahrs.getEuler().roll, 0.0f, 1e-4f);
+}
+
+TEST(MahonyAHRS, IntegratesYawRate)
+{
+    MahonyAHRS ahrs(2.0f, 0.0f);
+    run(ahrs, 0.01f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, G);
+    run(ahrs, 1.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, G);
+    EXPECT_NEAR(ahrs.getEuler().yaw, 0.5f, 0.01f);
+
+    ahrs.update(0.0f, 0.0f, 10.0f, 0.0f, 0.0f, G, 0.0f); // No time step, no change
+    EXPECT_NEAR(ahrs.getEuler().yaw, 0.5f, 0.01f);
+
+    ahrs.reset();
+    EXPECT_FALSE(ahrs.isInitialized());
+    EXPECT_FLOAT_EQ(ahrs.getQuaternion().w, 1.0f);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <math.h>
+#include "control/pid_controller.h"
+
+static PidController::Gains makeGains(float kp, float ki, float kd)
+{
+    PidController::Gains gains;
+    gains.kp = kp;
+    gains.ki = ki;
+    gains.kd = kd;
+    return gains;
+}
+
+TEST(PidController, DepthHoldRejectsBuoyancy)
+{
+    // Depth plant as seen by the hold controller: effort accelerates the vehicle against drag
+    // and a constant buoyancy that only the integral can cancel
+    PidController pid;
+    PidController::Gains gains = makeGains(0.8f, 0.3f, 1.0f);
+    gains.integralLimit = 0.5f;
+    pid.setGains(gains);
+
+    const float dt = 0.01f;
+    const float setpoint = 1.5f;
+    float depth = 0.0f;
+    float rate = 0.0f;
+    for (int step = 0; step < 6000; ++step)
+    {
+        float effort = pid.update(setpoint, depth, rate, dt);
+        float acceleration = 2.0f * effort - 1.5f * rate - 0.2f;
+        rate += acceleration * dt;
+        depth += rate * dt;
+    }
+    EXPECT_NEAR(depth, setpoint, 0.01f);
+    EXPECT_NEAR(rate, 0.0f, 0.01f);
+    EXPECT_NEAR(pid.getIntegral(), 0.1f, 0.01f); // Holds the buoyancy
+    EXPECT_FALSE(pid.isSaturated());
+}
+
+TEST(PidController, IntegratorStopsWhileSaturated)
+{
+    PidController pid;
+    pid.setGains(makeGains(0.5f, 1.0f, 0.0f));
+
+    // Unreachable setpoint, the measurement never moves
+    float output = 0.0f;
+    for (int step = 0; step < 1000; ++step)
+    {
+        output = pid.update(1.0f, 0.0f, 0.0f, 0.01f);
+    }
+    EXPECT_NEAR(output, 1.0f, 0.01f);
+    EXPECT_LE(pid.getIntegral(), 0.5f + 0.01f); // Only what was needed to reach the limit
+
+    // Without windup the output leaves saturation as soon as the error reverses
+    output = pid.update(-1.0f, 0.0f, 0.0f, 0.01f);
+    EXPECT_LT(output, 0.05f);
+    EXPECT_FALSE(pid.isSaturated());
+}
+
+TEST(PidController, IntegratorUnwindsWhileSaturated)
+{
+    PidController pid;
+    pid.setGains(makeGains(0.0f, 1.0f, 0.0f));
+    for (int step = 0; step < 50; ++step)
+    {
+        pid.update(1.0f, 0.0f, 0.0f, 0.01f);
+    }
+    float wound = pid.getIntegral();
+
+    // Saturated high with a negative error: integrating is allowed since it leaves saturation
+    PidController::Gains gains = pid.getGains();
+    gains.kff = 1.0f;
+    pid.setGains(gains);
+    pid.update(-1.0f, 0.0f, 0.0f, 0.01f, 5.0f);
+    EXPECT_LT(pid.getIntegral(), wound);
+}
+
+TEST(PidController, IntegralLimit)
+{
+    PidController pid;
+    PidController::Gains gains = makeGains(0.0f, 10.0f, 0.0f);
+    gains.integralLimit = 0.2f;
+    gains.outputMax = 10.0f;
+    pid.setGains(gains);
+    for (int step = 0; step < 100; ++step)
+    {
+        pid.update(1.0f, 0.0f, 0.0f, 0.01f);
+    }
+    EXPECT_FLOAT_EQ(pid.getIntegral(), 0.2f);
+
+    // Lowering the limit clamps the stored integral, reset clears it
+    gains.integralLimit = -0.1f;
+    pid.setGains(gains);
+    EXPECT_FLOAT_EQ(pid.getGains().integralLimit, 0.1f);
+    EXPECT_FLOAT_EQ(pid.getIntegral(), 0.1f);
+    pid.reset();
+    EXPECT_FLOAT_EQ(pid.getIntegral(), 0.0f);
+}
+
+TEST(PidController, DerivativeIgnoresSetpointSteps)
+{
+    PidController pid;
+    pid.setGains(makeGains(0.5f, 0.0f, 2.0f));
+    EXPECT_FLOAT_EQ(pid.update(0.0f, 0.0f, 0.0f, 0.01f), 0.0f);
+    EXPECT_FLOAT_EQ(pid.update(1.0f, 0.0f, 0.0f, 0.01f), 0.5f); // No kick from the step
+    EXPECT_FLOAT_EQ(pid.update(1.0f, 0.0f, 0.1f, 0.01f), 0.3f); // Damps the measured rate
+}
+
+TEST(PidController, HeadingTakesTheShortWay)
+{
+    PidController pid(true);
+    pid.setGains(makeGains(1.0f, 0.0f, 0.0f));
+    pid.update(3.1f, -3.1f, 0.0f, 0.01f);
+    EXPECT_NEAR(pid.getError(), 6.2f - 2.0f * (float)M_PI, 1e-4f);
+
+    EXPECT_NEAR(PidController::wrapPi(3.0f * (float)M_PI), -(float)M_PI, 1e-4f);
+    EXPECT_NEAR(PidController::wrapPi(-0.5f), -0.5f, 1e-6f);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "settings/settings_store.h"
+#include "settings/file_settings_backend.h"
+
+static int applied[4];
+
+static void countApply(size_t id)
+{
+    ++applied[id];
+}
+
+enum : size_t
+{
+    I2C_HZ,
+    LOG_LVL,
+    AHRS_EN,
+    SLEW
+};
+
+static const SettingsStore::Descriptor TABLE[] = {
+    {"i2c_hz", SettingsStore::Type::U32, 400000, 10000, 1000000, countApply},
+    {"log_lvl", SettingsStore::Type::U32, 3, 0, 5, countApply},
+    {"ahrs_en", SettingsStore::Type::Bool, true, 0, 1, countApply},
+    {"slew", SettingsStore::Type::Float, 2.5f, 0, 1000, countApply},
+};
+
+class SettingsStoreTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path = ::testing::TempDir() + "settings_store_test.txt";
+        std::remove(path.c_str());
+        for (int &count : applied)
+        {
+            count = 0;
+        }
+    }
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string readFile() const
+    {
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    std::string path;
+};
+
+TEST_F(SettingsStoreTest, StartsAtDefaults)
+{
+    SettingsStore store(TABLE, 4);
+    EXPECT_EQ(store.getU32(I2C_HZ), 400000u);
+    EXPECT_EQ(store.getU32(LOG_LVL), 3u);
+    EXPECT_TRUE(store.getBool(AHRS_EN));
+    EXPECT_FLOAT_EQ(store.getFloat(SLEW), 2.5f);
+
+    size_t id;
+    EXPECT_TRUE(store.find("slew", id));
+    EXPECT_EQ(id, SLEW);
+    EXPECT_FALSE(store.find("missing", id));
+}
+
+TEST_F(SettingsStoreTest, SetValidatesAndApplies)
+{
+    SettingsStore store(TABLE, 4);
+    EXPECT_FALSE(store.set(LOG_LVL, 6.0f));   // Above max
+    EXPECT_FALSE(store.set(LOG_LVL, 2.5f));   // Fraction for an integer
+    EXPECT_FALSE(store.set(SLEW, -1.0f));     // Below min
+    EXPECT_FALSE(store.set(SLEW, NAN));
+    EXPECT_EQ(applied[LOG_LVL], 0);
+
+    EXPECT_TRUE(store.set(LOG_LVL, 5.0f));
+    EXPECT_EQ(store.getU32(LOG_LVL), 5u);
+    EXPECT_EQ(applied[LOG_LVL], 1);
+    EXPECT_TRUE(store.set(LOG_LVL, 5.0f)); // Unchanged, not applied again
+    EXPECT_EQ(applied[LOG_LVL], 1);
+
+    store.reset();
+    EXPECT_EQ(store.getU32(LOG_LVL), 3u);
+    EXPECT_EQ(applied[LOG_LVL], 2);
+    EXPECT_EQ(applied[SLEW], 1);
+}
+
+TEST_F(SettingsStoreTest, PersistenceRoundTrip)
+{
+    {
+        SettingsStore store(TABLE, 4);
+        ASSERT_TRUE(store.set(I2C_HZ, 100000.0f));
+        ASSERT_TRUE(store.set(AHRS_EN, 0.0f));
+        ASSERT_TRUE(store.set(SLEW, 0.75f));
+        FileSettingsBackend backend(path);
+        ASSERT_TRUE(store.save(backend));
+    }
+
+    // Values at their default are not written
+    EXPECT_EQ(readFile().find("log_lvl"), std::string::npos);
+
+    SettingsStore restored(TABLE, 4);
+    FileSettingsBackend backend(path);
+    EXPECT_EQ(restored.load(backend), 3u);
+    EXPECT_EQ(restored.getU32(I2C_HZ), 100000u);
+    EXPECT_FALSE(restored.getBool(AHRS_EN));
+    EXPECT_FLOAT_EQ(restored.getFloat(SLEW), 0.75f);
+    EXPECT_EQ(restored.getU32(LOG_LVL), 3u);
+    EXPECT_EQ(applied[I2C_HZ], 1); // Loading does not apply, applyAll does
+}
+
+TEST_F(SettingsStoreTest, SavingDefaultsErasesKeys)
+{
+    SettingsStore store(TABLE, 4);
+    FileSettingsBackend backend(path);
+    ASSERT_TRUE(store.set(LOG_LVL, 1.0f));
+    ASSERT_TRUE(store.save(backend));
+    EXPECT_NE(readFile().find("log_lvl 1"), std::string::npos);
+
+    store.reset();
+    ASSERT_TRUE(store.save(backend));
+    EXPECT_EQ(readFile(), "");
+}
+
+TEST_F(SettingsStoreTest, LoadRejectsOutOfRangeValues)
+{
+    {
+        std::ofstream file(path);
+        file << "log_lvl 9\ni2c_hz 200000\nunknown 4\n";
+    }
+    SettingsStore store(TABLE, 4);
+    FileSettingsBackend backend(path);
+    EXPECT_EQ(store.load(backend), 1u);
+    EXPECT_EQ(store.getU32(LOG_LVL), 3u);
+    EXPECT_EQ(store.getU32(I2C_HZ), 200000u);
+}
+
+TEST_F(SettingsStoreTest, MissingFileRestoresNothing)
+{
+    SettingsStore store(TABLE, 4);
+    FileSettingsBackend backend(path);
+    EXPECT_EQ(store.load(backend), 0u);
+    EXPECT_EQ(store.getU32(I2C_HZ), 400000u);
+}
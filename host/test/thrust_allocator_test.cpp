@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "control/thrust_allocator.h"
+
+enum Axis
+{
+    FX,
+    FY,
+    FZ,
+    TX,
+    TY,
+    TZ
+};
+
+// Two thrusters side by side pushing forward, yaw from the difference
+class ThrustAllocatorTest : public ::testing::Test
+{
+protected:
+    ThrustAllocatorTest() : allocator(2)
+    {
+        const float left[ThrustAllocator::DOF] = {0.5f, 0, 0, 0, 0, 0.5f};
+        const float right[ThrustAllocator::DOF] = {0.5f, 0, 0, 0, 0, -0.5f};
+        allocator.setRow(0, left);
+        allocator.setRow(1, right);
+
+        ThrustAllocator::Curve curve;
+        curve.maxForward = 10.0f;
+        curve.maxReverse = 10.0f;
+        allocator.setCurve(0, curve);
+        allocator.setCurve(1, curve);
+    }
+
+    void setPriorities(uint8_t surge, uint8_t yaw)
+    {
+        uint8_t priorities[ThrustAllocator::DOF] = {0, 0, 0, 0, 0, 0};
+        priorities[FX] = surge;
+        priorities[TZ] = yaw;
+        allocator.setPriorities(priorities);
+    }
+
+    ThrustAllocator allocator;
+    float throttles[2];
+    ThrustAllocator::Result result;
+};
+
+TEST_F(ThrustAllocatorTest, DeliversAWrenchWithinLimits)
+{
+    const float wrench[ThrustAllocator::DOF] = {4.0f, 0, 0, 0, 0, 2.0f};
+    allocator.allocate(wrench, throttles, &result);
+    EXPECT_FLOAT_EQ(throttles[0], 0.3f);
+    EXPECT_FLOAT_EQ(throttles[1], 0.1f);
+    EXPECT_FALSE(result.saturated);
+    for (float scale : result.scale)
+    {
+        EXPECT_FLOAT_EQ(scale, 1.0f);
+    }
+}
+
+TEST_F(ThrustAllocatorTest, HigherPriorityAxisIsKeptWhenSaturated)
+{
+    setPriorities(1, 0); // Yaw before surge
+    const float wrench[ThrustAllocator::DOF] = {30.0f, 0, 0, 0, 0, 10.0f};
+    allocator.allocate(wrench, throttles, &result);
+
+    // Yaw takes +-5 N, surge gets what is left before the left thruster hits 10 N
+    EXPECT_TRUE(result.saturated);
+    EXPECT_FLOAT_EQ(result.scale[TZ], 1.0f);
+    EXPECT_NEAR(result.scale[FX], 1.0f / 3.0f, 1e-6f);
+    EXPECT_FLOAT_EQ(throttles[0], 1.0f);
+    EXPECT_NEAR(throttles[1], 0.0f, 1e-6f);
+}
+
+TEST_F(ThrustAllocatorTest, SamePriorityAxesScaleTogether)
+{
+    setPriorities(0, 0);
+    const float wrench[ThrustAllocator::DOF] = {30.0f, 0, 0, 0, 0, 10.0f};
+    allocator.allocate(wrench, throttles, &result);
+
+    // Scaling the group keeps the direction of the wrench
+    EXPECT_TRUE(result.saturated);
+    EXPECT_FLOAT_EQ(result.scale[FX], 0.5f);
+    EXPECT_FLOAT_EQ(result.scale[TZ], 0.5f);
+    EXPECT_FLOAT_EQ(throttles[0], 1.0f);
+    EXPECT_FLOAT_EQ(throttles[1], 0.5f);
+}
+
+TEST_F(ThrustAllocatorTest, ReverseLimitSaturates)
+{
+    ThrustAllocator::Curve weakReverse;
+    weakReverse.maxForward = 10.0f;
+    weakReverse.maxReverse = 4.0f;
+    allocator.setCurve(1, weakReverse);
+    setPriorities(0, 0);
+
+    const float wrench[ThrustAllocator::DOF] = {0, 0, 0, 0, 0, 16.0f};
+    allocator.allocate(wrench, throttles, &result);
+    EXPECT_FLOAT_EQ(result.scale[TZ], 0.5f);
+    EXPECT_FLOAT_EQ(throttles[0], 0.4f);
+    EXPECT_FLOAT_EQ(throttles[1], -1.0f);
+}
+
+TEST_F(ThrustAllocatorTest, UnreachableLowerPriorityGetsNothing)
+{
+    setPriorities(1, 0);
+    const float wrench[ThrustAllocator::DOF] = {10.0f, 0, 0, 0, 0, 40.0f};
+    allocator.allocate(wrench, throttles, &result);
+    EXPECT_FLOAT_EQ(result.scale[TZ], 0.5f);
+    EXPECT_FLOAT_EQ(result.scale[FX], 0.0f);
+    EXPECT_FLOAT_EQ(throttles[0], 1.0f);
+    EXPECT_FLOAT_EQ(throttles[1], -1.0f);
+}
+
+TEST(ThrustAllocator, CurveLinearization)
+{
+    ThrustAllocator::Curve curve;
+    curve.maxForward = 10.0f;
+    curve.maxReverse = 5.0f;
+    curve.exponent = 2.0f;
+    EXPECT_FLOAT_EQ(ThrustAllocator::thrustToThrottle(2.5f, curve), 0.5f);
+    EXPECT_FLOAT_EQ(ThrustAllocator::thrustToThrottle(-1.25f, curve), -0.5f);
+    EXPECT_FLOAT_EQ(ThrustAllocator::thrustToThrottle(20.0f, curve), 1.0f);
+    EXPECT_FLOAT_EQ(ThrustAllocator::thrustToThrottle(-20.0f, curve), -1.0f);
+    EXPECT_FLOAT_EQ(ThrustAllocator::thrustToThrottle(0.0f, curve), 0.0f);
+}
+
+TEST(ThrustAllocator, RejectsInvalidConfiguration)
+{
+    ThrustAllocator allocator(40);
+    EXPECT_EQ(allocator.getThrusterCount(), ThrustAllocator::MAX_THRUSTERS);
+
+    const float row[ThrustAllocator::DOF] = {1, 0, 0, 0, 0, 0};
+    EXPECT_FALSE(allocator.setRow(ThrustAllocator::MAX_THRUSTERS, row));
+
+    ThrustAllocator::Curve curve;
+    curve.exponent = 0.0f;
+    EXPECT_FALSE(ThrustAllocator::isValid(curve));
+    EXPECT_FALSE(allocator.setCurve(0, curve));
+    curve.exponent = 1.5f;
+    curve.maxReverse = -1.0f;
+    EXPECT_FALSE(allocator.setCurve(0, curve));
+
+    ThrustAllocator::Curve kept;
+    allocator.getCurve(0, kept);
+    EXPECT_FLOAT_EQ(kept.maxReverse, 1.0f);
+}
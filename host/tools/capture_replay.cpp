@@ -0,0 +1,156 @@
+// Feeds a capture through the frame and MsgPack decoders and reports decode
+// throughput. Only time spent decoding is measured, so --realtime results are
+// comparable with the default as-fast-as-possible mode.
+//
+//   capture_replay session.bcap [--realtime] [--rx | --tx] [--loops N] [--json]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <ArduinoJson.h>
+#include "capture.h"
+#include "serial_coms/frame_codec.h"
+#include "serial_coms/msgpack_transcoder.h"
+
+namespace
+{
+    struct Totals
+    {
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        uint64_t ok = 0;
+        uint64_t cobsErrors = 0;
+        uint64_t crcErrors = 0;
+        uint64_t shortFrames = 0;
+        uint64_t decodeErrors = 0;
+        uint64_t frameNs = 0;   // COBS and CRC
+        uint64_t msgpackNs = 0; // MsgPack into a JsonDocument
+    };
+
+    uint64_t elapsedNs(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    bool realtime = false;
+    bool json = false;
+    bool rx = true;
+    bool tx = true;
+    unsigned loops = 1;
+    bool usage = false;
+    for (int i = 1; i < argc && !usage; ++i)
+    {
+        if (strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (strcmp(argv[i], "--rx") == 0)
+            tx = false;
+        else if (strcmp(argv[i], "--tx") == 0)
+            rx = false;
+        else if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc)
+            loops = strtoul(argv[++i], nullptr, 10);
+        else if (argv[i][0] != '-' && path == nullptr)
+            path = argv[i];
+        else
+            usage = true;
+    }
+    if (usage || path == nullptr)
+    {
+        fprintf(stderr, "usage: %s <capture> [--realtime] [--rx | --tx] [--loops N] [--json]\n", argv[0]);
+        return 2;
+    }
+
+    CaptureReader capture;
+    if (!capture.open(path))
+    {
+        fprintf(stderr, "%s\n", capture.lastError().c_str());
+        return 1;
+    }
+    if (capture.truncated())
+        fprintf(stderr, "warning: last record is incomplete and was skipped\n");
+
+    Totals totals;
+    std::vector<uint8_t> scratch(CaptureWriter::MAX_RECORD_SIZE);
+    JsonDocument doc;
+    for (unsigned loop = 0; loop < loops; ++loop)
+    {
+        auto replayStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < capture.size(); ++i)
+        {
+            CaptureRecord record = capture[i];
+            if (!(record.direction == CaptureDirection::Rx ? rx : tx))
+                continue;
+            if (realtime)
+                std::this_thread::sleep_until(replayStart + std::chrono::nanoseconds(record.timeNs));
+
+            // The mapping is read only and frames decode in place
+            memcpy(scratch.data(), record.data, record.size);
+            totals.frames++;
+            totals.bytes += record.size;
+
+            auto start = std::chrono::steady_clock::now();
+            frame_codec::Frame frame;
+            frame_codec::Status status = frame_codec::decode(scratch.data(), record.size, frame);
+            totals.frameNs += elapsedNs(start);
+            switch (status)
+            {
+            case frame_codec::Status::Ok:
+                break;
+            case frame_codec::Status::BadCobs:
+                totals.cobsErrors++;
+                continue;
+            case frame_codec::Status::BadCrc:
+                totals.crcErrors++;
+                continue;
+            case frame_codec::Status::TooShort:
+                totals.shortFrames++;
+                continue;
+            }
+
+            start = std::chrono::steady_clock::now();
+            bool decoded = decodeFromMsgPack(frame.payload, frame.size, doc);
+            totals.msgpackNs += elapsedNs(start);
+            if (decoded)
+                totals.ok++;
+            else
+                totals.decodeErrors++;
+        }
+    }
+
+    double totalNs = totals.frameNs + totals.msgpackNs;
+    double nsPerFrame = totals.frames ? totalNs / totals.frames : 0;
+    double framesPerSec = totalNs > 0 ? totals.frames * 1e9 / totalNs : 0;
+    double bytesPerSec = totalNs > 0 ? totals.bytes * 1e9 / totalNs : 0;
+
+    if (json)
+    {
+        printf("{\"records\":%zu,\"frames\":%llu,\"bytes\":%llu,\"ok\":%llu,\"cobs_errors\":%llu,\"crc_errors\":%llu,"
+               "\"short_frames\":%llu,\"decode_errors\":%llu,\"frame_ns\":%llu,\"msgpack_ns\":%llu,"
+               "\"ns_per_frame\":%.1f,\"frames_per_sec\":%.0f,\"bytes_per_sec\":%.0f}\n",
+               capture.size(), (unsigned long long)totals.frames, (unsigned long long)totals.bytes,
+               (unsigned long long)totals.ok, (unsigned long long)totals.cobsErrors,
+               (unsigned long long)totals.crcErrors, (unsigned long long)totals.shortFrames,
+               (unsigned long long)totals.decodeErrors, (unsigned long long)totals.frameNs,
+               (unsigned long long)totals.msgpackNs, nsPerFrame, framesPerSec, bytesPerSec);
+    }
+    else
+    {
+        printf("%llu frames (%llu ok, %llu cobs, %llu crc, %llu short, %llu msgpack errors), %llu bytes\n",
+               (unsigned long long)totals.frames, (unsigned long long)totals.ok,
+               (unsigned long long)totals.cobsErrors, (unsigned long long)totals.crcErrors,
+               (unsigned long long)totals.shortFrames, (unsigned long long)totals.decodeErrors,
+               (unsigned long long)totals.bytes);
+        printf("%.1f ns/frame (framing %.1f, msgpack %.1f), %.0f frames/s, %.2f MB/s\n", nsPerFrame,
+               totals.frames ? (double)totals.frameNs / totals.frames : 0,
+               totals.frames ? (double)totals.msgpackNs / totals.frames : 0, framesPerSec, bytesPerSec / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Records all link traffic to a capture file until interrupted.
+//
+//   link_capture /dev/ttyUSB0 115200 session.bcap
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include "capture.h"
+#include "serial_link.h"
+
+static SerialLink *activeLink = nullptr;
+
+static void onSignal(int)
+{
+    if (activeLink != nullptr)
+        activeLink->stop();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: %s <device> <baud> <capture>\n", argv[0]);
+        return 2;
+    }
+
+    SerialLink link;
+    if (!link.open(argv[1], strtoul(argv[2], nullptr, 10)))
+    {
+        fprintf(stderr, "%s\n", link.lastError().c_str());
+        return 1;
+    }
+    CaptureWriter capture;
+    if (!capture.open(argv[3]))
+    {
+        fprintf(stderr, "%s\n", capture.lastError().c_str());
+        return 1;
+    }
+
+    link.setCapture(&capture);
+    activeLink = &link;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    link.run();
+    activeLink = nullptr;
+
+    capture.close();
+    SerialLink::Stats s = link.stats();
+    fprintf(stderr, "%llu records, %llu bytes received, %llu valid frames\n",
+            static_cast<unsigned long long>(capture.records()),
+            static_cast<unsigned long long>(s.rxBytes),
+            static_cast<unsigned long long>(s.rxFrames));
+    return 0;
+}
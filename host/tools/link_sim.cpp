@@ -0,0 +1,596 @@
+// Load test through a simulated serial link, no hardware needed.
+//
+//   load generator -- pty -- impaired link (both directions) -- pty -- device
+//
+// The device is a built-in emulator of the bridge's serial interface (command
+// replies on channel 254, telemetry on channels 2, 3, 4 and 9), a real board
+// with --device <tty>, or any program that opens the pty printed by
+// --device-pty. The generator sends pings with an id on channel 254 and motor
+// setpoints on channel 1 at the requested rates and reports goodput, framing
+// error rates and command latency percentiles.
+//
+//   link_sim --baud 921600 --ber 1e-5 --cmd-rate 200 --telemetry-rate 500 --duration 10
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <pty.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "link_impairment.h"
+#include "messages.h"
+#include "serial_link.h"
+
+namespace
+{
+    struct Options
+    {
+        ImpairmentConfig link;
+        double durationSec = 10;
+        double cmdRate = 50;        // Pings per second
+        double motorRate = 100;     // Motor setpoint frames per second
+        double telemetryRate = 100; // Emulator IMU and orientation frames per second, each
+        uint32_t quantumUs = 100;   // Forwarding granularity
+        const char *device = nullptr;
+        bool devicePty = false;
+        bool json = false;
+    };
+
+    uint64_t nowNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+    }
+
+    int msUntil(uint64_t deadlineNs)
+    {
+        uint64_t now = nowNs();
+        return deadlineNs > now ? static_cast<int>((deadlineNs - now + 999999) / 1000000) : 0;
+    }
+
+    struct Pty
+    {
+        int master = -1;
+        int slave = -1; // Kept open so the master never sees a hangup
+        std::string path;
+
+        bool open()
+        {
+            termios tio;
+            memset(&tio, 0, sizeof(tio));
+            cfmakeraw(&tio);
+            char name[128];
+            if (openpty(&master, &slave, name, &tio, nullptr) != 0)
+                return false;
+            path = name;
+            return true;
+        }
+
+        ~Pty()
+        {
+            if (master >= 0)
+                ::close(master);
+            if (slave >= 0)
+                ::close(slave);
+        }
+    };
+
+    // Moves bytes between the two endpoints through one LinkImpairment per
+    // direction. Bytes the receiving side does not take fast enough are
+    // dropped like a full UART receive buffer.
+    class Forwarder
+    {
+    public:
+        struct Direction
+        {
+            int from;
+            int to;
+            LinkImpairment link;
+            std::vector<uint8_t> pending;
+            uint64_t rxOverflow = 0;
+
+            Direction(int fromFd, int toFd, const ImpairmentConfig &config) : from(fromFd), to(toFd), link(config) {}
+        };
+
+        Forwarder(int hostFd, int deviceFd, const Options &options)
+            : _bufferSize(options.link.bufferSize), _quantumNs(options.quantumUs * 1000ull)
+        {
+            ImpairmentConfig down = options.link;
+            down.seed = options.link.seed * 2 + 1; // Independent errors per direction
+            _dirs.emplace_back(hostFd, deviceFd, options.link);
+            _dirs.emplace_back(deviceFd, hostFd, down);
+        }
+
+        bool start()
+        {
+            _epoll = epoll_create1(EPOLL_CLOEXEC);
+            _timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            _wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (_epoll < 0 || _timer < 0 || _wake < 0)
+                return false;
+            for (int fd : {_dirs[0].from, _dirs[1].from, _timer, _wake})
+            {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                epoll_event ev = {};
+                ev.events = EPOLLIN;
+                ev.data.fd = fd;
+                if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &ev) != 0)
+                    return false;
+            }
+            _thread = std::thread([this]()
+                                  { run(); });
+            return true;
+        }
+
+        void stop()
+        {
+            _stop = true;
+            uint64_t one = 1;
+            (void)!::write(_wake, &one, sizeof(one));
+            if (_thread.joinable())
+                _thread.join();
+            for (int fd : {_epoll, _timer, _wake})
+                ::close(fd);
+        }
+
+        // Only read after stop()
+        const Direction &upstream() const { return _dirs[0]; }
+        const Direction &downstream() const { return _dirs[1]; }
+
+    private:
+        void run()
+        {
+            std::vector<uint8_t> buffer(64 * 1024);
+            while (!_stop)
+            {
+                epoll_event events[4];
+                int n = epoll_wait(_epoll, events, 4, -1);
+                uint64_t now = nowNs();
+                for (int i = 0; i < n; ++i)
+                {
+                    int fd = events[i].data.fd;
+                    if (fd == _timer || fd == _wake)
+                    {
+                        uint64_t value;
+                        (void)!::read(fd, &value, sizeof(value));
+                        continue;
+                    }
+                    for (Direction &dir : _dirs)
+                    {
+                        if (dir.from != fd)
+                            continue;
+                        ssize_t got;
+                        while ((got = ::read(fd, buffer.data(), buffer.size())) > 0)
+                            dir.link.push(buffer.data(), got, now);
+                    }
+                }
+
+                uint64_t next = UINT64_MAX;
+                for (Direction &dir : _dirs)
+                {
+                    deliver(dir, now, buffer);
+                    next = std::min(next, dir.link.nextDeliveryNs());
+                    if (!dir.pending.empty())
+                        next = std::min(next, now + _quantumNs);
+                }
+                armTimer(next, now);
+            }
+        }
+
+        void deliver(Direction &dir, uint64_t now, std::vector<uint8_t> &buffer)
+        {
+            size_t count = dir.link.pull(now, buffer.data(), buffer.size());
+            size_t room = _bufferSize > dir.pending.size() ? _bufferSize - dir.pending.size() : 0;
+            if (count > room)
+            {
+                dir.rxOverflow += count - room;
+                count = room;
+            }
+            dir.pending.insert(dir.pending.end(), buffer.begin(), buffer.begin() + count);
+
+            if (dir.pending.empty())
+                return;
+            ssize_t written = ::write(dir.to, dir.pending.data(), dir.pending.size());
+            if (written > 0)
+                dir.pending.erase(dir.pending.begin(), dir.pending.begin() + written);
+        }
+
+        void armTimer(uint64_t deadlineNs, uint64_t now)
+        {
+            itimerspec spec = {};
+            if (deadlineNs != UINT64_MAX)
+            {
+                // Deliver in quanta instead of waking up for every byte
+                deadlineNs = std::max(deadlineNs, now + _quantumNs);
+                spec.it_value.tv_sec = deadlineNs / 1000000000ull;
+                spec.it_value.tv_nsec = deadlineNs % 1000000000ull;
+            }
+            timerfd_settime(_timer, TFD_TIMER_ABSTIME, &spec, nullptr);
+        }
+
+        std::vector<Direction> _dirs;
+        size_t _bufferSize;
+        uint64_t _quantumNs;
+        int _epoll = -1;
+        int _timer = -1;
+        int _wake = -1;
+        std::atomic<bool> _stop{false};
+        std::thread _thread;
+    };
+
+    // Stands in for the firmware's serial interface: replies to commands the
+    // way CommandRegistry does and streams telemetry
+    class DeviceEmulator
+    {
+    public:
+        bool start(const std::string &path, const Options &options)
+        {
+            if (!_link.open(path, options.link.baud))
+            {
+                fprintf(stderr, "%s\n", _link.lastError().c_str());
+                return false;
+            }
+            _startNs = nowNs();
+            _link.subscribe(CHANNEL_SIGNALING, [this](const JsonDocument &request)
+                            { onCommand(request); });
+            _link.subscribeRaw(CHANNEL_MOTORS, [this](uint8_t, const uint8_t *, size_t)
+                               { _motorFrames++; });
+            _periodNs = options.telemetryRate > 0 ? static_cast<uint64_t>(1e9 / options.telemetryRate) : 0;
+            _thread = std::thread([this]()
+                                  { run(); });
+            return true;
+        }
+
+        void stop()
+        {
+            _stop = true;
+            _link.stop();
+            if (_thread.joinable())
+                _thread.join();
+        }
+
+        SerialLink::Stats stats() const { return _link.stats(); }
+        uint64_t motorFrames() const { return _motorFrames; }
+
+    private:
+        void onCommand(const JsonDocument &request)
+        {
+            if (request["cmd"] != "ping" && request["cmd"] != 1)
+                return; // Unknown commands get no reply on the device either
+            JsonDocument response;
+            response["msg"] = "pong";
+            response["status"] = 200;
+            response["timestamp"] = (nowNs() - _startNs) / 1000000;
+            if (!request["id"].isNull())
+                response["id"] = request["id"];
+            _link.publish(CHANNEL_SIGNALING, response);
+        }
+
+        void run()
+        {
+            uint64_t next = nowNs();
+            uint32_t sample = 0;
+            while (!_stop)
+            {
+                int timeout = _periodNs ? msUntil(next) : -1;
+                if (_link.poll(timeout) < 0)
+                    break;
+                if (_periodNs == 0 || nowNs() < next)
+                    continue;
+                next += _periodNs;
+                publishTelemetry(sample++);
+            }
+        }
+
+        void publishTelemetry(uint32_t sample)
+        {
+            float t = sample * 0.01f;
+            JsonDocument doc;
+            doc["x"] = 0.04f + 0.01f * (sample % 7);
+            doc["y"] = -0.12f;
+            doc["z"] = 9.81f;
+            _link.publish(CHANNEL_ACCEL, doc);
+
+            doc.clear();
+            doc["x"] = 0.001f * (sample % 13);
+            doc["y"] = 0.002f;
+            doc["z"] = -0.003f;
+            _link.publish(CHANNEL_GYRO, doc);
+
+            doc.clear();
+            doc["w"] = 0.998f;
+            doc["x"] = 0.012f;
+            doc["y"] = -0.043f;
+            doc["z"] = 0.041f;
+            doc["r"] = 0.024f;
+            doc["p"] = -0.086f;
+            doc["h"] = t;
+            _link.publish(CHANNEL_ORIENTATION, doc);
+
+            if (sample % 10 == 0)
+            {
+                doc.clear();
+                doc["a"] = 0;
+                doc["t"] = 22.5f;
+                doc["h"] = 45.0f;
+                doc["p"] = 101325.0f;
+                _link.publish(CHANNEL_BME280, doc);
+            }
+        }
+
+        SerialLink _link;
+        std::thread _thread;
+        std::atomic<bool> _stop{false};
+        std::atomic<uint64_t> _motorFrames{0};
+        uint64_t _startNs = 0;
+        uint64_t _periodNs = 0;
+    };
+
+    double percentile(std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+
+    double errorRate(const SerialLink::Stats &s)
+    {
+        uint64_t bad = s.cobsErrors + s.crcErrors + s.shortFrames + s.overflows;
+        return s.rxFrames + bad ? static_cast<double>(bad) / (s.rxFrames + bad) : 0;
+    }
+
+    bool parseOptions(int argc, char **argv, Options &o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (arg == "--device-pty")
+                o.devicePty = true;
+            else if (arg == "--json")
+                o.json = true;
+            else if (value == nullptr)
+                return false;
+            else if (++i, arg == "--baud")
+                o.link.baud = strtoul(value, nullptr, 10);
+            else if (arg == "--loss")
+                o.link.lossRate = atof(value);
+            else if (arg == "--ber")
+                o.link.bitErrorRate = atof(value);
+            else if (arg == "--burst-rate")
+                o.link.burstsPerSec = atof(value);
+            else if (arg == "--burst-len")
+                o.link.burstLength = strtoul(value, nullptr, 10);
+            else if (arg == "--buffer")
+                o.link.bufferSize = strtoul(value, nullptr, 10);
+            else if (arg == "--seed")
+                o.link.seed = strtoul(value, nullptr, 10);
+            else if (arg == "--duration")
+                o.durationSec = atof(value);
+            else if (arg == "--cmd-rate")
+                o.cmdRate = atof(value);
+            else if (arg == "--motor-rate")
+                o.motorRate = atof(value);
+            else if (arg == "--telemetry-rate")
+                o.telemetryRate = atof(value);
+            else if (arg == "--quantum-us")
+                o.quantumUs = strtoul(value, nullptr, 10);
+            else if (arg == "--device")
+                o.device = value;
+            else
+                return false;
+        }
+        return o.link.baud > 0 && o.link.bufferSize > 0;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr,
+                "usage: %s [--baud B] [--loss P] [--ber P] [--burst-rate N/s] [--burst-len bytes] [--buffer bytes]\n"
+                "          [--seed N] [--duration s] [--cmd-rate N/s] [--motor-rate N/s] [--telemetry-rate N/s]\n"
+                "          [--quantum-us us] [--device <tty> | --device-pty] [--json]\n",
+                argv[0]);
+        return 2;
+    }
+
+    Pty hostPty;
+    Pty devicePty;
+    if (!hostPty.open())
+    {
+        perror("openpty");
+        return 1;
+    }
+
+    int deviceFd = -1;
+    DeviceEmulator emulator;
+    bool emulated = options.device == nullptr && !options.devicePty;
+    if (options.device != nullptr)
+    {
+        std::string error;
+        deviceFd = openSerialPort(options.device, options.link.baud, error);
+        if (deviceFd < 0)
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    else
+    {
+        if (!devicePty.open())
+        {
+            perror("openpty");
+            return 1;
+        }
+        deviceFd = devicePty.master;
+        if (options.devicePty)
+        {
+            fprintf(stderr, "Device side: %s, press enter once the device is connected\n", devicePty.path.c_str());
+            getchar();
+        }
+    }
+
+    Forwarder forwarder(hostPty.master, deviceFd, options);
+    if (!forwarder.start())
+    {
+        perror("forwarder");
+        return 1;
+    }
+    if (emulated && !emulator.start(devicePty.path, options))
+        return 1;
+
+    SerialLink host;
+    if (!host.open(hostPty.path, options.link.baud))
+    {
+        fprintf(stderr, "%s\n", host.lastError().c_str());
+        return 1;
+    }
+
+    // Pings carry an id that the device echoes in its reply
+    std::unordered_map<uint32_t, uint64_t> outstanding;
+    std::vector<double> latenciesMs;
+    uint64_t payloadBytes = 0;
+    host.subscribe(CHANNEL_SIGNALING, [&](const JsonDocument &reply)
+                   {
+                       if (reply["id"].isNull())
+                           return;
+                       auto it = outstanding.find(reply["id"].as<uint32_t>());
+                       if (it == outstanding.end())
+                           return;
+                       latenciesMs.push_back((nowNs() - it->second) / 1e6);
+                       outstanding.erase(it); });
+    for (int channel = 0; channel < 256; ++channel)
+    {
+        host.subscribeRaw(channel, [&payloadBytes](uint8_t, const uint8_t *, size_t size)
+                          { payloadBytes += size; });
+    }
+
+    uint64_t start = nowNs();
+    uint64_t end = start + static_cast<uint64_t>(options.durationSec * 1e9);
+    uint64_t cmdPeriod = options.cmdRate > 0 ? static_cast<uint64_t>(1e9 / options.cmdRate) : 0;
+    uint64_t motorPeriod = options.motorRate > 0 ? static_cast<uint64_t>(1e9 / options.motorRate) : 0;
+    uint64_t nextCmd = start;
+    uint64_t nextMotor = start;
+    uint32_t commandsSent = 0;
+    uint32_t motorsSent = 0;
+    MotorCommand motors;
+
+    for (uint64_t now = start; now < end; now = nowNs())
+    {
+        if (cmdPeriod && now >= nextCmd)
+        {
+            JsonDocument request;
+            request["cmd"] = 1; // ping
+            request["id"] = commandsSent;
+            outstanding[commandsSent++] = now;
+            host.publish(CHANNEL_SIGNALING, request);
+            nextCmd += cmdPeriod;
+        }
+        if (motorPeriod && now >= nextMotor)
+        {
+            for (uint8_t i = 0; i < 8; ++i)
+                motors.setpoints[i] = 0.1f * ((motorsSent + i) % 10) - 0.5f;
+            host.publish(CHANNEL_MOTORS, motors);
+            motorsSent++;
+            nextMotor += motorPeriod;
+        }
+
+        uint64_t next = end;
+        if (cmdPeriod)
+            next = std::min(next, nextCmd);
+        if (motorPeriod)
+            next = std::min(next, nextMotor);
+        if (host.poll(msUntil(next)) < 0)
+        {
+            fprintf(stderr, "%s\n", host.lastError().c_str());
+            break;
+        }
+    }
+
+    // Let replies that are still on the wire arrive
+    uint64_t drainEnd = nowNs() + 500000000ull;
+    while (!outstanding.empty() && nowNs() < drainEnd)
+        host.poll(msUntil(drainEnd));
+    double elapsed = (nowNs() - start) / 1e9;
+
+    if (emulated)
+        emulator.stop();
+    forwarder.stop();
+
+    SerialLink::Stats down = host.stats();
+    SerialLink::Stats up = emulated ? emulator.stats() : SerialLink::Stats{};
+    std::sort(latenciesMs.begin(), latenciesMs.end());
+    const LinkImpairment::Stats &upLink = forwarder.upstream().link.stats();
+    const LinkImpairment::Stats &downLink = forwarder.downstream().link.stats();
+    double capacity = options.link.baud / 10.0;
+
+    if (options.json)
+    {
+        printf("{\"baud\":%u,\"duration_s\":%.3f,\"capacity_bytes_per_sec\":%.0f,"
+               "\"down\":{\"frames\":%llu,\"goodput_bytes_per_sec\":%.0f,\"wire_bytes_per_sec\":%.0f,"
+               "\"crc_errors\":%llu,\"cobs_errors\":%llu,\"short_frames\":%llu,\"overflows\":%llu,\"error_rate\":%.6f,"
+               "\"lost_bytes\":%llu,\"bit_flips\":%llu,\"bursts\":%llu,\"dropped_bytes\":%llu},"
+               "\"up\":{\"frames\":%llu,\"motor_frames\":%llu,\"crc_errors\":%llu,\"cobs_errors\":%llu,\"error_rate\":%.6f,"
+               "\"lost_bytes\":%llu,\"bit_flips\":%llu,\"bursts\":%llu,\"dropped_bytes\":%llu},"
+               "\"commands\":{\"sent\":%u,\"answered\":%zu,\"lost\":%zu,"
+               "\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}}\n",
+               options.link.baud, elapsed, capacity,
+               (unsigned long long)down.rxFrames, payloadBytes / elapsed, down.rxBytes / elapsed,
+               (unsigned long long)down.crcErrors, (unsigned long long)down.cobsErrors,
+               (unsigned long long)down.shortFrames, (unsigned long long)down.overflows, errorRate(down),
+               (unsigned long long)downLink.lost, (unsigned long long)downLink.bitFlips,
+               (unsigned long long)downLink.bursts,
+               (unsigned long long)(downLink.overflowed + forwarder.downstream().rxOverflow),
+               (unsigned long long)up.rxFrames, (unsigned long long)(emulated ? emulator.motorFrames() : 0),
+               (unsigned long long)up.crcErrors, (unsigned long long)up.cobsErrors, errorRate(up),
+               (unsigned long long)upLink.lost, (unsigned long long)upLink.bitFlips,
+               (unsigned long long)upLink.bursts,
+               (unsigned long long)(upLink.overflowed + forwarder.upstream().rxOverflow),
+               commandsSent, latenciesMs.size(), outstanding.size(),
+               percentile(latenciesMs, 0.5), percentile(latenciesMs, 0.9), percentile(latenciesMs, 0.99),
+               latenciesMs.empty() ? 0 : latenciesMs.back());
+        return 0;
+    }
+
+    printf("Link %u baud (%.0f B/s), %.1f s\n", options.link.baud, capacity, elapsed);
+    printf("Device to host: %llu frames, goodput %.0f B/s, wire %.0f B/s (%.1f%% of capacity)\n",
+           (unsigned long long)down.rxFrames, payloadBytes / elapsed, down.rxBytes / elapsed,
+           100.0 * down.rxBytes / elapsed / capacity);
+    printf("  errors: %llu crc, %llu cobs, %llu short, %llu overflow (%.4f%% of frames)\n",
+           (unsigned long long)down.crcErrors, (unsigned long long)down.cobsErrors,
+           (unsigned long long)down.shortFrames, (unsigned long long)down.overflows, 100 * errorRate(down));
+    printf("  link: %llu bytes lost, %llu bits flipped, %llu bursts, %llu bytes dropped on full buffers\n",
+           (unsigned long long)downLink.lost, (unsigned long long)downLink.bitFlips,
+           (unsigned long long)downLink.bursts,
+           (unsigned long long)(downLink.overflowed + forwarder.downstream().rxOverflow));
+    if (emulated)
+    {
+        printf("Host to device: %llu frames (%llu of %u motor frames), %llu crc, %llu cobs (%.4f%% of frames)\n",
+               (unsigned long long)up.rxFrames, (unsigned long long)emulator.motorFrames(), motorsSent,
+               (unsigned long long)up.crcErrors, (unsigned long long)up.cobsErrors, 100 * errorRate(up));
+    }
+    printf("  link: %llu bytes lost, %llu bits flipped, %llu bursts, %llu bytes dropped on full buffers\n",
+           (unsigned long long)upLink.lost, (unsigned long long)upLink.bitFlips, (unsigned long long)upLink.bursts,
+           (unsigned long long)(upLink.overflowed + forwarder.upstream().rxOverflow));
+    printf("Commands: %u sent, %zu answered, %zu lost, latency p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           commandsSent, latenciesMs.size(), outstanding.size(), percentile(latenciesMs, 0.5),
+           percentile(latenciesMs, 0.9), percentile(latenciesMs, 0.99), latenciesMs.empty() ? 0 : latenciesMs.back());
+    return 0;
+}
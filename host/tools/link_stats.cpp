@@ -0,0 +1,60 @@
+// Prints per-channel frame rates and link errors once a second.
+//
+//   link_stats /dev/ttyUSB0 115200
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include "serial_link.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <device> [baud]\n", argv[0]);
+        return 2;
+    }
+
+    SerialLink link;
+    if (!link.open(argv[1], argc > 2 ? strtoul(argv[2], nullptr, 10) : 115200))
+    {
+        fprintf(stderr, "%s\n", link.lastError().c_str());
+        return 1;
+    }
+
+    uint64_t counts[256] = {};
+    for (int channel = 0; channel < 256; ++channel)
+    {
+        link.subscribeRaw(channel, [&counts](uint8_t ch, const uint8_t *, size_t)
+                          { counts[ch]++; });
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto next = Clock::now() + std::chrono::seconds(1);
+    for (;;)
+    {
+        int timeout = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+        if (link.poll(timeout > 0 ? timeout : 0) < 0)
+        {
+            fprintf(stderr, "%s\n", link.lastError().c_str());
+            return 1;
+        }
+        if (Clock::now() < next)
+            continue;
+        next += std::chrono::seconds(1);
+
+        SerialLink::Stats s = link.stats();
+        printf("%" PRIu64 " B/s %" PRIu64 " frames/s cobs %" PRIu64 " crc %" PRIu64 " short %" PRIu64 " overflow %" PRIu64 " |",
+               s.rxBytes, s.rxFrames, s.cobsErrors, s.crcErrors, s.shortFrames, s.overflows);
+        for (int channel = 0; channel < 256; ++channel)
+        {
+            if (counts[channel])
+                printf(" %d:%" PRIu64, channel, counts[channel]);
+            counts[channel] = 0;
+        }
+        printf("\n");
+        fflush(stdout);
+        link.resetStats();
+    }
+}
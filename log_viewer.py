@@ -0,0 +1,74 @@
+import argparse
+import re
+import struct
+import time
+
+import serial
+import seaport as sp
+
+# Deferred log records arrive on channel 10 as {"l": [[timestamp_us, id, args...], ...], "d": dropped}.
+# The format strings are fetched once from the device with the get_log_formats command.
+LOG_CHANNEL = 10
+SIGNALING_CHANNEL = 254
+
+SPEC = re.compile(r"%[-+ #0-9.]*([a-zA-Z%])")
+
+formats = []
+
+
+def format_record(fmt, args):
+    values = []
+    words = iter(args)
+    for conversion in SPEC.findall(fmt):
+        if conversion == "%":
+            continue
+        word = next(words, 0)
+        if conversion in "feEgG":
+            values.append(struct.unpack("<f", struct.pack("<I", word & 0xFFFFFFFF))[0])
+        elif conversion in "di":
+            values.append(struct.unpack("<i", struct.pack("<I", word & 0xFFFFFFFF))[0])
+        else:
+            values.append(word)
+    try:
+        return fmt % tuple(values)
+    except (TypeError, ValueError):
+        return f"{fmt} {args}"
+
+
+def signaling_received(data):
+    global formats
+    if "f" in data:
+        formats = data["f"]
+        print(f"Loaded {len(formats)} log formats")
+
+
+def log_received(data):
+    if data.get("d"):
+        print(f"[device] {data['d']} log records dropped")
+    for record in data.get("l", []):
+        timestamp, log_id, args = record[0], record[1], record[2:]
+        fmt = formats[log_id] if log_id < len(formats) else f"<unknown id {log_id}>"
+        print(f"{timestamp / 1e6:12.6f} {format_record(fmt, args)}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Formats deferred log records from the ESP32 Bridge")
+    parser.add_argument("serial_port", help="Serial port to open (e.g., /dev/ttyUSB0 or COM3)")
+    parser.add_argument("baudrate", type=int, help="Baud rate (e.g., 115200)")
+    args = parser.parse_args()
+
+    ser = serial.Serial(args.serial_port, args.baudrate, timeout=1)
+    seaport = sp.SeaPort(ser)
+    seaport.subscribe(SIGNALING_CHANNEL, signaling_received)
+    seaport.subscribe(LOG_CHANNEL, log_received)
+    seaport.start()
+
+    seaport.publish(SIGNALING_CHANNEL, {"cmd": "get_log_formats"})
+
+    print("Press Ctrl+C to exit")
+    while True:
+        time.sleep(0.1)
+
+
+if __name__ == "__main__":
+    main()
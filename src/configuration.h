@@ -13,9 +13,30 @@ extern WebSerial webSerial; // Forward declaration for WebSerial
 #define CRC8_POLY 0x07
 #define CRC8_INIT_VALUE 0x00
 
+// Published telemetry is kept in a per channel history so the host can backfill gaps after a
+// link dropout. Boards with PSRAM can afford a much larger HISTORY_DEPTH.
+#define HISTORY_CHANNELS {2, 3, 4, 5, 6, 7, 9} // Channels that are retained
+#define HISTORY_NUM_CHANNELS 7                 // Number of entries in HISTORY_CHANNELS
+#define HISTORY_DEPTH 64                       // Frames retained per channel
+#define HISTORY_SLOT_SIZE 66                   // Channel 9 payload (50 bytes) plus "sq" and "tm" (16 bytes)
+#define HISTORY_CHANNEL 11                     // Channel used to stream replayed frames back
+#define HISTORY_REPLAY_QUEUE_SIZE 4            // Pending replay requests
+#define HISTORY_REPLAY_BURST 8                 // Frames replayed before yielding for a tick
+#define HISTORY_TASK_STACK_SIZE 4096           // Stack size for the replay task
+#define HISTORY_TASK_PRIORITY 0                // Priority for the replay task, below live telemetry
+
 /*********************
  * ESC CONFIGURATION *
  *********************/
+#define ESC_PROTOCOL_PWM 0                        // Standard 1-2 ms servo pulses through LEDC
+#define ESC_PROTOCOL_ONESHOT125 1                 // 125-250 us pulses through LEDC
+#define ESC_PROTOCOL_ONESHOT42 2                  // 42-84 us pulses through LEDC
+#define ESC_PROTOCOL_MULTISHOT 3                  // 5-25 us pulses through LEDC
+#define ESC_PROTOCOL_DSHOT150 150                 // DShot frames through RMT, value is the bit rate in kbit/s
+#define ESC_PROTOCOL_DSHOT300 300
+#define ESC_PROTOCOL_DSHOT600 600
+#define ESC_PROTOCOL ESC_PROTOCOL_PWM             // Output protocol used for every ESC
+#define ESC_PROTOCOL_IS_DSHOT (ESC_PROTOCOL == ESC_PROTOCOL_DSHOT150 || ESC_PROTOCOL == ESC_PROTOCOL_DSHOT300 || ESC_PROTOCOL == ESC_PROTOCOL_DSHOT600)
 #define NUM_ESC 8                                 // Number of ESCs
 #define ESC_PINS {13, 12, 14, 15, 16, 17, 18, 19} // ESC control pins
 #define ESC_PWM_FREQUENCY 400                     // PWM frequency in Hz
@@ -25,8 +46,42 @@ extern WebSerial webSerial; // Forward declaration for WebSerial
 #define ESC_MID 1500                              // Neutral throttle (μs)
 #define ESC_MIN 1100                              // Maximum reverse throttle (μs)
 #define USE_DUTY_US false                         // Use duty cycle in microseconds for ESC control
-#define SAFETY_TIMEOUT 5.0                        // Safety timeout in seconds for ESCs to reset to neutral if no commands are received
+#define SAFETY_TIMEOUT_MS 5000                    // Per-ESC failsafe timeout, the ESC falls back if it receives no command for this long (0 disables)
+#define FAILSAFE_CHANNEL 12                       // Channel used to report failsafe events
 #define INVERTING_OPTOCOUPLER true                // we can invert the signal if we have an optocoupler that inverts the output
+#define ESC_ONESHOT_SYNC false                    // One-shot modes: restart the period on every update so the new pulse starts right away
+#define ESC_ONESHOT_UPDATE_RATE_HZ 1000           // One-shot modes: setpoint updates per second
+#define DSHOT_FRAME_RATE_HZ 1000                  // DShot frames sent per second to every ESC
+#define DSHOT_RMT_CLK_DIV 2                       // RMT tick of 25 ns with the 80 MHz APB clock
+#define DSHOT_RMT_CHANNEL_BASE 1                  // First RMT channel used for DShot, channel 0 is left to the status LEDs
+#define DSHOT_MAX_ESC 7                           // The ESP32 has 8 RMT channels, DShot builds need NUM_ESC <= 7
+#if ESC_PROTOCOL_IS_DSHOT
+#define MOTOR_PROFILE_RATE_HZ DSHOT_FRAME_RATE_HZ // Thrust profile update rate, one step per DShot frame
+#elif ESC_PROTOCOL != ESC_PROTOCOL_PWM
+#define MOTOR_PROFILE_RATE_HZ ESC_ONESHOT_UPDATE_RATE_HZ // Thrust profile update rate for the one-shot modes
+#else
+#define MOTOR_PROFILE_RATE_HZ ESC_PWM_FREQUENCY   // Thrust profile update rate, one step per PWM frame
+#endif
+// Thruster allocation turns a body wrench received on WRENCH_CHANNEL into ESC throttles. The matrix
+// is the pseudo-inverse of the thruster geometry, one row per ESC mapping (Fx, Fy, Fz in N and
+// Tx, Ty, Tz in Nm, x forward, y starboard, z down) to thrust in N. The default is for four
+// vectored horizontal thrusters (ESC 0-3) and four vertical ones (ESC 4-7).
+#define WRENCH_CHANNEL 14                         // Channel for wrench commands
+#define ALLOCATION_MATRIX {                      \
+    {0.3536f, 0.3536f, 0.0f, 0.0f, 0.0f, 1.4142f},   \
+    {0.3536f, -0.3536f, 0.0f, 0.0f, 0.0f, -1.4142f}, \
+    {-0.3536f, -0.3536f, 0.0f, 0.0f, 0.0f, 1.4142f}, \
+    {-0.3536f, 0.3536f, 0.0f, 0.0f, 0.0f, -1.4142f}, \
+    {0.0f, 0.0f, 0.25f, 1.25f, -1.25f, 0.0f},        \
+    {0.0f, 0.0f, 0.25f, -1.25f, -1.25f, 0.0f},       \
+    {0.0f, 0.0f, 0.25f, 1.25f, 1.25f, 0.0f},         \
+    {0.0f, 0.0f, 0.25f, -1.25f, 1.25f, 0.0f}}
+#define ALLOCATION_PRIORITIES {2, 2, 0, 0, 0, 1}  // Per wrench axis, lower is allocated first: depth and attitude, then yaw, then translation
+#define THRUSTER_MAX_FORWARD_N 40.0f              // Thrust at full forward throttle
+#define THRUSTER_MAX_REVERSE_N 30.0f              // Thrust at full reverse throttle
+#define THRUSTER_CURVE_EXPONENT 1.5f              // Thrust grows with throttle^exponent
+#define MOTOR_SLEW_LIMIT 4.0f                     // Default max throttle change per second (0 disables)
+#define MOTOR_ACCEL_LIMIT 0.0f                    // Default max throttle change per second squared (0 disables)
 
 /**********************
  * WIFI CONFIGURATION *
@@ -42,33 +97,91 @@ extern WebSerial webSerial; // Forward declaration for WebSerial
  * WEBSERIAL CONFIGURATION *
  ***************************/
 #define USE_WEBSERIAL false     // Enable/disable WebSerial debug
-#define LOG_LEVEL ESP_LOG_INFO // Default log level for WebSerial
+#define LOG_LEVEL ESP_LOG_INFO // Default level of the ESP log, WebSerial and the deferred log, see log_lvl
 
 #if !WIFI_ENABLED && USE_WEBSERIAL
 #error "WebSerial requires WiFi to be enabled. Please set WIFI_ENABLED to true."
 #endif
 
-// WebSerial logging macros
+// WebSerial logging macros, lines are info level and hidden when log_lvl is below ESP_LOG_INFO
 #if USE_WEBSERIAL
-#define LOG_WEBSERIALLN(msg) webSerial.println(msg)
-#define LOG_WEBSERIAL(msg) webSerial.print(msg)
+extern volatile uint8_t webSerialLevel; // Follows the log_lvl setting
+#define LOG_WEBSERIALLN(msg) ((webSerialLevel >= ESP_LOG_INFO) ? (void)webSerial.println(msg) : (void)0)
+#define LOG_WEBSERIAL(msg) ((webSerialLevel >= ESP_LOG_INFO) ? (void)webSerial.print(msg) : (void)0)
 #else
 #define LOG_WEBSERIALLN(msg) ((void)0)
 #define LOG_WEBSERIAL(msg) ((void)0)
 #endif
 
+/****************************
+ * BINARY LOG CONFIGURATION *
+ ****************************/
+// Deferred logging records a format id and raw arguments, the host does the formatting.
+// Format strings live in logging/log_formats.h. With WebSerial enabled records are
+// formatted on the device in the drain task instead of being sent over the link.
+#define BINARY_LOG_ENABLED true           // Enable/disable deferred logging
+#define BINARY_LOG_CAPACITY 128           // Number of records in the ring, must be a power of two
+#define BINARY_LOG_DRAIN_PERIOD_MS 50     // Interval between drains of the ring
+#define BINARY_LOG_BATCH_SIZE 16          // Maximum number of records per published frame
+#define BINARY_LOG_TASK_STACK_SIZE 4096   // Stack size for the drain task
+#define BINARY_LOG_TASK_PRIORITY 0        // Priority for the drain task, runs in idle time
+#define BINARY_LOG_CHANNEL 10             // Channel used to publish log records
+
+/*******************************
+ * LATENCY PROBE CONFIGURATION *
+ *******************************/
+#define LATENCY_PROBE_ENABLED true      // Trace motor commands from the UART to the PWM latch
+#define LATENCY_PROBE_CHANNEL 1         // Channel whose frames are traced
+#define LATENCY_HISTOGRAM_BUCKETS 24    // log2 buckets per stage, the last one collects everything above 2^22 us
+
+/******************************
+ * CPU PROFILER CONFIGURATION *
+ ******************************/
+// Needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS and CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID,
+// both are set in sdkconfig.defaults.
+#define CPU_PROFILE_STREAM false          // Publish the report every period, otherwise only on get_cpu
+#define CPU_PROFILE_PERIOD_MS 1000        // Default sampling period
+#define CPU_PROFILE_MIN_PERIOD_MS 100     // Shortest period accepted at runtime
+#define CPU_PROFILE_MAX_TASKS 32          // Tasks tracked, a sample is skipped when there are more
+#define CPU_PROFILE_CHANNEL 15            // Channel used to stream the report
+#define CPU_PROFILE_TASK_STACK_SIZE 4096  // Stack size for the profiler task
+#define CPU_PROFILE_TASK_PRIORITY 3       // Above the worker tasks so a busy core is still sampled
+#define CPU_PROFILE_TASK_CORE 0           // Core the profiler task is pinned to
+
+/************************************
+ * ALLOCATION TRACKER CONFIGURATION *
+ ************************************/
+// malloc, calloc, realloc and free are wrapped at link time (build_flags in platformio.ini).
+// Steady-state mode treats every allocation as a violation, see get_alloc in README.md.
+#define ALLOC_TRACKING_ENABLED true       // Count heap operations per task, the wrappers only forward when false
+#define ALLOC_TRACK_MAX_TASKS 32          // Tasks with their own counters, later ones share the "other" entry
+#define ALLOC_STEADY_STATE_AT_BOOT false  // Enter steady-state mode at the end of setup()
+#define ALLOC_STEADY_STATE_ASSERT false   // Abort on an allocation in steady-state mode instead of counting it
+
+/**************************
+ * SETTINGS CONFIGURATION *
+ **************************/
+// Several values in this file are only the defaults of runtime settings, src/settings/settings.cpp
+// lists them. Values saved with set_settings are restored from NVS at boot.
+#define SETTINGS_NVS_NAMESPACE "settings" // NVS namespace holding the saved settings
+
 /*********************
  * LED CONFIGURATION *
  *********************/
-#define NUM_LEDS 6         // Number of LEDs 6 on ESP32 Mobo
-#define LED_PIN 2          // GPIO pin for LED control
-#define LED_BRIGHTNESS 255 // Default (0-255) Brightness level
-#define LED_SPEED 500      // Default speed of LED patterns in milliseconds
+// The status LEDs are driven by the LED task only, other tasks post events (see tasks/led_control.h).
+#define NUM_LEDS 6                // Number of LEDs 6 on ESP32 Mobo
+#define LED_PIN 2                 // GPIO pin for LED control
+#define LED_RMT_CHANNEL 0         // RMT channel driving the LEDs
+#define LED_BRIGHTNESS 50         // Default (0-255) Brightness level
+#define LED_SPEED 500             // Default speed of LED patterns in milliseconds
+#define STATUS_LED_FPS 30         // Maximum LED refresh rate
+#define STATUS_FLASH_MS 50        // Length of the rx and tx flashes
+#define STATUS_HOLD_MS 2000       // How long errors and failsafe trips stay visible
+#define STATUS_LINK_TIMEOUT_MS 1000 // Link is shown as lost after this long without a received frame
 
 /**********************
  * RTOS CONFIGURATION *
  **********************/
-#define MOTOR_QUEUE_SIZE 10        // Motor control queue size
 #define MOTOR_TASK_STACK_SIZE 4096 // Stack size for motor control task
 #define MOTOR_TASK_PRIORITY 1      // Priority for motor control task
 
@@ -77,6 +190,7 @@ extern WebSerial webSerial; // Forward declaration for WebSerial
 #define SIGNALING_QUEUE_SIZE 10            // Signaling control queue size
 #define SIGNALING_TASK_STACK_SIZE 4096 * 2 // Stack size for signaling control task
 #define SIGNALING_TASK_PRIORITY 1          // Priority for signaling control task
+#define COMMAND_REGISTRY_SIZE 48           // Maximum number of registered channel 254 commands
 
 #define SERIAL_TASK_STACK_SIZE 4096 * 2 // Stack size for serial task
 #define SERIAL_TASK_PRIORITY 1          // Priority for serial task
@@ -86,6 +200,78 @@ extern WebSerial webSerial; // Forward declaration for WebSerial
  **********************/
 #define I2C_SPEED 100000 // I2C speed in Hz
 
+// Hot-plug discovery probes a few addresses at a time whenever the bus is idle so
+// boards that are reconnected or browned out are picked up without a reboot.
+#define DISCOVERY_PERIOD_MS 50          // Interval between incremental discovery steps
+#define DISCOVERY_ADDRESSES_PER_STEP 4  // Number of addresses probed per discovery step
+#define DISCOVERY_BACKOFF_BASE_MS 500   // Initial retry delay for a board that stopped responding
+#define DISCOVERY_BACKOFF_MAX_MS 60000  // Upper bound for the exponential retry delay
+#define DEVICE_FAILURE_THRESHOLD 3      // Consecutive failed transactions before a board is detached
+#define DISCOVERY_TASK_STACK_SIZE 4096  // Stack size for discovery task
+#define DISCOVERY_TASK_PRIORITY 1       // Priority for discovery task
+#define DEVICE_EVENT_CHANNEL 8          // Channel used to publish board attach/detach events
+
+// Board LEDs are written into a framebuffer per board and sent by the discovery task, so
+// the refresh rate is also bounded by DISCOVERY_PERIOD_MS.
+#define BOARD_LED_MAX 64                // LEDs kept per board, the rest of a longer strip is not addressable
+#define BOARD_LED_REFRESH_HZ 20         // Maximum updates per second sent to one board
+#define BOARD_LED_RANGE_WRITES true     // Boards support command 0x06 (LED range), otherwise one 0x05 per LED
+#define BOARD_LED_MAX_PER_WRITE 40      // LEDs per range transaction, 3 + 3 * 40 bytes fits the 128 byte Wire buffer
+#define BOARD_LED_MAX_FLUSHES 4         // Boards updated per discovery step
+
+/****************************
+ * ORIENTATION CONFIGURATION *
+ ****************************/
+// The orientation task owns the BMI088 and runs on core 0, away from the serial and sensor tasks.
+// The sample rate is bounded by I2C_SPEED, a full sensor read takes roughly 3 ms at 100 kHz.
+#define AHRS_ENABLED true              // Enable/disable on-device orientation estimation
+#define AHRS_SAMPLE_RATE_HZ 100        // Rate at which the IMU is read and the filter is updated
+#define AHRS_PUBLISH_PERIOD_MS 50      // Default period for publishing the orientation
+#define AHRS_KP 2.0f                   // Proportional gain towards the accelerometer
+#define AHRS_KI 0.05f                  // Integral gain, used for gyro bias estimation
+#define AHRS_TASK_STACK_SIZE 4096      // Stack size for orientation task
+#define AHRS_TASK_PRIORITY 2           // Priority for orientation task
+#define AHRS_TASK_CORE 0               // Core the orientation task is pinned to
+#define ORIENTATION_CHANNEL 9          // Channel used to publish the orientation
+
+/*********************************
+ * HOLD CONTROLLER CONFIGURATION *
+ *********************************/
+// Depth and heading hold closed on the device. Efforts in [-1, 1] are mixed onto the ESCs with
+// the weights below, positive heave pushes the vehicle deeper and positive yaw turns it towards
+// larger headings. Setpoints and gains are sent on HOLD_CHANNEL, see README.md.
+#define HOLD_RATE_HZ 100                   // Control loop rate, matches AHRS_SAMPLE_RATE_HZ
+#define HOLD_CHANNEL 13                    // Channel for setpoints, gains and controller state
+#define HOLD_PUBLISH_PERIOD_MS 200         // Period for publishing the controller state while engaged
+#define HOLD_OVERRIDE_MS 500               // A channel 1 command suspends the controller on that ESC for this long
+#define HOLD_DEPTH_ADDRESS 0               // Board whose pressure gives the depth (0 for the built-in sensor)
+#define HOLD_WATER_DENSITY 997.0f          // kg/m^3, 1025 for sea water
+#define HOLD_HEAVE_MIX {0, 0, 0, 0, 1, 1, 1, 1} // Weight of the heave effort per ESC
+#define HOLD_YAW_MIX {1, -1, 1, -1, 0, 0, 0, 0} // Weight of the yaw effort per ESC
+#define HOLD_TASK_STACK_SIZE 4096          // Stack size for the hold controller task
+#define HOLD_TASK_PRIORITY 2               // Priority for the hold controller task
+#define HOLD_TASK_CORE 1                   // Core the hold controller task is pinned to
+
+/*******************************
+ * STREAM FILTER CONFIGURATION *
+ *******************************/
+// Sensor streams pass through a filter stage before they are published. The host can pick
+// a filter and decimation per stream over channel 254, see README.md.
+#define FILTER_MAX_STREAMS 16          // Number of streams that can have a filter configured
+#define IMU_PUBLISH_DECIMATION 10      // Default IMU decimation, AHRS_SAMPLE_RATE_HZ / 10 publishes at 10 Hz
+#define BME280_SAMPLE_PERIOD_MS 100    // Acquisition period for the BME280 sensors
+#define ANALOG_SAMPLE_PERIOD_MS 100    // Acquisition period for the analog inputs
+#define DIGITAL_SAMPLE_PERIOD_MS 100   // Acquisition period for the digital inputs
+
+/***********************
+ * BME280 CONFIGURATION *
+ ***********************/
+// The built-in BME280 runs in forced mode, a conversion is triggered and the bus is released
+// while the sensor converts. Oversampling is 0 (skipped), 1, 2, 4, 8 or 16.
+#define BME280_OVERSAMPLING_TEMPERATURE 1 // Temperature oversampling
+#define BME280_OVERSAMPLING_PRESSURE 1    // Pressure oversampling
+#define BME280_OVERSAMPLING_HUMIDITY 1    // Humidity oversampling
+
 /*************************
  * GENERAL CONFIGURATION *
  *************************/
@@ -0,0 +1,249 @@
+#include "hold_controller.h"
+#include "device_bus/sensor_handler.h"
+#include "serial_coms/serial_io.h"
+#include "tasks/motor_control.h"
+
+extern SerialIO serialio;
+extern SensorHandler sensorHandler;
+
+HoldController holdController;
+
+static const float HEAVE_MIX[NUM_ESC] = HOLD_HEAVE_MIX;
+static const float YAW_MIX[NUM_ESC] = HOLD_YAW_MIX;
+
+// ESCs driven while the given axes are engaged
+static uint32_t mixMask(bool depthEnabled, bool headingEnabled)
+{
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        if ((depthEnabled && HEAVE_MIX[i] != 0.0f) || (headingEnabled && YAW_MIX[i] != 0.0f))
+        {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+void HoldController::begin()
+{
+    BaseType_t taskResult = xTaskCreatePinnedToCore(
+        taskWrapper,
+        "HoldControllerTask",
+        HOLD_TASK_STACK_SIZE,
+        this,
+        HOLD_TASK_PRIORITY,
+        NULL,
+        HOLD_TASK_CORE);
+    if (taskResult != pdPASS)
+    {
+        LOG_WEBSERIALLN("Failed to create hold controller task");
+    }
+}
+
+void HoldController::taskWrapper(void *parameter)
+{
+    HoldController *instance = static_cast<HoldController *>(parameter);
+    instance->task(parameter);
+}
+
+void HoldController::configureAxis(JsonObjectConst config, Axis &axis)
+{
+    PidController::Gains gains = axis.pid.getGains();
+    gains.kp = config["kp"] | gains.kp;
+    gains.ki = config["ki"] | gains.ki;
+    gains.kd = config["kd"] | gains.kd;
+    gains.kff = config["kf"] | gains.kff;
+    gains.integralLimit = config["il"] | gains.integralLimit;
+    axis.pid.setGains(gains);
+
+    axis.feedForward = config["ff"] | axis.feedForward;
+    if (config["sp"].is<float>())
+    {
+        axis.setpoint = config["sp"];
+        axis.holdCurrent = false;
+    }
+    if (config["en"].is<bool>())
+    {
+        bool enable = config["en"];
+        if (enable && !axis.enabled)
+        {
+            axis.pid.reset();
+            axis.holdCurrent = !config["sp"].is<float>(); // Engaging without a setpoint holds the current value
+        }
+        axis.enabled = enable;
+    }
+}
+
+void HoldController::handleCommand(const JsonDocument &doc)
+{
+    portENTER_CRITICAL(&mux);
+    if (doc["d"].is<JsonObjectConst>())
+    {
+        configureAxis(doc["d"], depthAxis);
+    }
+    if (doc["h"].is<JsonObjectConst>())
+    {
+        configureAxis(doc["h"], headingAxis);
+    }
+    uint32_t engaged = mixMask(depthAxis.enabled, headingAxis.enabled);
+    portEXIT_CRITICAL(&mux);
+
+    // Host commands on this channel are the keep-alive of the ESCs the controller drives, the
+    // loop itself never feeds the watchdog so a lost link still ends in the failsafe
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        if (engaged & (1u << i))
+        {
+            motorWatchdog.feed(i);
+        }
+    }
+
+    if (doc["zero"] | false)
+    {
+        zeroRequested = true; // The next pressure sample becomes the surface
+    }
+}
+
+bool HoldController::updateDepth(float &currentDepth, float &rate)
+{
+    float pressure;
+    uint32_t sampleMs;
+    if (!sensorHandler.getLatestPressure(pressure, sampleMs))
+    {
+        return false;
+    }
+
+    // Pressure arrives slower than the loop runs, only differentiate on new samples
+    if (sampleMs != lastPressureMs)
+    {
+        bool rezeroed = zeroRequested;
+        if (rezeroed)
+        {
+            surfacePressure = pressure;
+            zeroRequested = false;
+            depthRate = 0.0f;
+        }
+        float newDepth = (pressure - surfacePressure) / (HOLD_WATER_DENSITY * 9.80665f);
+        if (lastPressureMs != 0 && !rezeroed)
+        {
+            float dt = (sampleMs - lastPressureMs) / 1000.0f;
+            if (dt > 0.0f)
+            {
+                depthRate = 0.5f * depthRate + 0.5f * (newDepth - depth) / dt;
+            }
+        }
+        depth = newDepth;
+        lastPressureMs = sampleMs;
+    }
+    currentDepth = depth;
+    rate = depthRate;
+    return true;
+}
+
+void HoldController::stepAxis(Axis &axis, bool valid, float measurement, float rate, float dt)
+{
+    if (!axis.enabled || !valid)
+    {
+        axis.effort = 0.0f;
+        return;
+    }
+    axis.measurement = measurement;
+    if (axis.holdCurrent)
+    {
+        axis.setpoint = measurement;
+        axis.holdCurrent = false;
+    }
+    axis.effort = axis.pid.update(axis.setpoint, measurement, rate, dt, axis.feedForward);
+}
+
+void HoldController::applyEfforts(bool depthEnabled, float heave, bool headingEnabled, float yaw)
+{
+    uint32_t driven = 0;
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        float heaveWeight = depthEnabled ? HEAVE_MIX[i] : 0.0f;
+        float yawWeight = headingEnabled ? YAW_MIX[i] : 0.0f;
+        if (heaveWeight == 0.0f && yawWeight == 0.0f)
+        {
+            continue; // Not driven by an engaged axis, left to the host
+        }
+        driven |= 1u << i;
+        setMotorControlOutput(i, heaveWeight * heave + yawWeight * yaw);
+    }
+
+    // Stop the thrusters of an axis that was just disengaged
+    uint32_t released = drivenMask & ~driven;
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        if (released & (1u << i))
+        {
+            setMotorControlOutput(i, 0.0f);
+        }
+    }
+    drivenMask = driven;
+}
+
+void HoldController::publishState()
+{
+    JsonDocument doc;
+    doc["d"] = depthAxis.measurement;
+    doc["h"] = headingAxis.measurement;
+    doc["sd"] = depthAxis.setpoint;
+    doc["sh"] = headingAxis.setpoint;
+    doc["ud"] = depthAxis.effort;
+    doc["uh"] = headingAxis.effort;
+    doc["o"] = getMotorOverrideMask();
+    serialio.publish(HOLD_CHANNEL, doc);
+}
+
+void HoldController::task(void *parameter)
+{
+    const TickType_t period = pdMS_TO_TICKS(1000 / HOLD_RATE_HZ);
+    const float dt = 1.0f / HOLD_RATE_HZ;
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t lastPublish = 0;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&lastWake, period);
+
+        MahonyAHRS::Euler attitude;
+        float yawRate;
+        bool attitudeValid = sensorHandler.getLatestAttitude(attitude, yawRate);
+        float currentDepth = 0.0f;
+        float rate = 0.0f;
+        bool depthValid = updateDepth(currentDepth, rate);
+
+        // A failsafe trip on a driven ESC means the host went quiet, disengage instead of
+        // fighting the fallback value
+        bool tripped = (motorWatchdog.getTripped() & drivenMask) != 0;
+
+        portENTER_CRITICAL(&mux);
+        if (tripped)
+        {
+            depthAxis.enabled = false;
+            headingAxis.enabled = false;
+        }
+        stepAxis(depthAxis, depthValid, currentDepth, rate, dt);
+        stepAxis(headingAxis, attitudeValid, attitude.yaw, yawRate, dt);
+        bool depthEnabled = depthAxis.enabled;
+        bool headingEnabled = headingAxis.enabled;
+        float heave = depthAxis.effort;
+        float yaw = headingAxis.effort;
+        portEXIT_CRITICAL(&mux);
+
+        bool active = depthEnabled || headingEnabled;
+        if (active || drivenMask != 0)
+        {
+            applyEfforts(depthEnabled, heave, headingEnabled, yaw);
+        }
+
+        uint32_t now = millis();
+        if (active && now - lastPublish >= HOLD_PUBLISH_PERIOD_MS)
+        {
+            lastPublish = now;
+            publishState();
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+#include "pid_controller.h"
+
+// Fixed-rate depth and heading hold. Reads attitude and pressure straight from the sensor
+// handler caches, runs one PID per axis and mixes the efforts onto the ESCs through the motor
+// profiles. A host command on channel 1 takes over an ESC for HOLD_OVERRIDE_MS.
+class HoldController
+{
+public:
+    void begin();
+    void handleCommand(const JsonDocument &doc); // Setpoints and gains received on HOLD_CHANNEL
+
+private:
+    struct Axis
+    {
+        explicit Axis(bool wrapAngle) : pid(wrapAngle) {}
+
+        PidController pid;
+        bool enabled = false;
+        bool holdCurrent = false; // Take the next measurement as setpoint
+        float setpoint = 0.0f;
+        float feedForward = 0.0f;
+        float measurement = 0.0f;
+        float effort = 0.0f;
+    };
+
+    void configureAxis(JsonObjectConst config, Axis &axis);
+    bool updateDepth(float &depth, float &rate);
+    void stepAxis(Axis &axis, bool valid, float measurement, float rate, float dt);
+    void applyEfforts(bool depthEnabled, float heave, bool headingEnabled, float yaw);
+    void publishState();
+
+    void task(void *parameter);
+    static void taskWrapper(void *parameter);
+
+    Axis depthAxis{false};
+    Axis headingAxis{true};
+    uint32_t drivenMask = 0; // ESCs the controller drove on the previous step
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    float surfacePressure = 0.0f; // Pa, 0 until zeroed
+    volatile bool zeroRequested = true;
+    uint32_t lastPressureMs = 0;
+    float depth = 0.0f;
+    float depthRate = 0.0f;
+};
+
+extern HoldController holdController;
@@ -0,0 +1,63 @@
+#include "pid_controller.h"
+#include <math.h>
+
+static float clampf(float value, float lo, float hi)
+{
+    return value < lo ? lo : (value > hi ? hi : value);
+}
+
+float PidController::wrapPi(float angle)
+{
+    angle = fmodf(angle + (float)M_PI, 2.0f * (float)M_PI);
+    if (angle < 0.0f)
+    {
+        angle += 2.0f * (float)M_PI;
+    }
+    return angle - (float)M_PI;
+}
+
+void PidController::setGains(const Gains &newGains)
+{
+    gains = newGains;
+    if (gains.integralLimit < 0.0f)
+    {
+        gains.integralLimit = -gains.integralLimit;
+    }
+    integral = clampf(integral, -gains.integralLimit, gains.integralLimit);
+}
+
+void PidController::reset()
+{
+    integral = 0.0f;
+    error = 0.0f;
+    saturated = false;
+}
+
+float PidController::update(float setpoint, float measurement, float measurementRate, float dt, float feedForward)
+{
+    error = setpoint - measurement;
+    if (wrapAngle)
+    {
+        error = wrapPi(error);
+    }
+
+    float proportional = gains.kp * error;
+    float derivative = -gains.kd * measurementRate;
+    float forward = gains.kff * feedForward;
+
+    // Conditional integration: hold the integrator while the output is saturated and the
+    // error would push it further into saturation. The integral is kept in output units so
+    // a change of ki does not bump the output.
+    float candidate = clampf(integral + gains.ki * error * dt, -gains.integralLimit, gains.integralLimit);
+    float unsaturated = proportional + candidate + derivative + forward;
+    bool pushingHigh = unsaturated > gains.outputMax && error > 0.0f;
+    bool pushingLow = unsaturated < gains.outputMin && error < 0.0f;
+    if (dt > 0.0f && !pushingHigh && !pushingLow)
+    {
+        integral = candidate;
+    }
+
+    float output = proportional + integral + derivative + forward;
+    saturated = output > gains.outputMax || output < gains.outputMin;
+    return clampf(output, gains.outputMin, gains.outputMax);
+}
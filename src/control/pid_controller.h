@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+
+// PID with feed-forward, free of any hardware dependency so it can run in a host simulation.
+// The derivative acts on the measured rate rather than on the error, so setpoint steps do not
+// kick the output, and the integrator stops winding up while the output is saturated.
+class PidController
+{
+public:
+    struct Gains
+    {
+        float kp = 0.0f;
+        float ki = 0.0f;
+        float kd = 0.0f;
+        float kff = 0.0f;           // Scale applied to the feed-forward term
+        float integralLimit = 1.0f; // Bound on the integral contribution
+        float outputMin = -1.0f;
+        float outputMax = 1.0f;
+    };
+
+    explicit PidController(bool wrapAngle = false) : wrapAngle(wrapAngle) {}
+
+    void setGains(const Gains &newGains);
+    const Gains &getGains() const { return gains; }
+    void reset(); // Clear the integrator, e.g. when the loop is engaged
+
+    // measurementRate is the time derivative of the measurement, feedForward is in output units / kff
+    float update(float setpoint, float measurement, float measurementRate, float dt, float feedForward = 0.0f);
+
+    float getError() const { return error; }
+    float getIntegral() const { return integral; }
+    bool isSaturated() const { return saturated; }
+
+    static float wrapPi(float angle); // Map to [-pi, pi)
+
+private:
+    Gains gains;
+    bool wrapAngle; // Heading loops take the short way round
+    float integral = 0.0f;
+    float error = 0.0f;
+    bool saturated = false;
+};
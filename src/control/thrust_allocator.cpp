@@ -0,0 +1,178 @@
+#include "thrust_allocator.h"
+#include <math.h>
+
+constexpr size_t ThrustAllocator::DOF;
+constexpr size_t ThrustAllocator::MAX_THRUSTERS;
+
+ThrustAllocator::ThrustAllocator(size_t thrusters) : count(thrusters > MAX_THRUSTERS ? MAX_THRUSTERS : thrusters) {}
+
+bool ThrustAllocator::setRow(size_t thruster, const float (&row)[DOF])
+{
+    if (thruster >= count)
+    {
+        return false;
+    }
+    for (size_t j = 0; j < DOF; ++j)
+    {
+        matrix[thruster][j] = row[j];
+    }
+    return true;
+}
+
+bool ThrustAllocator::getRow(size_t thruster, float (&row)[DOF]) const
+{
+    if (thruster >= count)
+    {
+        return false;
+    }
+    for (size_t j = 0; j < DOF; ++j)
+    {
+        row[j] = matrix[thruster][j];
+    }
+    return true;
+}
+
+void ThrustAllocator::setPriorities(const uint8_t (&priorities)[DOF])
+{
+    for (size_t j = 0; j < DOF; ++j)
+    {
+        priority[j] = priorities[j];
+    }
+}
+
+void ThrustAllocator::getPriorities(uint8_t (&priorities)[DOF]) const
+{
+    for (size_t j = 0; j < DOF; ++j)
+    {
+        priorities[j] = priority[j];
+    }
+}
+
+bool ThrustAllocator::isValid(const Curve &curve)
+{
+    return curve.maxForward > 0.0f && curve.maxReverse > 0.0f && curve.exponent > 0.0f;
+}
+
+bool ThrustAllocator::setCurve(size_t thruster, const Curve &curve)
+{
+    if (thruster >= count || !isValid(curve))
+    {
+        return false;
+    }
+    curves[thruster] = curve;
+    return true;
+}
+
+bool ThrustAllocator::getCurve(size_t thruster, Curve &curve) const
+{
+    if (thruster >= count)
+    {
+        return false;
+    }
+    curve = curves[thruster];
+    return true;
+}
+
+float ThrustAllocator::thrustToThrottle(float thrust, const Curve &curve)
+{
+    // Invert thrust = max * |throttle|^exponent on each side of zero
+    if (thrust > 0.0f)
+    {
+        float ratio = thrust >= curve.maxForward ? 1.0f : thrust / curve.maxForward;
+        return powf(ratio, 1.0f / curve.exponent);
+    }
+    if (thrust < 0.0f)
+    {
+        float ratio = -thrust >= curve.maxReverse ? 1.0f : -thrust / curve.maxReverse;
+        return -powf(ratio, 1.0f / curve.exponent);
+    }
+    return 0.0f;
+}
+
+void ThrustAllocator::allocate(const float (&wrench)[DOF], float *throttles, Result *result) const
+{
+    float thrust[MAX_THRUSTERS] = {};
+    float delta[MAX_THRUSTERS];
+    bool done[DOF] = {};
+    bool saturated = false;
+    float scales[DOF];
+
+    for (size_t j = 0; j < DOF; ++j)
+    {
+        scales[j] = 1.0f;
+    }
+
+    for (size_t allocated = 0; allocated < DOF;)
+    {
+        // Next priority group still to allocate
+        uint8_t level = 0xFF;
+        for (size_t j = 0; j < DOF; ++j)
+        {
+            if (!done[j] && priority[j] < level)
+            {
+                level = priority[j];
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            delta[i] = 0.0f;
+            for (size_t j = 0; j < DOF; ++j)
+            {
+                if (!done[j] && priority[j] == level)
+                {
+                    delta[i] += matrix[i][j] * wrench[j];
+                }
+            }
+        }
+
+        // Largest fraction of this group that keeps every thruster within its limits, on top
+        // of what the higher priority groups already use
+        float alpha = 1.0f;
+        for (size_t i = 0; i < count; ++i)
+        {
+            float room;
+            if (delta[i] > 0.0f)
+            {
+                room = (curves[i].maxForward - thrust[i]) / delta[i];
+            }
+            else if (delta[i] < 0.0f)
+            {
+                room = (-curves[i].maxReverse - thrust[i]) / delta[i];
+            }
+            else
+            {
+                continue;
+            }
+            alpha = fminf(alpha, fmaxf(room, 0.0f));
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            thrust[i] += alpha * delta[i];
+        }
+        for (size_t j = 0; j < DOF; ++j)
+        {
+            if (!done[j] && priority[j] == level)
+            {
+                done[j] = true;
+                scales[j] = alpha;
+                ++allocated;
+            }
+        }
+        saturated |= alpha < 1.0f;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        throttles[i] = thrustToThrottle(thrust[i], curves[i]);
+    }
+    if (result != nullptr)
+    {
+        for (size_t j = 0; j < DOF; ++j)
+        {
+            result->scale[j] = scales[j];
+        }
+        result->saturated = saturated;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Maps a body wrench (Fx, Fy, Fz, Tx, Ty, Tz) onto thruster commands with a precomputed
+// allocation matrix (the pseudo-inverse of the thruster geometry). Wrench axes are allocated
+// in priority order, each group scaled down just enough to keep every thruster within its
+// thrust limits, and the resulting thrusts are linearized into throttles through a
+// per-thruster thrust curve. Plain C++ so it can be exercised on a host.
+class ThrustAllocator
+{
+public:
+    static constexpr size_t DOF = 6;
+    static constexpr size_t MAX_THRUSTERS = 16;
+
+    // Thrust at full throttle in each direction, and thrust ~ |throttle|^exponent in between
+    struct Curve
+    {
+        float maxForward = 1.0f;
+        float maxReverse = 1.0f;
+        float exponent = 1.0f;
+    };
+
+    struct Result
+    {
+        float scale[DOF]; // Fraction of each wrench axis that could be delivered
+        bool saturated;   // At least one axis was scaled down
+    };
+
+    explicit ThrustAllocator(size_t thrusters);
+
+    bool setRow(size_t thruster, const float (&row)[DOF]); // Row of the allocation matrix, N per unit wrench
+    bool getRow(size_t thruster, float (&row)[DOF]) const;
+    void setPriorities(const uint8_t (&priorities)[DOF]); // Lower values are allocated first
+    void getPriorities(uint8_t (&priorities)[DOF]) const;
+    bool setCurve(size_t thruster, const Curve &curve); // False for an invalid curve, see isValid
+    static bool isValid(const Curve &curve);            // Positive limits and exponent
+    bool getCurve(size_t thruster, Curve &curve) const;
+    size_t getThrusterCount() const { return count; }
+
+    // throttles receives one value in [-1, 1] per thruster
+    void allocate(const float (&wrench)[DOF], float *throttles, Result *result = nullptr) const;
+
+    static float thrustToThrottle(float thrust, const Curve &curve);
+
+private:
+    size_t count;
+    float matrix[MAX_THRUSTERS][DOF] = {};
+    uint8_t priority[DOF] = {};
+    Curve curves[MAX_THRUSTERS];
+};
@@ -0,0 +1,231 @@
+#include "bme280_burst.h"
+
+// Register map
+#define BME280_REG_CALIB_TP 0x88  // dig_T1 .. dig_P9, 24 bytes
+#define BME280_REG_CALIB_H1 0xA1  // dig_H1
+#define BME280_REG_CHIP_ID 0xD0
+#define BME280_REG_RESET 0xE0
+#define BME280_REG_CALIB_H2 0xE1  // dig_H2 .. dig_H6, 7 bytes
+#define BME280_REG_CTRL_HUM 0xF2
+#define BME280_REG_STATUS 0xF3
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_CONFIG 0xF5
+#define BME280_REG_DATA 0xF7      // press_msb .. hum_lsb, 8 bytes
+
+#define BME280_CHIP_ID 0x60
+#define BME280_RESET_WORD 0xB6
+#define BME280_MODE_FORCED 0x01
+
+bool Bme280Burst::begin(TwoWire &wire, uint8_t address, uint8_t osTemperature, uint8_t osPressure, uint8_t osHumidity)
+{
+    wire_ = &wire;
+    address_ = address;
+
+    uint8_t chipId = 0;
+    if (!readRegisters(BME280_REG_CHIP_ID, &chipId, 1) || chipId != BME280_CHIP_ID)
+    {
+        return false;
+    }
+
+    writeRegister(BME280_REG_RESET, BME280_RESET_WORD);
+    delay(2);
+
+    // Wait for the NVM calibration data to be copied after reset
+    uint8_t status = 0x01;
+    for (uint8_t i = 0; i < 10 && (status & 0x01); ++i)
+    {
+        delay(2);
+        if (!readRegisters(BME280_REG_STATUS, &status, 1))
+        {
+            return false;
+        }
+    }
+
+    if (!readCalibration())
+    {
+        return false;
+    }
+
+    // ctrl_hum only takes effect after a write to ctrl_meas, the sensor stays in sleep mode until triggered
+    ctrlMeas_ = (oversamplingCode(osTemperature) << 5) | (oversamplingCode(osPressure) << 2);
+    if (!writeRegister(BME280_REG_CTRL_HUM, oversamplingCode(osHumidity)) ||
+        !writeRegister(BME280_REG_CONFIG, 0x00) ||
+        !writeRegister(BME280_REG_CTRL_MEAS, ctrlMeas_))
+    {
+        return false;
+    }
+
+    // Maximum measurement time from the datasheet, in microseconds
+    uint32_t us = 1250;
+    if (osTemperature)
+    {
+        us += 2300 * osTemperature;
+    }
+    if (osPressure)
+    {
+        us += 2300 * osPressure + 575;
+    }
+    if (osHumidity)
+    {
+        us += 2300 * osHumidity + 575;
+    }
+    conversionTimeMs_ = (us + 999) / 1000;
+    return true;
+}
+
+bool Bme280Burst::triggerConversion()
+{
+    return wire_ != nullptr && writeRegister(BME280_REG_CTRL_MEAS, ctrlMeas_ | BME280_MODE_FORCED);
+}
+
+uint32_t Bme280Burst::conversionTimeMs() const
+{
+    return conversionTimeMs_;
+}
+
+bool Bme280Burst::read(Reading &reading)
+{
+    uint8_t data[8];
+    if (wire_ == nullptr || !readRegisters(BME280_REG_DATA, data, sizeof(data)))
+    {
+        return false;
+    }
+
+    int32_t adcP = ((int32_t)data[0] << 12) | ((int32_t)data[1] << 4) | (data[2] >> 4);
+    int32_t adcT = ((int32_t)data[3] << 12) | ((int32_t)data[4] << 4) | (data[5] >> 4);
+    int32_t adcH = ((int32_t)data[6] << 8) | data[7];
+
+    if (adcT == 0x80000)
+    {
+        return false; // Temperature is needed to compensate everything else
+    }
+
+    int32_t tFine;
+    reading.temperature = compensateTemperature(adcT, tFine) / 100.0f;
+    reading.pressure = adcP == 0x80000 ? NAN : compensatePressure(adcP, tFine) / 256.0f;
+    reading.humidity = adcH == 0x8000 ? NAN : compensateHumidity(adcH, tFine) / 1024.0f;
+    return true;
+}
+
+bool Bme280Burst::readRegisters(uint8_t reg, uint8_t *buffer, size_t length)
+{
+    wire_->beginTransmission(address_);
+    wire_->write(reg);
+    if (wire_->endTransmission() != 0)
+    {
+        return false;
+    }
+    if (wire_->requestFrom(address_, (uint8_t)length) != length)
+    {
+        return false;
+    }
+    return wire_->readBytes(buffer, length) == length;
+}
+
+bool Bme280Burst::writeRegister(uint8_t reg, uint8_t value)
+{
+    wire_->beginTransmission(address_);
+    wire_->write(reg);
+    wire_->write(value);
+    return wire_->endTransmission() == 0;
+}
+
+bool Bme280Burst::readCalibration()
+{
+    uint8_t tp[24];
+    uint8_t h1;
+    uint8_t h[7];
+    if (!readRegisters(BME280_REG_CALIB_TP, tp, sizeof(tp)) ||
+        !readRegisters(BME280_REG_CALIB_H1, &h1, 1) ||
+        !readRegisters(BME280_REG_CALIB_H2, h, sizeof(h)))
+    {
+        return false;
+    }
+
+    auto u16 = [&tp](uint8_t i)
+    { return (uint16_t)(tp[i] | (tp[i + 1] << 8)); };
+
+    calib_.t1 = u16(0);
+    calib_.t2 = (int16_t)u16(2);
+    calib_.t3 = (int16_t)u16(4);
+    calib_.p1 = u16(6);
+    calib_.p2 = (int16_t)u16(8);
+    calib_.p3 = (int16_t)u16(10);
+    calib_.p4 = (int16_t)u16(12);
+    calib_.p5 = (int16_t)u16(14);
+    calib_.p6 = (int16_t)u16(16);
+    calib_.p7 = (int16_t)u16(18);
+    calib_.p8 = (int16_t)u16(20);
+    calib_.p9 = (int16_t)u16(22);
+    calib_.h1 = h1;
+    calib_.h2 = (int16_t)(h[0] | (h[1] << 8));
+    calib_.h3 = h[2];
+    calib_.h4 = (int16_t)(((int8_t)h[3] << 4) | (h[4] & 0x0F));
+    calib_.h5 = (int16_t)(((int8_t)h[5] << 4) | (h[4] >> 4));
+    calib_.h6 = (int8_t)h[6];
+    return true;
+}
+
+uint8_t Bme280Burst::oversamplingCode(uint8_t factor)
+{
+    switch (factor)
+    {
+    case 0:
+        return 0;
+    case 1:
+        return 1;
+    case 2:
+        return 2;
+    case 4:
+        return 3;
+    case 8:
+        return 4;
+    default:
+        return 5; // 16x
+    }
+}
+
+int32_t Bme280Burst::compensateTemperature(int32_t adc, int32_t &tFine) const
+{
+    int32_t var1 = ((((adc >> 3) - ((int32_t)calib_.t1 << 1))) * ((int32_t)calib_.t2)) >> 11;
+    int32_t var2 = (((((adc >> 4) - ((int32_t)calib_.t1)) * ((adc >> 4) - ((int32_t)calib_.t1))) >> 12) *
+                    ((int32_t)calib_.t3)) >>
+                   14;
+    tFine = var1 + var2;
+    return (tFine * 5 + 128) >> 8; // 0.01 degC
+}
+
+uint32_t Bme280Burst::compensatePressure(int32_t adc, int32_t tFine) const
+{
+    int64_t var1 = ((int64_t)tFine) - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)calib_.p6;
+    var2 = var2 + ((var1 * (int64_t)calib_.p5) << 17);
+    var2 = var2 + (((int64_t)calib_.p4) << 35);
+    var1 = ((var1 * var1 * (int64_t)calib_.p3) >> 8) + ((var1 * (int64_t)calib_.p2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib_.p1) >> 33;
+    if (var1 == 0)
+    {
+        return 0; // Avoid division by zero
+    }
+    int64_t p = 1048576 - adc;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)calib_.p9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)calib_.p8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)calib_.p7) << 4);
+    return (uint32_t)p; // Q24.8 Pa
+}
+
+uint32_t Bme280Burst::compensateHumidity(int32_t adc, int32_t tFine) const
+{
+    int32_t v = tFine - ((int32_t)76800);
+    v = (((((adc << 14) - (((int32_t)calib_.h4) << 20) - (((int32_t)calib_.h5) * v)) + ((int32_t)16384)) >> 15) *
+         (((((((v * ((int32_t)calib_.h6)) >> 10) * (((v * ((int32_t)calib_.h3)) >> 11) + ((int32_t)32768))) >> 10) +
+            ((int32_t)2097152)) *
+               ((int32_t)calib_.h2) +
+           8192) >>
+          14));
+    v = v - (((((v >> 15) * (v >> 15)) >> 7) * ((int32_t)calib_.h1)) >> 4);
+    v = v < 0 ? 0 : v;
+    v = v > 419430400 ? 419430400 : v;
+    return (uint32_t)(v >> 12); // Q22.10 %RH
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+
+// Minimal BME280 driver that runs the sensor in forced mode and reads the whole
+// data block (pressure, temperature, humidity) in a single burst. Compensation is
+// done once per read using the integer formulas from the Bosch datasheet.
+class Bme280Burst
+{
+public:
+    struct Reading
+    {
+        float temperature; // Temperature in Celsius
+        float humidity;    // Relative humidity in percent
+        float pressure;    // Pressure in Pascals
+    };
+
+    // Oversampling factors are 0 (skipped), 1, 2, 4, 8 or 16
+    bool begin(TwoWire &wire, uint8_t address, uint8_t osTemperature, uint8_t osPressure, uint8_t osHumidity);
+
+    bool triggerConversion();          // Start a forced conversion, returns immediately
+    uint32_t conversionTimeMs() const; // Worst case time until the result is ready
+    bool read(Reading &reading);       // Burst read and compensate the last conversion
+
+private:
+    struct Calibration
+    {
+        uint16_t t1;
+        int16_t t2, t3;
+        uint16_t p1;
+        int16_t p2, p3, p4, p5, p6, p7, p8, p9;
+        uint8_t h1;
+        int16_t h2;
+        uint8_t h3;
+        int16_t h4, h5;
+        int8_t h6;
+    };
+
+    bool readRegisters(uint8_t reg, uint8_t *buffer, size_t length);
+    bool writeRegister(uint8_t reg, uint8_t value);
+    bool readCalibration();
+    static uint8_t oversamplingCode(uint8_t factor);
+
+    int32_t compensateTemperature(int32_t adc, int32_t &tFine) const;
+    uint32_t compensatePressure(int32_t adc, int32_t tFine) const;
+    uint32_t compensateHumidity(int32_t adc, int32_t tFine) const;
+
+    TwoWire *wire_ = nullptr;
+    uint8_t address_ = 0;
+    uint8_t ctrlMeas_ = 0; // ctrl_meas value without the mode bits
+    uint32_t conversionTimeMs_ = 0;
+    Calibration calib_ = {};
+};
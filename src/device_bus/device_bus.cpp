@@ -1,80 +1,224 @@
 #include "device_bus.h"
+#include <cmath>
+#include "settings/settings.h"
 
 void DeviceBus::setup()
 {
     Wire.setPins(21, 22); // Set SDA and SCL pins (GPIO 21 and 22 are default for ESP32)
     Wire.begin();
-    Wire.setClock(100000); // Set I2C clock speed to 100kHz
+    Wire.setClock(settingU32(Setting::I2cSpeed)); // Set I2C clock speed
 
-    bme280.begin(ENVIRONMENTAL_SENSOR_ADDRESS);                            // Initialize the built-in BME280 sensor
+    if (!bme280.begin(Wire, ENVIRONMENTAL_SENSOR_ADDRESS,
+                      BME280_OVERSAMPLING_TEMPERATURE,
+                      BME280_OVERSAMPLING_PRESSURE,
+                      BME280_OVERSAMPLING_HUMIDITY)) // Initialize the built-in BME280 sensor
+    {
+        LOG_WEBSERIALLN("Failed to initialize built-in BME280 sensor");
+    }
     bmi088 = new Bmi088(Wire, ACCELEROMETER_ADDRESS, GYRO_ADDRESS);        // Initialize the BMI088 sensor with I2C addresses
     bmi088->begin();                                                       // Start the BMI088 sensor
     bmi088->setOdr(Bmi088::ODR_1000HZ);                                    // Set the output data rate to 1000Hz
     bmi088->setRange(Bmi088::ACCEL_RANGE_24G, Bmi088::GYRO_RANGE_2000DPS); // Set accelerometer and gyroscope ranges
+}
 
-    // Scan for devices on the bus
+void DeviceBus::discover()
+{
+    // Scan every address on the bus once, boards found later are picked up by discoveryStep
     for (uint8_t address = 1; address < 127; ++address)
     {
-        if (address == ENVIRONMENTAL_SENSOR_ADDRESS ||
-            address == GYRO_ADDRESS ||
-            address == ACCELEROMETER_ADDRESS)
-        {
-            continue; // Skip known non-sensor board addresses
-        }
-        Wire.beginTransmission(address);
-        if (Wire.endTransmission() == 0)
-        {
-            LOG_WEBSERIALLN("Found device at address: 0x" + String(address, HEX));
-            // Serial.println("Found device at address: 0x" + String(address, HEX));
-            potentialAddresses.push_back(address);
-        }
+        probeAddress(address);
     }
 }
 
-void DeviceBus::discover()
+void DeviceBus::discoveryStep()
 {
-    // Clear previous discoveries
-    sensorBoards.clear();
+    uint32_t now = millis();
+    uint8_t probed = 0;
 
-    // Check for known devices
-    for (uint8_t address : potentialAddresses)
+    for (uint8_t scanned = 0; scanned < 126 && probed < DISCOVERY_ADDRESSES_PER_STEP; ++scanned)
     {
-        // send a no-operation command to the device
-        Wire.beginTransmission(address);
-        // write a 0x00 byte to the device
-        Wire.write(0x00);
-        if (Wire.endTransmission() != 0)
+        uint8_t address = discoveryCursor;
+        discoveryCursor = (discoveryCursor >= 126) ? 1 : discoveryCursor + 1;
+
+        if ((int32_t)(now - addressStates[address].nextProbeMs) < 0)
         {
-            LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " did not respond.");
-            continue; // Device did not respond, skip it
+            continue; // Still backing off from earlier failures
         }
-        // now read if the device responds with it's address
-        Wire.requestFrom(address, 1);
-        if (Wire.available() > 0)
+        probeAddress(address);
+        ++probed;
+    }
+}
+
+void DeviceBus::onBoardEvent(BoardEventCallback cb)
+{
+    boardEventCallback = cb;
+}
+
+bool DeviceBus::isReservedAddress(uint8_t address)
+{
+    return address == ENVIRONMENTAL_SENSOR_ADDRESS ||
+           address == GYRO_ADDRESS ||
+           address == ACCELEROMETER_ADDRESS;
+}
+
+bool DeviceBus::isAttached(uint8_t address)
+{
+    return std::any_of(sensorBoards.begin(), sensorBoards.end(),
+                       [address](const SensorDevice &dev)
+                       { return dev.address == address; });
+}
+
+void DeviceBus::probeAddress(uint8_t address)
+{
+    if (isReservedAddress(address))
+    {
+        return; // Skip known non-sensor board addresses
+    }
+
+    Wire.beginTransmission(address);
+    bool acked = Wire.endTransmission() == 0;
+
+    if (isAttached(address))
+    {
+        // Known board, this is only a liveness check
+        noteTransaction(address, acked);
+        return;
+    }
+
+    if (!acked)
+    {
+        if (addressStates[address].failures > 0)
         {
-            uint8_t response = Wire.read();
-            if (response == address)
-            {
-                LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " is responding.");
-                // Get sensor device information
-                SensorDevice device = getSensorDevice(address);
-                if (device.address != 0)
-                {
-                    sensorBoards.push_back(device);
-                    LOG_WEBSERIALLN("Added device at address 0x" + String(device.address, HEX) + " to sensor bus.");
-                    // Serial.println("Added device at address 0x" + String(device.address, HEX) + " to sensor bus.");
-                }
-            }
-            else
-            {
-                LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " responded with unexpected data: 0x" + String(response, HEX));
-            }
+            noteTransaction(address, false); // A board used to live here, keep backing off
         }
-        else
+        return;
+    }
+
+    SensorDevice device;
+    if (handshake(address, device))
+    {
+        attachBoard(device);
+    }
+    else
+    {
+        noteTransaction(address, false); // Something answered but it is not a sensor board
+    }
+}
+
+bool DeviceBus::handshake(uint8_t address, SensorDevice &device)
+{
+    // send a no-operation command to the device
+    Wire.beginTransmission(address);
+    // write a 0x00 byte to the device
+    Wire.write(0x00);
+    if (Wire.endTransmission() != 0)
+    {
+        LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " did not respond.");
+        return false;
+    }
+    // now read if the device responds with it's address
+    Wire.requestFrom(address, 1);
+    if (Wire.available() == 0)
+    {
+        LOG_WEBSERIALLN("No data received from device at address: 0x" + String(address, HEX));
+        return false;
+    }
+    uint8_t response = Wire.read();
+    if (response != address)
+    {
+        LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " responded with unexpected data: 0x" + String(response, HEX));
+        return false;
+    }
+
+    LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " is responding.");
+    // Get sensor device information
+    device = getSensorDevice(address);
+    return device.address == address;
+}
+
+void DeviceBus::attachBoard(const SensorDevice &device)
+{
+    addressStates[device.address] = {0, 0};
+    sensorBoards.push_back(device);
+    LOG_WEBSERIALLN("Added device at address 0x" + String(device.address, HEX) + " to sensor bus.");
+
+    if (device.ledCount > 0)
+    {
+        LedFramebuffer buffer = {};
+        buffer.address = device.address;
+        buffer.count = device.ledCount < BOARD_LED_MAX ? device.ledCount : BOARD_LED_MAX;
+        buffer.dirtyEnd = buffer.count; // Blank the whole strip on the first flush
+        buffer.pixels[0] = {0, 0, 255}; // First LED blue to show the board is connected
+        ledBuffers.push_back(buffer);
+    }
+
+    if (boardEventCallback)
+    {
+        boardEventCallback(BoardEvent::Attached, device);
+    }
+}
+
+void DeviceBus::detachBoard(uint8_t address)
+{
+    auto it = std::find_if(sensorBoards.begin(), sensorBoards.end(),
+                           [address](const SensorDevice &dev)
+                           { return dev.address == address; });
+    if (it == sensorBoards.end())
+    {
+        return;
+    }
+
+    SensorDevice device = *it;
+    sensorBoards.erase(it);
+    ledBuffers.erase(std::remove_if(ledBuffers.begin(), ledBuffers.end(),
+                                    [address](const LedFramebuffer &buffer)
+                                    { return buffer.address == address; }),
+                     ledBuffers.end());
+    LOG_WEBSERIALLN("Removed unresponsive device at address 0x" + String(address, HEX) + " from sensor bus.");
+
+    if (boardEventCallback)
+    {
+        boardEventCallback(BoardEvent::Detached, device);
+    }
+}
+
+void DeviceBus::noteTransaction(uint8_t address, bool ok)
+{
+    AddressState &state = addressStates[address];
+    if (ok)
+    {
+        state.failures = 0;
+        return;
+    }
+
+    if (state.failures < UINT8_MAX)
+    {
+        ++state.failures;
+    }
+    LOG_DEFERRED(BOARD_TRANSACTION_FAILED, address, state.failures);
+
+    if (isAttached(address))
+    {
+        if (state.failures < DEVICE_FAILURE_THRESHOLD)
         {
-            LOG_WEBSERIALLN("No data received from device at address: 0x" + String(address, HEX));
+            return; // Tolerate the odd failed transaction
         }
+        detachBoard(address);
+    }
+    scheduleRetry(address);
+}
+
+void DeviceBus::scheduleRetry(uint8_t address)
+{
+    // Exponential back off so dead boards stop costing bus time
+    AddressState &state = addressStates[address];
+    uint8_t shift = state.failures > 0 ? state.failures - 1 : 0;
+    uint32_t delayMs = DISCOVERY_BACKOFF_MAX_MS;
+    if (shift < 16 && ((uint32_t)DISCOVERY_BACKOFF_BASE_MS << shift) < DISCOVERY_BACKOFF_MAX_MS)
+    {
+        delayMs = (uint32_t)DISCOVERY_BACKOFF_BASE_MS << shift;
     }
+    state.nextProbeMs = millis() + delayMs;
 }
 
 DeviceBus::SensorDevice DeviceBus::getSensorDevice(uint8_t address)
@@ -85,6 +229,7 @@ DeviceBus::SensorDevice DeviceBus::getSensorDevice(uint8_t address)
     if (Wire.endTransmission() != 0)
     {
         LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " did not respond.");
+        device.address = 0;
         return device; // Device did not respond, return empty device
     }
     Wire.requestFrom((int)address, sizeof(SensorDevice) - 1);
@@ -98,20 +243,28 @@ DeviceBus::SensorDevice DeviceBus::getSensorDevice(uint8_t address)
                         String(device.bme280Sensors) + " BME280 sensors, " +
                         String(device.ledCount) + " LEDs.");
 
-        // if we have 1 leds we set it to blue to indicate that the device is connected
-        if (device.ledCount > 0)
-        {
-            RGB color = {0, 0, 255}; // Blue color
-            setLED(address, color);  // Set the first LED to blue
-        }
     }
     else
     {
         LOG_WEBSERIALLN("Device at address 0x" + String(address, HEX) + " did not return expected data.");
+        device.address = 0;
     }
     return device; // Return the device information
 };
 
+bool DeviceBus::getBoard(uint8_t address, SensorDevice &device)
+{
+    auto it = std::find_if(sensorBoards.begin(), sensorBoards.end(),
+                           [address](const SensorDevice &dev)
+                           { return dev.address == address; });
+    if (it == sensorBoards.end())
+    {
+        return false;
+    }
+    device = *it;
+    return true;
+}
+
 std::vector<uint8_t> DeviceBus::getBoardAddresses()
 {
     std::vector<uint8_t> addresses;
@@ -131,7 +284,7 @@ void DeviceBus::setDigitalOutput(uint8_t address, uint8_t index, bool value)
 
     if (it == sensorBoards.end())
     {
-        LOG_WEBSERIALLN("No sensor board found at address 0x" + String(address, HEX));
+        LOG_DEFERRED(BOARD_NOT_FOUND, address);
         return;
     }
 
@@ -148,8 +301,10 @@ void DeviceBus::setDigitalOutput(uint8_t address, uint8_t index, bool value)
     if (Wire.endTransmission() != 0)
     {
         LOG_WEBSERIALLN("Failed to set LED at address 0x" + String(address, HEX) + " index " + String(index));
+        noteTransaction(address, false);
         return;
     }
+    noteTransaction(address, true);
 }
 
 bool DeviceBus::getDigitalInput(uint8_t address, uint8_t index)
@@ -160,7 +315,7 @@ bool DeviceBus::getDigitalInput(uint8_t address, uint8_t index)
 
     if (it == sensorBoards.end())
     {
-        LOG_WEBSERIALLN("No sensor board found at address 0x" + String(address, HEX));
+        LOG_DEFERRED(BOARD_NOT_FOUND, address);
         return false;
     }
 
@@ -177,8 +332,10 @@ bool DeviceBus::getDigitalInput(uint8_t address, uint8_t index)
     Wire.requestFrom(address, 1);
     if (Wire.available() > 0)
     {
+        noteTransaction(address, true);
         return Wire.read();
     }
+    noteTransaction(address, false);
     return false;
 }
 
@@ -190,7 +347,7 @@ int DeviceBus::getAnalogInput(uint8_t address, uint8_t index)
 
     if (it == sensorBoards.end())
     {
-        LOG_WEBSERIALLN("No sensor board found at address 0x" + String(address, HEX));
+        LOG_DEFERRED(BOARD_NOT_FOUND, address);
         return -1;
     }
 
@@ -210,8 +367,10 @@ int DeviceBus::getAnalogInput(uint8_t address, uint8_t index)
     {
         uint8_t high = Wire.read();
         uint8_t low = Wire.read();
+        noteTransaction(address, true);
         return (high << 8) | low;
     }
+    noteTransaction(address, false);
     return -1;
 }
 
@@ -221,14 +380,18 @@ DeviceBus::BME280Sensor DeviceBus::getBME280Sensor(uint8_t address)
     {
         // if no address is specified, we return the built-in sensor
         address = ENVIRONMENTAL_SENSOR_ADDRESS;
-        LOG_WEBSERIALLN("No address specified, using built-in environmental sensor at address 0x" + String(address, HEX));
-        BME280Sensor sensor = {0, 0, 0};
-        sensor.humidity = bme280.readHumidity();
-        sensor.temperature = bme280.readTemperature();
-        sensor.pressure = bme280.readPressure();
-        LOG_WEBSERIALLN("Built-in BME280 -> Hum: " + String(sensor.humidity) +
-                        ", Temp: " + String(sensor.temperature) +
-                        ", Press: " + String(sensor.pressure));
+        BME280Sensor sensor = {0, 0, 0, false};
+        Bme280Burst::Reading reading;
+        if (!bme280.read(reading))
+        {
+            LOG_WEBSERIALLN("Failed to read built-in BME280 sensor");
+            return sensor;
+        }
+        sensor.humidity = reading.humidity;
+        sensor.temperature = reading.temperature;
+        sensor.pressure = reading.pressure;
+        sensor.valid = true;
+        LOG_DEFERRED(BME280_BUILTIN_SAMPLE, sensor.humidity, sensor.temperature, sensor.pressure);
         return sensor;
     }
 
@@ -238,15 +401,15 @@ DeviceBus::BME280Sensor DeviceBus::getBME280Sensor(uint8_t address)
 
     if (it == sensorBoards.end())
     {
-        LOG_WEBSERIALLN("No sensor board found at address 0x" + String(address, HEX));
-        return {0, 0, 0};
+        LOG_DEFERRED(BOARD_NOT_FOUND, address);
+        return {0, 0, 0, false};
     }
 
     Wire.beginTransmission(address);
     Wire.write(0x04); // Command to read BME280 sensor
     Wire.endTransmission();
 
-    BME280Sensor sensor = {0, 0, 0};
+    BME280Sensor sensor = {0, 0, 0, false};
     Wire.requestFrom(address, 12);
     if (Wire.available() >= 12)
     {
@@ -257,55 +420,205 @@ DeviceBus::BME280Sensor DeviceBus::getBME280Sensor(uint8_t address)
         memcpy(&sensor.humidity, buffer, 4);
         memcpy(&sensor.temperature, buffer + 4, 4);
         memcpy(&sensor.pressure, buffer + 8, 4);
+        sensor.valid = std::isfinite(sensor.humidity) && std::isfinite(sensor.temperature) && std::isfinite(sensor.pressure);
 
-        LOG_WEBSERIALLN("BME280 at address 0x" + String(address, HEX) +
-                        " -> Hum: " + String(sensor.humidity) +
-                        ", Temp: " + String(sensor.temperature) +
-                        ", Press: " + String(sensor.pressure));
+        LOG_DEFERRED(BME280_BOARD_SAMPLE, address, sensor.humidity, sensor.temperature, sensor.pressure);
+        noteTransaction(address, true);
     }
     else
     {
         LOG_WEBSERIALLN("Failed to read BME280 sensor data from address 0x" + String(address, HEX));
+        noteTransaction(address, false);
     }
     return sensor;
 }
 
+bool DeviceBus::triggerBME280Conversion()
+{
+    return bme280.triggerConversion();
+}
+
+uint32_t DeviceBus::getBME280ConversionTimeMs()
+{
+    return bme280.conversionTimeMs();
+}
+
+bool DeviceBus::parseLedPattern(const char *name, LedPattern &pattern)
+{
+    static const char *names[] = {"off", "solid", "blink", "breathe", "chase", "rainbow"};
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(LedPattern::COUNT), "names must match LedPattern");
+    for (uint8_t i = 0; name != nullptr && i < static_cast<uint8_t>(LedPattern::COUNT); ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            pattern = static_cast<LedPattern>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+DeviceBus::LedFramebuffer *DeviceBus::findLedBuffer(uint8_t address)
+{
+    for (auto &buffer : ledBuffers)
+    {
+        if (buffer.address == address)
+        {
+            return &buffer;
+        }
+    }
+    LOG_DEFERRED(BOARD_NOT_FOUND, address);
+    return nullptr;
+}
+
 void DeviceBus::setLED(uint8_t address, RGB color, uint8_t index)
 {
+    setLEDs(address, index, &color, 1);
+}
 
-    // check to see if this is possible
-    // Find the sensor board for the given address
-    auto it = std::find_if(sensorBoards.begin(), sensorBoards.end(),
-                           [address](const SensorDevice &dev)
-                           { return dev.address == address; });
+bool DeviceBus::setLEDs(uint8_t address, uint8_t start, const RGB *colors, uint8_t count)
+{
+    LedFramebuffer *buffer = findLedBuffer(address);
+    if (buffer == nullptr || count == 0 || start + count > buffer->count)
+    {
+        return false;
+    }
 
-    if (it == sensorBoards.end())
+    bool resendAll = buffer->patternActive;
+    buffer->patternActive = false;
+    buffer->patternPending = false;
+    for (uint8_t i = 0; i < count; ++i)
     {
-        LOG_WEBSERIALLN("No sensor board found at address 0x" + String(address, HEX));
-        return;
+        RGB &pixel = buffer->pixels[start + i];
+        if (pixel.r == colors[i].r && pixel.g == colors[i].g && pixel.b == colors[i].b)
+        {
+            continue;
+        }
+        pixel = colors[i];
+        if (buffer->dirtyFirst == buffer->dirtyEnd)
+        {
+            buffer->dirtyFirst = start + i;
+            buffer->dirtyEnd = start + i + 1;
+        }
+        else
+        {
+            buffer->dirtyFirst = std::min<uint8_t>(buffer->dirtyFirst, start + i);
+            buffer->dirtyEnd = std::max<uint8_t>(buffer->dirtyEnd, start + i + 1);
+        }
+    }
+    if (resendAll)
+    {
+        // The board stops its pattern on the next write, resend everything
+        buffer->dirtyFirst = 0;
+        buffer->dirtyEnd = buffer->count;
     }
+    return true;
+}
 
-    // Check if the index is within the available LED count
-    if (index >= it->ledCount)
+bool DeviceBus::setLEDPattern(uint8_t address, LedPattern pattern, RGB color, uint16_t periodMs)
+{
+    LedFramebuffer *buffer = findLedBuffer(address);
+    if (buffer == nullptr)
     {
-        LOG_WEBSERIALLN("Invalid LED index " + String(index) + " for device at address 0x" + String(address, HEX));
-        return;
+        return false;
     }
+    buffer->pattern = pattern;
+    buffer->patternColor = color;
+    buffer->patternPeriodMs = periodMs;
+    buffer->patternPending = true;
+    buffer->patternActive = true;
+    buffer->dirtyFirst = buffer->dirtyEnd = 0; // Pixel writes would stop the pattern again
+    return true;
+}
 
-    Wire.beginTransmission(address);
-    Wire.write(0x05);    // Command to set LED color
-    Wire.write(index);   // LED index
-    Wire.write(color.r); // Red component
-    Wire.write(color.g); // Green component
-    Wire.write(color.b); // Blue component
-    if (Wire.endTransmission() != 0)
+bool DeviceBus::writeLEDRange(const LedFramebuffer &buffer)
+{
+#if BOARD_LED_RANGE_WRITES
+    // Split so every transaction fits in the Wire buffer
+    for (uint8_t first = buffer.dirtyFirst; first < buffer.dirtyEnd; first += BOARD_LED_MAX_PER_WRITE)
     {
-        LOG_WEBSERIALLN("Failed to set LED at address 0x" + String(address, HEX) + " index " + String(index));
-        return;
+        uint8_t count = std::min<uint8_t>(buffer.dirtyEnd - first, BOARD_LED_MAX_PER_WRITE);
+        Wire.beginTransmission(buffer.address);
+        Wire.write(0x06);  // Command to set a range of LEDs
+        Wire.write(first); // First LED index
+        Wire.write(count); // Number of LEDs
+        for (uint8_t i = first; i < first + count; ++i)
+        {
+            Wire.write(buffer.pixels[i].r);
+            Wire.write(buffer.pixels[i].g);
+            Wire.write(buffer.pixels[i].b);
+        }
+        if (Wire.endTransmission() != 0)
+        {
+            return false;
+        }
+    }
+#else
+    // Boards without the range command still get one write per changed LED only
+    for (uint8_t i = buffer.dirtyFirst; i < buffer.dirtyEnd; ++i)
+    {
+        Wire.beginTransmission(buffer.address);
+        Wire.write(0x05);                // Command to set LED color
+        Wire.write(i);                   // LED index
+        Wire.write(buffer.pixels[i].r); // Red component
+        Wire.write(buffer.pixels[i].g); // Green component
+        Wire.write(buffer.pixels[i].b); // Blue component
+        if (Wire.endTransmission() != 0)
+        {
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+bool DeviceBus::writeLEDPattern(const LedFramebuffer &buffer)
+{
+    Wire.beginTransmission(buffer.address);
+    Wire.write(0x07); // Command to run an LED pattern on the board
+    Wire.write(static_cast<uint8_t>(buffer.pattern));
+    Wire.write(buffer.patternColor.r);
+    Wire.write(buffer.patternColor.g);
+    Wire.write(buffer.patternColor.b);
+    Wire.write(static_cast<uint8_t>(buffer.patternPeriodMs & 0xFF));
+    Wire.write(static_cast<uint8_t>(buffer.patternPeriodMs >> 8));
+    return Wire.endTransmission() == 0;
+}
+
+void DeviceBus::flushLEDs()
+{
+    uint32_t now = millis();
+    uint8_t results[BOARD_LED_MAX_FLUSHES][2]; // Address and outcome, noted after the loop as a detach edits ledBuffers
+    uint8_t flushed = 0;
+
+    for (auto &buffer : ledBuffers)
+    {
+        bool dirty = buffer.dirtyFirst != buffer.dirtyEnd;
+        if ((!dirty && !buffer.patternPending) || now - buffer.lastFlushMs < 1000 / BOARD_LED_REFRESH_HZ)
+        {
+            continue;
+        }
+        if (flushed == BOARD_LED_MAX_FLUSHES)
+        {
+            break; // The rest go on the next call
+        }
+        buffer.lastFlushMs = now;
+
+        bool ok = buffer.patternPending ? writeLEDPattern(buffer) : writeLEDRange(buffer);
+        if (ok)
+        {
+            LOG_DEFERRED(BOARD_LED_FLUSH, buffer.patternPending ? 0 : buffer.dirtyEnd - buffer.dirtyFirst, buffer.address);
+            buffer.patternPending = false;
+            buffer.dirtyFirst = buffer.dirtyEnd = 0;
+        }
+        results[flushed][0] = buffer.address;
+        results[flushed][1] = ok;
+        ++flushed;
+    }
+    for (uint8_t i = 0; i < flushed; ++i)
+    {
+        noteTransaction(results[i][0], results[i][1]);
     }
-    LOG_WEBSERIALLN("Set LED at address 0x" + String(address, HEX) + " index " + String(index) +
-                    " to color (" + String(color.r) + ", " + String(color.g) + ", " + String(color.b) + ")");
-    return;
 }
 
 DeviceBus::Bmi088Data DeviceBus::getBmi088Sensor()
@@ -331,9 +644,8 @@ DeviceBus::Bmi088Data DeviceBus::getBmi088Sensor()
     data.temperature = bmi088->getTemperature_C();
     data.time = bmi088->getTime_ps();
 
-    LOG_WEBSERIALLN("BMI088 -> Accel: (" + String(data.accel.x) + ", " + String(data.accel.y) + ", " + String(data.accel.z) +
-                    "), Gyro: (" + String(data.gyro.x) + ", " + String(data.gyro.y) + ", " + String(data.gyro.z) +
-                    "), Temp: " + String(data.temperature) + ", Time: " + String(data.time));
+    LOG_DEFERRED(BMI088_SAMPLE, data.accel.x, data.accel.y, data.accel.z,
+                 data.gyro.x, data.gyro.y, data.gyro.z, data.temperature);
 
     return data;
 }
\ No newline at end of file
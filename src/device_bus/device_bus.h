@@ -4,8 +4,10 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <vector>
+#include <functional>
 #include <BMI088.h>
-#include <Adafruit_BME280.h>
+#include "bme280_burst.h"
+#include "logging/binary_log.h"
 
 #define ENVIRONMENTAL_SENSOR_ADDRESS 0x76 // Built-in environmental sensor address
 #define GYRO_ADDRESS 0x69                 // Built-in gyroscope address
@@ -15,7 +17,8 @@ class DeviceBus
 {
 public:
     void setup();
-    void discover();
+    void discover();      // Probe every address on the bus, used at boot
+    void discoveryStep(); // Incrementally probe the next few addresses, call while holding the bus
 
     struct SensorDevice
     {
@@ -38,7 +41,8 @@ public:
     {
         float humidity;    // Humidity in percentage
         float temperature; // Temperature in Celsius
-        float pressure;    // Pressure in hPa
+        float pressure;    // Pressure in Pa
+        bool valid;        // False when the read failed or returned a non-finite value
     };
 
     struct Bmi088AccelData
@@ -81,23 +85,86 @@ public:
         bool hasBME280;
     };
 
+    enum class BoardEvent
+    {
+        Attached,
+        Detached
+    };
+    enum class LedPattern : uint8_t
+    {
+        Off,
+        Solid,
+        Blink,
+        Breathe,
+        Chase,
+        Rainbow,
+        COUNT
+    };
+    static bool parseLedPattern(const char *name, LedPattern &pattern);
+
+    using BoardEventCallback = std::function<void(BoardEvent event, const SensorDevice &device)>;
+    void onBoardEvent(BoardEventCallback cb); // Called whenever a board appears on or disappears from the bus
+
     // functions to interact with devices
     void setDigitalOutput(uint8_t address, uint8_t index, bool value = false); // we set default to false so if we forget to set a value, it will default to off
     bool getDigitalInput(uint8_t address, uint8_t index);
     int getAnalogInput(uint8_t address, uint8_t index);
     BME280Sensor getBME280Sensor(uint8_t address = 0); // Default to first sensor if index is not specified
+    bool triggerBME280Conversion();                    // Start a forced conversion on the built-in sensor
+    uint32_t getBME280ConversionTimeMs();              // Time to wait between trigger and read
     Bmi088Data getBmi088Sensor();                      // Onboard device so no address needed
     Bmi088AccelData getBmi088Accel();                  // Onboard device so no address needed
     Bmi088GyroData getBmi088Gyro();                    // Onboard device so no address needed
 
+    // LEDs of a board are written into its framebuffer, flushLEDs() sends the changed range
     void setLED(uint8_t address, RGB color, uint8_t index = 0); // Set LED color at index for device at address (default to first LED if index is not specified)
+    bool setLEDs(uint8_t address, uint8_t start, const RGB *colors, uint8_t count);
+    bool setLEDPattern(uint8_t address, LedPattern pattern, RGB color, uint16_t periodMs); // Animation run by the board itself
+    void flushLEDs(); // Call while holding the bus, at most BOARD_LED_REFRESH_HZ per board
     std::vector<uint8_t> getBoardAddresses();
+    bool getBoard(uint8_t address, SensorDevice &device); // Cached board information, no bus traffic
     SensorDevice getSensorDevice(uint8_t address);
 
 private:
-    std::vector<uint8_t> potentialAddresses; // Store discovered device addresses
-    std::vector<SensorDevice> sensorBoards;  // Store discovered sensor devices
+    struct AddressState
+    {
+        uint8_t failures;     // Consecutive failed transactions with this address
+        uint32_t nextProbeMs; // Earliest time the address may be probed again
+    };
+
+    struct LedFramebuffer
+    {
+        uint8_t address;
+        uint8_t count;
+        RGB pixels[BOARD_LED_MAX];
+        uint8_t dirtyFirst;    // Changed pixels are [dirtyFirst, dirtyEnd)
+        uint8_t dirtyEnd;
+        bool patternPending;   // Pattern below not sent yet
+        bool patternActive;    // The board runs a pattern, pixels no longer match the board
+        LedPattern pattern;
+        RGB patternColor;
+        uint16_t patternPeriodMs;
+        uint32_t lastFlushMs;
+    };
+
+    std::vector<SensorDevice> sensorBoards; // Store discovered sensor devices
+    std::vector<LedFramebuffer> ledBuffers; // One per attached board with LEDs
+    AddressState addressStates[128] = {};   // Per address health used for back off
+    uint8_t discoveryCursor = 1;            // Next address to be probed by discoveryStep
+    BoardEventCallback boardEventCallback;
+
+    bool isReservedAddress(uint8_t address);
+    bool isAttached(uint8_t address);
+    void probeAddress(uint8_t address);
+    bool handshake(uint8_t address, SensorDevice &device);
+    void attachBoard(const SensorDevice &device);
+    void detachBoard(uint8_t address);
+    void noteTransaction(uint8_t address, bool ok); // Track failures and detach boards that stop responding
+    void scheduleRetry(uint8_t address);
+    LedFramebuffer *findLedBuffer(uint8_t address);
+    bool writeLEDRange(const LedFramebuffer &buffer);
+    bool writeLEDPattern(const LedFramebuffer &buffer);
 
-    Adafruit_BME280 bme280;   // BME280 sensor built-in instance
+    Bme280Burst bme280;       // BME280 sensor built-in instance
     Bmi088 *bmi088 = nullptr; // BMI088 sensor pointer, to be initialized later
 };
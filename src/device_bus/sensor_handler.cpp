@@ -1,10 +1,22 @@
 #include "sensor_handler.h"
 #include "device_bus/device_bus.h"
 #include "serial_coms/serial_io.h"
+#include "orientation/mahony_ahrs.h"
+#include "settings/settings.h"
 
 DeviceBus deviceBus; // Create a global instance of DeviceBus
 extern SerialIO serialio;
 
+static void describeBoard(JsonObject obj, const DeviceBus::SensorDevice &device)
+{
+    obj["a"] = device.address;
+    obj["do"] = device.digitalOutputs;
+    obj["di"] = device.digitalInputs;
+    obj["ai"] = device.analogInputs;
+    obj["b"] = device.bme280Sensors;
+    obj["l"] = device.ledCount;
+}
+
 void SensorHandler::startSensorHandler()
 {
     // Initialize the I2C mutex
@@ -15,19 +27,37 @@ void SensorHandler::startSensorHandler()
         return;
     }
 
+    // Let the host know which board streams to expect as boards come and go
+    deviceBus.onBoardEvent([this](DeviceBus::BoardEvent event, const DeviceBus::SensorDevice &device)
+                           {
+                               JsonDocument doc;
+                               describeBoard(doc.to<JsonObject>(), device);
+                               doc["e"] = event == DeviceBus::BoardEvent::Attached ? 1 : 0;
+                               serialio.publish(DEVICE_EVENT_CHANNEL, doc);
+                               if (event == DeviceBus::BoardEvent::Detached)
+                               {
+                                   releaseStreamFilters(device.address); // A board that comes back starts unfiltered
+                               } });
+
     // Initialize the sensor system with default configurations
     deviceBus.setup();    // Initialize device bus communication
     deviceBus.discover(); // Discover devices on the bus
 
     // Set up tasks for each sensor type
+    // IMU streams default to point sampling at the previous 10 Hz publish rate
+    StreamFilter::Config imuDefault;
+    imuDefault.decimation = IMU_PUBLISH_DECIMATION;
+    setStreamFilter(StreamKind::Accel, 0, 0, imuDefault);
+    setStreamFilter(StreamKind::Gyro, 0, 0, imuDefault);
+
     xTaskCreatePinnedToCore(
-        bmi088SensorTaskWrapper,
-        "BMI088 Sensor Task",
-        2048,
+        orientationTaskWrapper,
+        "Orientation Task",
+        AHRS_TASK_STACK_SIZE,
         this,
-        1,
-        nullptr,
-        1);
+        AHRS_TASK_PRIORITY,
+        &orientationTaskHandle,
+        AHRS_TASK_CORE);
 
     xTaskCreatePinnedToCore(
         bme280SensorTaskWrapper,
@@ -55,12 +85,235 @@ void SensorHandler::startSensorHandler()
         1,
         nullptr,
         1);
+
+    xTaskCreatePinnedToCore(
+        discoveryTaskWrapper,
+        "Discovery Task",
+        DISCOVERY_TASK_STACK_SIZE,
+        this,
+        DISCOVERY_TASK_PRIORITY,
+        &discoveryTaskHandle,
+        1);
 }
 
-void SensorHandler::bmi088SensorTaskWrapper(void *parameter)
+void SensorHandler::getBoards(JsonDocument &doc)
 {
-    SensorHandler *instance = static_cast<SensorHandler *>(parameter);
-    instance->bmi088SensorTask(parameter);
+    JsonArray boards = doc["boards"].to<JsonArray>();
+    if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+    {
+        for (auto &address : deviceBus.getBoardAddresses())
+        {
+            DeviceBus::SensorDevice device;
+            if (deviceBus.getBoard(address, device))
+            {
+                describeBoard(boards.add<JsonObject>(), device);
+            }
+        }
+        xSemaphoreGive(i2cMutex);
+    }
+}
+
+bool SensorHandler::parseStreamKind(const char *name, StreamKind &kind)
+{
+    static const char *const names[] = {"accel", "gyro", "bme280", "analog"};
+    if (name == nullptr)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            kind = static_cast<StreamKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+float SensorHandler::streamSampleRate(StreamKind kind)
+{
+    switch (kind)
+    {
+    case StreamKind::Accel:
+    case StreamKind::Gyro:
+        return AHRS_SAMPLE_RATE_HZ;
+    case StreamKind::Bme280:
+        return 1000.0f / settingU32(Setting::Bme280PeriodMs);
+    case StreamKind::Analog:
+        return 1000.0f / settingU32(Setting::AnalogPeriodMs);
+    }
+    return 0.0f;
+}
+
+SensorHandler::FilteredStream *SensorHandler::findStream(StreamKind kind, uint8_t address, uint8_t index)
+{
+    for (auto &stream : filteredStreams)
+    {
+        if (stream.used && stream.kind == kind && stream.address == address && stream.index == index)
+        {
+            return &stream;
+        }
+    }
+    return nullptr;
+}
+
+bool SensorHandler::setStreamFilter(StreamKind kind, uint8_t address, uint8_t index, StreamFilter::Config config)
+{
+    config.sampleRateHz = streamSampleRate(kind);
+
+    // Validate on a scratch filter so a bad request does not disturb a running stream
+    StreamFilter probe;
+    if (!probe.configure(config))
+    {
+        return false;
+    }
+
+    bool ok = false;
+    portENTER_CRITICAL(&filterMux);
+    FilteredStream *stream = findStream(kind, address, index);
+    if (config.type == StreamFilter::Type::None && config.decimation == 1)
+    {
+        // Publishing every sample unchanged needs no filter, give the slot back
+        if (stream != nullptr)
+        {
+            stream->used = false;
+        }
+        portEXIT_CRITICAL(&filterMux);
+        return true;
+    }
+    if (stream == nullptr)
+    {
+        for (auto &candidate : filteredStreams)
+        {
+            if (!candidate.used)
+            {
+                stream = &candidate;
+                break;
+            }
+        }
+    }
+    if (stream != nullptr)
+    {
+        stream->used = true;
+        stream->kind = kind;
+        stream->address = address;
+        stream->index = index;
+        for (auto &filter : stream->filters)
+        {
+            filter.configure(config);
+        }
+        ok = true;
+    }
+    portEXIT_CRITICAL(&filterMux);
+    return ok;
+}
+
+void SensorHandler::releaseStreamFilters(uint8_t address)
+{
+    portENTER_CRITICAL(&filterMux);
+    for (auto &stream : filteredStreams)
+    {
+        if (stream.used && stream.address == address && (stream.kind == StreamKind::Bme280 || stream.kind == StreamKind::Analog))
+        {
+            stream.used = false;
+        }
+    }
+    portEXIT_CRITICAL(&filterMux);
+}
+
+bool SensorHandler::hasStreamFilter(StreamKind kind, uint8_t address, uint8_t index)
+{
+    portENTER_CRITICAL(&filterMux);
+    bool found = findStream(kind, address, index) != nullptr;
+    portEXIT_CRITICAL(&filterMux);
+    return found;
+}
+
+bool SensorHandler::filterStream(StreamKind kind, uint8_t address, uint8_t index, float *values, uint8_t count)
+{
+    bool due = true;
+    portENTER_CRITICAL(&filterMux);
+    FilteredStream *stream = findStream(kind, address, index);
+    if (stream != nullptr)
+    {
+        // All values of a stream share the same decimation so they become due together
+        for (uint8_t i = 0; i < count && i < 3; ++i)
+        {
+            due = stream->filters[i].push(values[i], values[i]);
+        }
+    }
+    portEXIT_CRITICAL(&filterMux);
+    return due;
+}
+
+void SensorHandler::setOrientationConfig(uint32_t intervalMs, bool enabled)
+{
+    orientationIntervalMs = intervalMs;
+    orientationEnabled = enabled;
+}
+
+bool SensorHandler::setBoardLeds(uint8_t address, uint8_t start, const DeviceBus::RGB *colors, uint8_t count)
+{
+    bool ok = false;
+    if (i2cMutex != NULL && xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+    {
+        ok = deviceBus.setLEDs(address, start, colors, count); // Framebuffer only, no bus traffic
+        xSemaphoreGive(i2cMutex);
+    }
+    return ok;
+}
+
+bool SensorHandler::setBoardLedPattern(uint8_t address, DeviceBus::LedPattern pattern, DeviceBus::RGB color, uint16_t periodMs)
+{
+    bool ok = false;
+    if (i2cMutex != NULL && xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+    {
+        ok = deviceBus.setLEDPattern(address, pattern, color, periodMs);
+        xSemaphoreGive(i2cMutex);
+    }
+    return ok;
+}
+
+void SensorHandler::setI2cSpeed(uint32_t hz)
+{
+    if (i2cMutex == NULL)
+    {
+        return; // Not started yet, DeviceBus::setup reads the setting
+    }
+    if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+    {
+        Wire.setClock(hz);
+        xSemaphoreGive(i2cMutex);
+    }
+}
+
+bool SensorHandler::getLatestImu(DeviceBus::Bmi088Data &data)
+{
+    portENTER_CRITICAL(&imuMux);
+    data = latestImu;
+    bool valid = latestImuValid;
+    portEXIT_CRITICAL(&imuMux);
+    return valid;
+}
+
+bool SensorHandler::getLatestAttitude(MahonyAHRS::Euler &attitude, float &yawRate)
+{
+    portENTER_CRITICAL(&imuMux);
+    attitude = latestAttitude;
+    yawRate = latestImu.gyro.z;
+    bool valid = latestAttitudeValid;
+    portEXIT_CRITICAL(&imuMux);
+    return valid;
+}
+
+bool SensorHandler::getLatestPressure(float &pressure, uint32_t &sampleMs)
+{
+    portENTER_CRITICAL(&imuMux);
+    pressure = latestPressure;
+    sampleMs = latestPressureMs;
+    portEXIT_CRITICAL(&imuMux);
+    return sampleMs != 0;
 }
 
 void SensorHandler::bme280SensorTaskWrapper(void *parameter)
@@ -81,57 +334,74 @@ void SensorHandler::digitalInputTaskWrapper(void *parameter)
     instance->digitalInputTask(parameter);
 }
 
-void SensorHandler::bmi088SensorTask(void *parameter)
+void SensorHandler::discoveryTaskWrapper(void *parameter)
 {
-    for (;;)
-    {
-        if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
-        {
-            DeviceBus::Bmi088Data data = deviceBus.getBmi088Sensor();
-            xSemaphoreGive(i2cMutex);
+    SensorHandler *instance = static_cast<SensorHandler *>(parameter);
+    instance->discoveryTask(parameter);
+}
 
-            JsonDocument doc;
-            doc["x"] = data.accel.x;
-            doc["y"] = data.accel.y;
-            doc["z"] = data.accel.z;
-            serialio.publish(3, doc);
-            doc["x"] = data.gyro.x;
-            doc["y"] = data.gyro.y;
-            doc["z"] = data.gyro.z;
-            serialio.publish(4, doc);
-            doc["t"] = data.temperature;
-            doc["ti"] = data.time;
-            serialio.publish(5, doc);
-        }
-        vTaskDelay(pdMS_TO_TICKS(100)); // Adjust the delay as needed
-    }
+void SensorHandler::orientationTaskWrapper(void *parameter)
+{
+    SensorHandler *instance = static_cast<SensorHandler *>(parameter);
+    instance->orientationTask(parameter);
 }
 
 void SensorHandler::bme280SensorTask(void *parameter)
 {
+    TickType_t lastWake = xTaskGetTickCount();
     for (;;)
     {
+        // Start the built-in conversion first and release the bus while the sensor converts
+        if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+        {
+            deviceBus.triggerBME280Conversion();
+            xSemaphoreGive(i2cMutex);
+        }
+        vTaskDelay(pdMS_TO_TICKS(deviceBus.getBME280ConversionTimeMs()) + 1);
+
+        // Include address 0 in the list of addresses
+        std::vector<uint8_t> addresses;
         if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
         {
-            // Include address 0 in the list of addresses
-            std::vector<uint8_t> addresses = deviceBus.getBoardAddresses();
-            addresses.insert(addresses.begin(), 0);
+            addresses = deviceBus.getBoardAddresses();
+            xSemaphoreGive(i2cMutex);
+        }
+        addresses.insert(addresses.begin(), 0);
+
+        for (auto &address : addresses)
+        {
+            if (xSemaphoreTake(i2cMutex, portMAX_DELAY) != pdTRUE)
+            {
+                continue;
+            }
+            DeviceBus::BME280Sensor result = deviceBus.getBME280Sensor(address);
+            xSemaphoreGive(i2cMutex);
+            if (!result.valid)
+            {
+                continue; // A failed read would stay in the filter for its whole window
+            }
 
-            for (auto &address : addresses)
+            if (address == HOLD_DEPTH_ADDRESS && result.pressure > 0.0f)
             {
-                DeviceBus::BME280Sensor result = deviceBus.getBME280Sensor(address);
-                xSemaphoreGive(i2cMutex);
+                portENTER_CRITICAL(&imuMux);
+                latestPressure = result.pressure;
+                latestPressureMs = millis() | 1; // Never 0, which means no sample yet
+                portEXIT_CRITICAL(&imuMux);
+            }
 
+            float values[3] = {result.temperature, result.humidity, result.pressure};
+            if (settingBool(Setting::Bme280Enabled) && filterStream(StreamKind::Bme280, address, 0, values, 3))
+            {
                 JsonDocument doc;
                 doc["a"] = address; // Address of the sensor board
-                doc["t"] = result.temperature;
-                doc["h"] = result.humidity;
-                doc["p"] = result.pressure;
+                doc["t"] = values[0];
+                doc["h"] = values[1];
+                doc["p"] = values[2];
 
                 serialio.publish(2, doc);
             }
         }
-        vTaskDelay(pdMS_TO_TICKS(100)); // Adjust the delay as needed
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(settingU32(Setting::Bme280PeriodMs)));
     }
 }
 
@@ -139,24 +409,42 @@ void SensorHandler::analogInputTask(void *parameter)
 {
     for (;;)
     {
-        if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+        if (settingBool(Setting::AnalogEnabled) && xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
         {
             for (auto &address : deviceBus.getBoardAddresses())
             {
-                for (uint8_t i = 0; i < deviceBus.getSensorDevice(address).analogInputs; ++i)
+                DeviceBus::SensorDevice device;
+                if (!deviceBus.getBoard(address, device))
+                {
+                    continue; // Board was detached while iterating
+                }
+                for (uint8_t i = 0; i < device.analogInputs; ++i)
                 {
                     int value = deviceBus.getAnalogInput(address, i);
                     JsonDocument doc;
                     doc["a"] = address; // Address of the sensor board
                     doc["i"] = i;       // Index of the analog input
-                    doc["v"] = value;   // Value read from the analog input
+
+                    if (!hasStreamFilter(StreamKind::Analog, address, i))
+                    {
+                        doc["v"] = value; // Value read from the analog input
+                    }
+                    else
+                    {
+                        float filtered = value;
+                        if (value < 0 || !filterStream(StreamKind::Analog, address, i, &filtered, 1))
+                        {
+                            continue; // Failed reads are not fed to the filter
+                        }
+                        doc["v"] = filtered;
+                    }
 
                     serialio.publish(6, doc);
                 }
             }
             xSemaphoreGive(i2cMutex);
         }
-        vTaskDelay(pdMS_TO_TICKS(100)); // Adjust the delay as needed
+        vTaskDelay(pdMS_TO_TICKS(settingU32(Setting::AnalogPeriodMs)));
     }
 }
 
@@ -164,11 +452,16 @@ void SensorHandler::digitalInputTask(void *parameter)
 {
     for (;;)
     {
-        if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
+        if (settingBool(Setting::DigitalEnabled) && xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE)
         {
             for (auto &address : deviceBus.getBoardAddresses())
             {
-                for (uint8_t i = 0; i < deviceBus.getSensorDevice(address).digitalInputs; ++i)
+                DeviceBus::SensorDevice device;
+                if (!deviceBus.getBoard(address, device))
+                {
+                    continue; // Board was detached while iterating
+                }
+                for (uint8_t i = 0; i < device.digitalInputs; ++i)
                 {
                     bool value = deviceBus.getDigitalInput(address, i);
                     JsonDocument doc;
@@ -181,6 +474,119 @@ void SensorHandler::digitalInputTask(void *parameter)
             }
             xSemaphoreGive(i2cMutex);
         }
-        vTaskDelay(pdMS_TO_TICKS(100)); // Adjust the delay as needed
+        vTaskDelay(pdMS_TO_TICKS(settingU32(Setting::DigitalPeriodMs)));
+    }
+}
+
+void SensorHandler::discoveryTask(void *parameter)
+{
+    for (;;)
+    {
+        // Only rescan and update board LEDs when nobody else is using the bus
+        if (xSemaphoreTake(i2cMutex, 0) == pdTRUE)
+        {
+            deviceBus.discoveryStep();
+            deviceBus.flushLEDs();
+            xSemaphoreGive(i2cMutex);
+        }
+        vTaskDelay(pdMS_TO_TICKS(DISCOVERY_PERIOD_MS));
+    }
+}
+
+void SensorHandler::orientationTask(void *parameter)
+{
+    MahonyAHRS ahrs(AHRS_KP, AHRS_KI);
+    const TickType_t period = pdMS_TO_TICKS(1000 / AHRS_SAMPLE_RATE_HZ);
+    const float nominalDt = 1.0f / AHRS_SAMPLE_RATE_HZ;
+    TickType_t lastWake = xTaskGetTickCount();
+    uint64_t lastSampleTime = 0;
+    uint32_t lastPublish = 0;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&lastWake, period);
+
+        if (xSemaphoreTake(i2cMutex, portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+        DeviceBus::Bmi088Data data = deviceBus.getBmi088Sensor();
+        xSemaphoreGive(i2cMutex);
+
+        portENTER_CRITICAL(&imuMux);
+        latestImu = data;
+        latestImuValid = true;
+        portEXIT_CRITICAL(&imuMux);
+
+        // Raw streams go through their filters at the full sample rate
+        float accel[3] = {data.accel.x, data.accel.y, data.accel.z};
+        if (filterStream(StreamKind::Accel, 0, 0, accel, 3))
+        {
+            JsonDocument doc;
+            doc["x"] = accel[0];
+            doc["y"] = accel[1];
+            doc["z"] = accel[2];
+            serialio.publish(3, doc);
+
+            doc.clear();
+            doc["t"] = data.temperature;
+            doc["ti"] = data.time;
+            serialio.publish(5, doc);
+        }
+
+        float gyro[3] = {data.gyro.x, data.gyro.y, data.gyro.z};
+        if (filterStream(StreamKind::Gyro, 0, 0, gyro, 3))
+        {
+            JsonDocument doc;
+            doc["x"] = gyro[0];
+            doc["y"] = gyro[1];
+            doc["z"] = gyro[2];
+            serialio.publish(4, doc);
+        }
+
+#if AHRS_ENABLED
+        // Prefer the sensor's own clock, fall back to the nominal period when it wraps or stalls
+        float dt = nominalDt;
+        if (lastSampleTime != 0 && data.time > lastSampleTime)
+        {
+            float measured = (data.time - lastSampleTime) * 1e-12f;
+            if (measured < 4.0f * nominalDt)
+            {
+                dt = measured;
+            }
+        }
+        lastSampleTime = data.time;
+
+        ahrs.update(data.gyro.x, data.gyro.y, data.gyro.z,
+                    data.accel.x, data.accel.y, data.accel.z, dt);
+
+        if (ahrs.isInitialized())
+        {
+            MahonyAHRS::Euler attitude = ahrs.getEuler();
+            portENTER_CRITICAL(&imuMux);
+            latestAttitude = attitude;
+            latestAttitudeValid = true;
+            portEXIT_CRITICAL(&imuMux);
+        }
+
+        uint32_t now = millis();
+        if (!orientationEnabled || !ahrs.isInitialized() || now - lastPublish < orientationIntervalMs)
+        {
+            continue;
+        }
+        lastPublish = now;
+
+        MahonyAHRS::Quaternion q = ahrs.getQuaternion();
+        MahonyAHRS::Euler e = ahrs.getEuler();
+        JsonDocument doc;
+        doc["w"] = q.w;
+        doc["x"] = q.x;
+        doc["y"] = q.y;
+        doc["z"] = q.z;
+        doc["r"] = e.roll;
+        doc["p"] = e.pitch;
+        doc["h"] = e.yaw;
+        serialio.publish(ORIENTATION_CHANNEL, doc);
+#endif
     }
 }
@@ -1,29 +1,83 @@
+#pragma once
 #include <Arduino.h>
+#include <ArduinoJson.h>
 #include "configuration.h"
+#include "device_bus/device_bus.h"
+#include "signal_processing/stream_filter.h"
+#include "orientation/mahony_ahrs.h"
 
 class SensorHandler
 {
 public:
+    enum class StreamKind : uint8_t
+    {
+        Accel,
+        Gyro,
+        Bme280,
+        Analog
+    };
+
     SensorHandler() = default;
     void startSensorHandler();
     void setAnalogInputConfig(uint8_t boardAddress, uint8_t inputIndex, uint32_t intervalMs, bool enabled, const String &name = "");
     void setDigitalInputConfig(uint8_t boardAddress, uint8_t inputIndex, uint32_t intervalMs, bool enabled, const String &name = "");
     void setBME280Config(uint8_t boardAddress, uint32_t intervalMs, bool enabled);
     void setBMI088Config(uint32_t intervalMs, bool enabled);
+    void getBoards(JsonDocument &doc); // Describe the currently attached sensor boards
+    void setOrientationConfig(uint32_t intervalMs, bool enabled);
+    void setI2cSpeed(uint32_t hz); // Waits for the bus to be idle
+    bool setBoardLeds(uint8_t address, uint8_t start, const DeviceBus::RGB *colors, uint8_t count); // Sent by the discovery task
+    bool setBoardLedPattern(uint8_t address, DeviceBus::LedPattern pattern, DeviceBus::RGB color, uint16_t periodMs);
+    bool getLatestImu(DeviceBus::Bmi088Data &data); // Most recent sample from the orientation task
+    bool getLatestAttitude(MahonyAHRS::Euler &attitude, float &yawRate); // Most recent AHRS output, yaw rate in rad/s
+    bool getLatestPressure(float &pressure, uint32_t &sampleMs);        // Most recent pressure from HOLD_DEPTH_ADDRESS
+    bool setStreamFilter(StreamKind kind, uint8_t address, uint8_t index, StreamFilter::Config config);
+    static bool parseStreamKind(const char *name, StreamKind &kind);
 
 private:
     SemaphoreHandle_t i2cMutex = NULL; // Mutex for I2C operations
-    TaskHandle_t bmi088TaskHandle = NULL;
     TaskHandle_t bme280TaskHandle = NULL;
     TaskHandle_t analogInputTaskHandle = NULL;
     TaskHandle_t digitalInputTaskHandle = NULL;
+    TaskHandle_t discoveryTaskHandle = NULL;
+    TaskHandle_t orientationTaskHandle = NULL;
+
+    portMUX_TYPE imuMux = portMUX_INITIALIZER_UNLOCKED; // Guards latestImu across cores
+    DeviceBus::Bmi088Data latestImu;
+    bool latestImuValid = false;
+    MahonyAHRS::Euler latestAttitude = {0.0f, 0.0f, 0.0f};
+    bool latestAttitudeValid = false;
+    float latestPressure = 0.0f;
+    uint32_t latestPressureMs = 0; // 0 until the first sample arrived
+    volatile uint32_t orientationIntervalMs = AHRS_PUBLISH_PERIOD_MS;
+    volatile bool orientationEnabled = AHRS_ENABLED;
+
+    struct FilteredStream
+    {
+        bool used = false;
+        StreamKind kind;
+        uint8_t address;
+        uint8_t index;
+        StreamFilter filters[3]; // One filter per value in the stream
+    };
+    FilteredStream filteredStreams[FILTER_MAX_STREAMS];
+    portMUX_TYPE filterMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Run values through the stream's filter in place, returns true when they should be published
+    bool filterStream(StreamKind kind, uint8_t address, uint8_t index, float *values, uint8_t count);
+    bool hasStreamFilter(StreamKind kind, uint8_t address, uint8_t index);
+    void releaseStreamFilters(uint8_t address); // Board streams of a detached board
+    FilteredStream *findStream(StreamKind kind, uint8_t address, uint8_t index);
+    static float streamSampleRate(StreamKind kind);
 
-    void bmi088SensorTask(void *parameter);
-    static void bmi088SensorTaskWrapper(void *parameter);
     void bme280SensorTask(void *parameter);
     static void bme280SensorTaskWrapper(void *parameter);
     void analogInputTask(void *parameter);
     static void analogInputTaskWrapper(void *parameter);
     void digitalInputTask(void *parameter);
     static void digitalInputTaskWrapper(void *parameter);
+    void discoveryTask(void *parameter);
+    static void discoveryTaskWrapper(void *parameter);
+    void orientationTask(void *parameter);
+    static void orientationTaskWrapper(void *parameter);
 };
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "alloc_tracker.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_sys.h"
+#include "tasks/command_registry.h"
+
+// Constant initialized, so allocations made before the constructors run are already counted
+AllocTracker allocTracker;
+
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+    void __real_free(void *ptr);
+
+    void *__wrap_malloc(size_t size)
+    {
+        void *ptr = __real_malloc(size);
+#if ALLOC_TRACKING_ENABLED
+        if (ptr != nullptr)
+        {
+            allocTracker.recordAlloc(heap_caps_get_allocated_size(ptr), __builtin_return_address(0));
+        }
+#endif
+        return ptr;
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        void *ptr = __real_calloc(count, size);
+#if ALLOC_TRACKING_ENABLED
+        if (ptr != nullptr)
+        {
+            allocTracker.recordAlloc(heap_caps_get_allocated_size(ptr), __builtin_return_address(0));
+        }
+#endif
+        return ptr;
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+#if ALLOC_TRACKING_ENABLED
+        size_t previous = ptr != nullptr ? heap_caps_get_allocated_size(ptr) : 0;
+        void *result = __real_realloc(ptr, size);
+        // Counted as a free of the old block and an allocation of the new one
+        if (result != nullptr || size == 0)
+        {
+            if (ptr != nullptr)
+            {
+                allocTracker.recordFree(previous);
+            }
+            if (result != nullptr)
+            {
+                allocTracker.recordAlloc(heap_caps_get_allocated_size(result), __builtin_return_address(0));
+            }
+        }
+        return result;
+#else
+        return __real_realloc(ptr, size);
+#endif
+    }
+
+    void __wrap_free(void *ptr)
+    {
+#if ALLOC_TRACKING_ENABLED
+        if (ptr != nullptr)
+        {
+            allocTracker.recordFree(heap_caps_get_allocated_size(ptr));
+        }
+#endif
+        __real_free(ptr);
+    }
+}
+
+AllocTracker::TaskStats &AllocTracker::slot()
+{
+    TaskHandle_t task = xPortInIsrContext() ? nullptr : xTaskGetCurrentTaskHandle();
+    if (task == nullptr)
+    {
+        return tasks[0];
+    }
+    for (size_t i = 1; i < taskCount; ++i)
+    {
+        if (tasks[i].handle == task)
+        {
+            return tasks[i];
+        }
+    }
+    if (taskCount == ALLOC_TRACK_MAX_TASKS)
+    {
+        return tasks[0];
+    }
+    // Deleted tasks keep their entry, handles are rarely reused on this firmware
+    TaskStats &entry = tasks[taskCount++];
+    entry.handle = task;
+    strncpy(entry.name, pcTaskGetTaskName(task), sizeof(entry.name) - 1);
+    return entry;
+}
+
+void AllocTracker::recordAlloc(size_t bytes, void *caller)
+{
+    bool abortNow = false;
+    portENTER_CRITICAL_SAFE(&mux);
+    TaskStats &entry = slot();
+    entry.allocs++;
+    entry.bytes += bytes;
+    entry.live += bytes;
+    if (entry.live > entry.peak)
+    {
+        entry.peak = entry.live;
+    }
+    live += bytes;
+    if (live > peak)
+    {
+        peak = live;
+    }
+    if (steadyState)
+    {
+        entry.late++;
+        lastLateCaller = caller;
+        lastLateSize = bytes;
+        lastLateTask = entry.handle;
+        abortNow = ALLOC_STEADY_STATE_ASSERT;
+    }
+    portEXIT_CRITICAL_SAFE(&mux);
+
+    if (abortNow)
+    {
+        esp_rom_printf("Allocation of %u bytes in steady state from %p\n", static_cast<unsigned>(bytes), caller);
+        abort();
+    }
+}
+
+void AllocTracker::recordFree(size_t bytes)
+{
+    portENTER_CRITICAL_SAFE(&mux);
+    TaskStats &entry = slot();
+    entry.frees++;
+    entry.live -= bytes;
+    live -= bytes;
+    portEXIT_CRITICAL_SAFE(&mux);
+}
+
+void AllocTracker::setSteadyState(bool enabled)
+{
+    steadyState = enabled;
+}
+
+void AllocTracker::reset()
+{
+    portENTER_CRITICAL(&mux);
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        tasks[i].allocs = 0;
+        tasks[i].frees = 0;
+        tasks[i].bytes = 0;
+        tasks[i].peak = tasks[i].live;
+        tasks[i].late = 0;
+    }
+    peak = live;
+    lastLateCaller = nullptr;
+    lastLateSize = 0;
+    lastLateTask = nullptr;
+    portEXIT_CRITICAL(&mux);
+}
+
+void AllocTracker::getStats(JsonDocument &doc) const
+{
+    // Copy first, building the JSON allocates and would count against this task
+    TaskStats snapshot[ALLOC_TRACK_MAX_TASKS];
+    portENTER_CRITICAL(&mux);
+    size_t count = taskCount;
+    memcpy(snapshot, tasks, count * sizeof(TaskStats));
+    int32_t totalLive = live;
+    int32_t totalPeak = peak;
+    void *caller = lastLateCaller;
+    size_t size = lastLateSize;
+    TaskHandle_t lateTask = lastLateTask;
+    portEXIT_CRITICAL(&mux);
+
+    doc["en"] = ALLOC_TRACKING_ENABLED;
+    doc["ss"] = static_cast<bool>(steadyState);
+    doc["l"] = totalLive;
+    doc["pk"] = totalPeak;
+    JsonArray taskArray = doc["t"].to<JsonArray>();
+    for (size_t i = 0; i < count; ++i)
+    {
+        JsonObject t = taskArray.add<JsonObject>();
+        t["n"] = i == 0 ? "other" : snapshot[i].name;
+        t["a"] = snapshot[i].allocs;
+        t["f"] = snapshot[i].frees;
+        t["b"] = snapshot[i].bytes;
+        t["l"] = snapshot[i].live;
+        t["pk"] = snapshot[i].peak;
+        t["v"] = snapshot[i].late;
+        if (caller != nullptr && snapshot[i].handle == lateTask)
+        {
+            char pc[11];
+            snprintf(pc, sizeof(pc), "0x%08x", static_cast<unsigned>(reinterpret_cast<uintptr_t>(caller)));
+            t["pc"] = pc;    // Caller of the last steady-state allocation, for addr2line
+            t["sz"] = size;
+        }
+    }
+}
+
+void AllocTracker::begin()
+{
+    commandRegistry.add(Command::GetAlloc, handleGetAlloc);
+    commandRegistry.add(Command::SetAlloc, handleSetAlloc);
+}
+
+int AllocTracker::handleGetAlloc(const JsonDocument &request, JsonDocument &response)
+{
+    allocTracker.getStats(response);
+    return 200;
+}
+
+int AllocTracker::handleSetAlloc(const JsonDocument &request, JsonDocument &response)
+{
+    if (request["r"] | false)
+    {
+        allocTracker.reset();
+    }
+    if (!request["ss"].isNull())
+    {
+        allocTracker.setSteadyState(request["ss"].as<bool>());
+    }
+    return 200;
+}
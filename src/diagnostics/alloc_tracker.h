@@ -0,0 +1,55 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+
+// Counts heap operations per FreeRTOS task. platformio.ini links malloc, calloc, realloc and free
+// through the __wrap_ functions in alloc_tracker.cpp, which forward to the real allocator and
+// record the call here. Sizes are the usable block sizes reported by the heap, live bytes and
+// their peak are charged to the task doing the operation, so memory freed by another task
+// shows up as a negative balance there.
+//
+// In steady-state mode every allocation is a violation: it is counted per task and the last
+// caller is kept, with ALLOC_STEADY_STATE_ASSERT the device aborts instead.
+class AllocTracker
+{
+public:
+    void begin(); // Registers get_alloc and set_alloc
+    void setSteadyState(bool enabled);
+    bool isSteadyState() const { return steadyState; }
+    void reset(); // Clears the counters, the table keeps its tasks
+    void getStats(JsonDocument &doc) const;
+
+    void recordAlloc(size_t bytes, void *caller);
+    void recordFree(size_t bytes);
+
+private:
+    struct TaskStats
+    {
+        TaskHandle_t handle;
+        char name[configMAX_TASK_NAME_LEN];
+        uint32_t allocs;
+        uint32_t frees;
+        uint32_t bytes;  // Total allocated
+        int32_t live;    // Allocated minus freed by this task
+        int32_t peak;    // Highest live
+        uint32_t late;   // Allocations made in steady-state mode
+    };
+
+    TaskStats &slot(); // Entry of the calling task, slot 0 collects ISRs, boot and overflow
+
+    static int handleGetAlloc(const JsonDocument &request, JsonDocument &response);
+    static int handleSetAlloc(const JsonDocument &request, JsonDocument &response);
+
+    TaskStats tasks[ALLOC_TRACK_MAX_TASKS] = {};
+    size_t taskCount = 1;
+    int32_t live = 0;
+    int32_t peak = 0;
+    volatile bool steadyState = false;
+    void *lastLateCaller = nullptr;
+    size_t lastLateSize = 0;
+    TaskHandle_t lastLateTask = nullptr;
+    mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern AllocTracker allocTracker;
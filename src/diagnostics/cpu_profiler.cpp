@@ -0,0 +1,213 @@
+#include "cpu_profiler.h"
+#include "serial_coms/serial_io.h"
+#include "tasks/command_registry.h"
+#include "settings/settings.h"
+
+extern SerialIO serialio;
+
+CpuProfiler cpuProfiler;
+
+void CpuProfiler::begin()
+{
+#if !configGENERATE_RUN_TIME_STATS
+    LOG_WEBSERIALLN("Run-time stats disabled in sdkconfig, CPU loads will read 0");
+#endif
+    commandRegistry.add(Command::GetCpu, handleGetCpu);
+    commandRegistry.add(Command::SetCpuProfile, handleSetCpuProfile);
+
+    BaseType_t taskResult = xTaskCreatePinnedToCore(
+        taskWrapper,
+        "CpuProfilerTask",
+        CPU_PROFILE_TASK_STACK_SIZE,
+        this,
+        CPU_PROFILE_TASK_PRIORITY,
+        NULL,
+        CPU_PROFILE_TASK_CORE);
+    if (taskResult != pdPASS)
+    {
+        LOG_WEBSERIALLN("Failed to create CPU profiler task");
+    }
+}
+
+void CpuProfiler::taskWrapper(void *parameter)
+{
+    CpuProfiler *instance = static_cast<CpuProfiler *>(parameter);
+    instance->task(parameter);
+}
+
+void CpuProfiler::setConfig(uint32_t periodMs, bool streaming)
+{
+    portENTER_CRITICAL(&mux);
+    this->periodMs = periodMs < CPU_PROFILE_MIN_PERIOD_MS ? CPU_PROFILE_MIN_PERIOD_MS : periodMs;
+    this->streaming = streaming;
+    portEXIT_CRITICAL(&mux);
+}
+
+const CpuProfiler::TaskLoad *CpuProfiler::findPrevious(TaskHandle_t handle) const
+{
+    for (size_t i = 0; i < taskCount; ++i)
+    {
+        if (tasks[i].handle == handle)
+        {
+            return &tasks[i];
+        }
+    }
+    return nullptr;
+}
+
+void CpuProfiler::sample()
+{
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, CPU_PROFILE_MAX_TASKS, &total);
+    if (count == 0)
+    {
+        overflowed = true; // uxTaskGetSystemState fills nothing when the array is too small
+        return;
+    }
+
+    uint32_t elapsed = total - lastTotal; // Unsigned, survives one wrap of the counter
+    lastTotal = total;
+    uint16_t cores[portNUM_PROCESSORS];
+    for (uint8_t c = 0; c < portNUM_PROCESSORS; ++c)
+    {
+        cores[c] = 0;
+    }
+
+    for (UBaseType_t i = 0; i < count; ++i)
+    {
+        const TaskStatus_t &s = status[i];
+        TaskLoad &entry = next[i];
+        entry.handle = s.xHandle;
+        strncpy(entry.name, s.pcTaskName, sizeof(entry.name) - 1);
+        entry.name[sizeof(entry.name) - 1] = '\0';
+#if configTASKLIST_INCLUDE_COREID
+        entry.core = s.xCoreID < portNUM_PROCESSORS ? static_cast<int8_t>(s.xCoreID) : -1;
+#else
+        entry.core = -1;
+#endif
+        entry.stack = s.usStackHighWaterMark;
+        entry.counter = s.ulRunTimeCounter;
+
+        // Tasks created during the last period have no baseline and read 0 until the next one
+        const TaskLoad *previous = findPrevious(s.xHandle);
+        uint32_t delta = previous != nullptr ? entry.counter - previous->counter : 0;
+        uint64_t permille = elapsed != 0 ? static_cast<uint64_t>(delta) * 1000 / elapsed : 0;
+        entry.load = permille > 1000 ? 1000 : static_cast<uint16_t>(permille);
+
+        for (uint8_t c = 0; c < portNUM_PROCESSORS; ++c)
+        {
+            if (s.xHandle == xTaskGetIdleTaskHandleForCPU(c))
+            {
+                cores[c] = previous != nullptr ? 1000 - entry.load : 0;
+            }
+        }
+    }
+
+    portENTER_CRITICAL(&mux);
+    memcpy(tasks, next, count * sizeof(TaskLoad));
+    taskCount = count;
+    memcpy(coreLoad, cores, sizeof(coreLoad));
+    elapsedUs = elapsed;
+    overflowed = false;
+    portEXIT_CRITICAL(&mux);
+}
+
+void CpuProfiler::getReport(JsonDocument &doc) const
+{
+    TaskLoad snapshot[CPU_PROFILE_MAX_TASKS];
+    uint16_t cores[portNUM_PROCESSORS];
+    portENTER_CRITICAL(&mux);
+    size_t count = taskCount;
+    memcpy(snapshot, tasks, count * sizeof(TaskLoad));
+    memcpy(cores, coreLoad, sizeof(cores));
+    uint32_t elapsed = elapsedUs;
+    bool overflow = overflowed;
+    portEXIT_CRITICAL(&mux);
+
+    doc["ms"] = elapsed / 1000;
+    JsonArray coreArray = doc["c"].to<JsonArray>();
+    for (uint8_t c = 0; c < portNUM_PROCESSORS; ++c)
+    {
+        coreArray.add(cores[c]);
+    }
+    JsonArray taskArray = doc["t"].to<JsonArray>();
+    for (size_t i = 0; i < count; ++i)
+    {
+        JsonObject t = taskArray.add<JsonObject>();
+        t["n"] = snapshot[i].name;
+        t["c"] = snapshot[i].core;
+        t["u"] = snapshot[i].load;
+        t["s"] = snapshot[i].stack;
+    }
+    if (overflow)
+    {
+        doc["x"] = true;
+    }
+}
+
+void CpuProfiler::getStackHighWater(JsonDocument &doc) const
+{
+    TaskLoad snapshot[CPU_PROFILE_MAX_TASKS];
+    portENTER_CRITICAL(&mux);
+    size_t count = taskCount;
+    memcpy(snapshot, tasks, count * sizeof(TaskLoad));
+    portEXIT_CRITICAL(&mux);
+
+    JsonArray taskArray = doc["tasks"].to<JsonArray>();
+    for (size_t i = 0; i < count; ++i)
+    {
+        JsonObject t = taskArray.add<JsonObject>();
+        t["name"] = snapshot[i].name;
+        t["stack_high_water_mark"] = snapshot[i].stack;
+    }
+}
+
+void CpuProfiler::task(void *parameter)
+{
+    TickType_t lastWake = xTaskGetTickCount();
+    sample(); // Baseline, the first report covers one full period
+
+    for (;;)
+    {
+        portENTER_CRITICAL(&mux);
+        uint32_t period = periodMs;
+        bool stream = streaming;
+        portEXIT_CRITICAL(&mux);
+
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(period));
+        sample();
+
+        if (stream)
+        {
+            JsonDocument doc;
+            getReport(doc);
+            serialio.publish(CPU_PROFILE_CHANNEL, doc);
+        }
+    }
+}
+
+int CpuProfiler::handleGetCpu(const JsonDocument &request, JsonDocument &response)
+{
+    cpuProfiler.getReport(response);
+    return 200;
+}
+
+int CpuProfiler::handleSetCpuProfile(const JsonDocument &request, JsonDocument &response)
+{
+    // Goes through the cpu_ms and cpu_en settings so get_settings stays in sync
+    bool ok = true;
+    if (!request["ms"].isNull())
+    {
+        ok &= setSetting(Setting::CpuProfilePeriodMs, request["ms"]);
+    }
+    if (!request["en"].isNull())
+    {
+        ok &= setSetting(Setting::CpuProfileStream, request["en"]);
+    }
+    if (!ok)
+    {
+        response["error"] = "Invalid profiler configuration";
+        return 400;
+    }
+    return 200;
+}
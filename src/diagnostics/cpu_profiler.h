@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+
+// Samples the FreeRTOS run-time counters every period and keeps the per-task and per-core
+// load of the last period in a preallocated table. Loads are in permille of one core, a
+// core's load is what its idle task did not use. The report is streamed on CPU_PROFILE_CHANNEL
+// when enabled and returned by get_cpu on channel 254.
+class CpuProfiler
+{
+public:
+    void begin();
+    void setConfig(uint32_t periodMs, bool streaming);
+    void getReport(JsonDocument &doc) const;
+    void getStackHighWater(JsonDocument &doc) const; // From the last sample, without allocating a task list
+
+private:
+    struct TaskLoad
+    {
+        TaskHandle_t handle;
+        char name[configMAX_TASK_NAME_LEN];
+        int8_t core;     // -1 for tasks that are not pinned
+        uint16_t load;   // Permille of one core over the last period
+        uint32_t stack;  // Stack high-water mark in bytes
+        uint32_t counter; // Run-time counter at the last sample
+    };
+
+    void sample();
+    const TaskLoad *findPrevious(TaskHandle_t handle) const;
+
+    void task(void *parameter);
+    static void taskWrapper(void *parameter);
+
+    static int handleGetCpu(const JsonDocument &request, JsonDocument &response);
+    static int handleSetCpuProfile(const JsonDocument &request, JsonDocument &response);
+
+    TaskStatus_t status[CPU_PROFILE_MAX_TASKS]; // Only touched by the profiler task
+    TaskLoad next[CPU_PROFILE_MAX_TASKS];       // Table being built by sample()
+    TaskLoad tasks[CPU_PROFILE_MAX_TASKS];      // Last complete sample
+    size_t taskCount = 0;
+    uint16_t coreLoad[portNUM_PROCESSORS] = {};
+    uint32_t lastTotal = 0;
+    uint32_t elapsedUs = 0;
+    bool overflowed = false; // More tasks than CPU_PROFILE_MAX_TASKS, the last sample was skipped
+
+    uint32_t periodMs = CPU_PROFILE_PERIOD_MS;
+    bool streaming = CPU_PROFILE_STREAM;
+    mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern CpuProfiler cpuProfiler;
@@ -0,0 +1,109 @@
+#include "latency_probe.h"
+#include "esp_timer.h"
+
+LatencyProbe latencyProbe;
+
+static const char *DELTA_NAMES[LatencyProbe::NUM_DELTAS] = {"frame", "decode", "post", "take", "pwm", "total"};
+
+uint32_t LatencyProbe::nowUs()
+{
+    return static_cast<uint32_t>(esp_timer_get_time()); // Wraps after ~71 minutes, deltas stay valid
+}
+
+void LatencyProbe::notePush()
+{
+    uint32_t frame = pushed.load(std::memory_order_relaxed);
+    pushUs[frame % PUSH_SLOTS].store(nowUs(), std::memory_order_relaxed);
+    pushed.store(frame + 1, std::memory_order_release);
+}
+
+void LatencyProbe::begin(uint32_t frame, uint32_t frameCompleteUs)
+{
+    uint32_t pushUsOfFrame = pushUs[frame % PUSH_SLOTS].load(std::memory_order_acquire);
+
+    // Skip the trace when PUSH_SLOTS newer delimiters arrived meanwhile and the slot may
+    // already hold the time of another frame
+    if (pushed.load(std::memory_order_acquire) - frame >= PUSH_SLOTS)
+    {
+        return;
+    }
+
+    // A newer command simply replaces a trace that never made it to the PWM
+    stamps[static_cast<uint8_t>(Stage::RingPush)].store(pushUsOfFrame, std::memory_order_relaxed);
+    stamps[static_cast<uint8_t>(Stage::FrameComplete)].store(frameCompleteUs, std::memory_order_relaxed);
+    next.store(static_cast<uint8_t>(Stage::Decoded), std::memory_order_release);
+}
+
+void LatencyProbe::mark(Stage stage)
+{
+    uint8_t s = static_cast<uint8_t>(stage);
+    if (next.load(std::memory_order_acquire) != s)
+    {
+        return; // Cheap early out, most calls are not part of a trace
+    }
+    uint32_t now = nowUs();
+    stamps[s].store(now, std::memory_order_relaxed);
+
+    uint8_t expected = s;
+    if (!next.compare_exchange_strong(expected, static_cast<uint8_t>(s + 1), std::memory_order_acq_rel))
+    {
+        return;
+    }
+    if (stage != Stage::PwmWrite)
+    {
+        return;
+    }
+
+    // Trace complete, next is now COUNT so nothing else is recorded until the next begin()
+    for (uint8_t i = 1; i < static_cast<uint8_t>(Stage::COUNT); ++i)
+    {
+        record(i - 1, stamps[i].load(std::memory_order_relaxed) - stamps[i - 1].load(std::memory_order_relaxed));
+    }
+    record(NUM_DELTAS - 1, now - stamps[0].load(std::memory_order_relaxed));
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyProbe::record(uint8_t delta, uint32_t us)
+{
+    uint8_t bucket = 0;
+    while (bucket < LATENCY_HISTOGRAM_BUCKETS - 1 && (us >> bucket) != 0)
+    {
+        ++bucket;
+    }
+    buckets[delta][bucket].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t previous = maxUs[delta].load(std::memory_order_relaxed);
+    while (us > previous && !maxUs[delta].compare_exchange_weak(previous, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyProbe::getStats(JsonDocument &doc) const
+{
+    doc["n"] = count.load(std::memory_order_relaxed);
+    JsonObject stages = doc["stages"].to<JsonObject>();
+    for (uint8_t d = 0; d < NUM_DELTAS; ++d)
+    {
+        JsonObject stage = stages[DELTA_NAMES[d]].to<JsonObject>();
+        stage["max"] = maxUs[d].load(std::memory_order_relaxed);
+        JsonArray hist = stage["h"].to<JsonArray>();
+        for (uint8_t b = 0; b < LATENCY_HISTOGRAM_BUCKETS; ++b)
+        {
+            hist.add(buckets[d][b].load(std::memory_order_relaxed));
+        }
+    }
+}
+
+void LatencyProbe::reset()
+{
+    next.store(static_cast<uint8_t>(Stage::COUNT), std::memory_order_release);
+    for (uint8_t d = 0; d < NUM_DELTAS; ++d)
+    {
+        for (uint8_t b = 0; b < LATENCY_HISTOGRAM_BUCKETS; ++b)
+        {
+            buckets[d][b].store(0, std::memory_order_relaxed);
+        }
+        maxUs[d].store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+}
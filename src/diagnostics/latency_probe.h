@@ -0,0 +1,60 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <atomic>
+#include "configuration.h"
+
+// Traces one motor command at a time from the UART to the PWM latch. Each stage stamps a
+// monotonic microsecond time, and when the command reaches the PWM the delta between
+// consecutive stages is added to a log2 histogram (bucket n holds deltas below 2^n us).
+class LatencyProbe
+{
+public:
+    enum class Stage : uint8_t
+    {
+        RingPush,      // Frame delimiter pushed into the rx ring by the UART callback
+        FrameComplete, // Delimiter popped by the serial task
+        Decoded,       // MsgPack decoded into a JsonDocument
+        Posted,        // Setpoints posted to the motor mailbox
+        Taken,         // Setpoints taken by the motor task
+        PwmWrite,      // Duties latched by the next profile step
+        COUNT
+    };
+
+    static constexpr uint8_t NUM_DELTAS = static_cast<uint8_t>(Stage::COUNT); // One per stage transition, plus the total
+
+    // Delimiters are numbered in the order they enter the rx ring, the serial task pops them in
+    // the same order, so a frame finds its own push time even when later frames are queued behind it
+    void notePush();                                      // UART callback, stamps the next delimiter
+    uint32_t notePop() { return popped++; }               // Serial task, number of the delimiter just popped
+    void begin(uint32_t frame, uint32_t frameCompleteUs); // Start a trace for a frame of the traced channel
+    void mark(Stage stage);                               // Ignored unless the trace is waiting for this stage
+
+    void getStats(JsonDocument &doc) const;
+    void reset();
+
+    static uint32_t nowUs();
+
+private:
+    void record(uint8_t delta, uint32_t us);
+
+    static constexpr uint32_t PUSH_SLOTS = 16; // Delimiters that may wait in the rx ring, power of two
+
+    std::atomic<uint32_t> pushUs[PUSH_SLOTS];
+    std::atomic<uint32_t> pushed{0}; // Delimiters pushed, written by the UART callback only
+    uint32_t popped = 0;             // Delimiters popped, serial task only
+    std::atomic<uint32_t> stamps[static_cast<uint8_t>(Stage::COUNT)];
+    std::atomic<uint8_t> next{static_cast<uint8_t>(Stage::COUNT)}; // Stage the trace waits for, COUNT when idle
+
+    std::atomic<uint32_t> buckets[NUM_DELTAS][LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<uint32_t> maxUs[NUM_DELTAS];
+    std::atomic<uint32_t> count{0};
+};
+
+extern LatencyProbe latencyProbe;
+
+#if LATENCY_PROBE_ENABLED
+#define LATENCY_MARK(stage) latencyProbe.mark(LatencyProbe::Stage::stage)
+#else
+#define LATENCY_MARK(stage) ((void)0)
+#endif
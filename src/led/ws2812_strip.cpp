@@ -0,0 +1,64 @@
+#include "ws2812_strip.h"
+
+#define WS2812_RMT_CLK_DIV 2 // 25 ns ticks with the 80 MHz APB clock
+
+// Bit timings in 25 ns ticks, within the WS2812B tolerances of +-150 ns
+static const uint16_t T0H = 16; // 0.40 us
+static const uint16_t T0L = 34; // 0.85 us
+static const uint16_t T1H = 32; // 0.80 us
+static const uint16_t T1L = 18; // 0.45 us
+
+#if ESC_PROTOCOL_IS_DSHOT
+static_assert(LED_RMT_CHANNEL < DSHOT_RMT_CHANNEL_BASE, "The LED RMT channel overlaps the DShot channels");
+#endif
+
+bool Ws2812Strip::begin(int gpio, rmt_channel_t channel)
+{
+    channel_ = channel;
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(static_cast<gpio_num_t>(gpio), channel_);
+    config.clk_div = WS2812_RMT_CLK_DIV;
+    config.tx_config.idle_output_en = true;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW; // Held low between frames, which is the latch
+
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel_, 0, 0) != ESP_OK)
+    {
+        LOG_WEBSERIALLN("Failed to configure the LEDs on RMT channel " + String(channel_));
+        return false;
+    }
+    return true;
+}
+
+bool Ws2812Strip::ready() const
+{
+    return !started_ || rmt_wait_tx_done(channel_, 0) == ESP_OK;
+}
+
+bool Ws2812Strip::show(const Color *colors, size_t count, uint8_t brightness)
+{
+    if (!ready())
+    {
+        return false;
+    }
+    count = count < NUM_LEDS ? count : NUM_LEDS;
+
+    rmt_item32_t *item = items_;
+    for (size_t i = 0; i < count; ++i)
+    {
+        // WS2812 expects green, red, blue, most significant bit first
+        const uint8_t channels[3] = {colors[i].g, colors[i].r, colors[i].b};
+        for (uint8_t c = 0; c < 3; ++c)
+        {
+            uint8_t value = (static_cast<uint16_t>(channels[c]) * (brightness + 1)) >> 8;
+            for (int bit = 7; bit >= 0; --bit, ++item)
+            {
+                bool one = value & (1 << bit);
+                item->level0 = 1;
+                item->duration0 = one ? T1H : T0H;
+                item->level1 = 0;
+                item->duration1 = one ? T1L : T0L;
+            }
+        }
+    }
+    started_ = rmt_write_items(channel_, items_, count * BITS_PER_LED, false) == ESP_OK;
+    return started_;
+}
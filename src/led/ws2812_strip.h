@@ -0,0 +1,29 @@
+#pragma once
+#include <Arduino.h>
+#include "driver/rmt.h"
+#include "configuration.h"
+
+// WS2812 output on one RMT channel. show() encodes the frame and starts the transfer without
+// waiting for it, the RMT driver streams the items from items_ so a new frame is only accepted
+// once the previous one is out.
+class Ws2812Strip
+{
+public:
+    struct Color
+    {
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+    };
+
+    static constexpr size_t BITS_PER_LED = 24;
+
+    bool begin(int gpio, rmt_channel_t channel);
+    bool ready() const;                                        // Previous frame fully sent
+    bool show(const Color *colors, size_t count, uint8_t brightness); // False while the previous frame is still being sent
+
+private:
+    rmt_channel_t channel_ = RMT_CHANNEL_0;
+    bool started_ = false;
+    rmt_item32_t items_[NUM_LEDS * BITS_PER_LED];
+};
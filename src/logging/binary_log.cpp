@@ -0,0 +1,163 @@
+#include "binary_log.h"
+#include "serial_coms/serial_io.h"
+
+BinaryLog binaryLog;
+extern SerialIO serialio;
+
+void BinaryLog::begin()
+{
+#if BINARY_LOG_ENABLED
+    xTaskCreatePinnedToCore(
+        drainTaskWrapper,
+        "BinaryLogTask",
+        BINARY_LOG_TASK_STACK_SIZE,
+        this,
+        BINARY_LOG_TASK_PRIORITY,
+        nullptr,
+        1);
+#endif
+}
+
+void BinaryLog::getFormats(JsonDocument &doc)
+{
+    JsonArray formats = doc["f"].to<JsonArray>();
+    for (const char *format : LOG_FORMAT_STRINGS)
+    {
+        formats.add(format);
+    }
+    JsonArray levels = doc["v"].to<JsonArray>();
+    for (uint8_t formatLevel : LOG_FORMAT_LEVELS)
+    {
+        levels.add(formatLevel);
+    }
+    doc["lvl"] = getLevel();
+}
+
+size_t BinaryLog::format(const LogRecord &record, char *buffer, size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (record.id >= static_cast<uint16_t>(LogId::COUNT))
+    {
+        return snprintf(buffer, size, "Unknown log id %u", record.id);
+    }
+
+    // Walk the format string and substitute one argument word per conversion
+    const char *fmt = LOG_FORMAT_STRINGS[record.id];
+    size_t out = 0;
+    uint8_t arg = 0;
+    while (*fmt && out + 1 < size)
+    {
+        if (*fmt != '%')
+        {
+            buffer[out++] = *fmt++;
+            continue;
+        }
+
+        char spec[16];
+        size_t len = 0;
+        spec[len++] = *fmt++;
+        while (*fmt && strchr("0123456789.-+# ", *fmt) && len < sizeof(spec) - 2)
+        {
+            spec[len++] = *fmt++;
+        }
+        char conversion = *fmt ? *fmt++ : '\0';
+        spec[len++] = conversion;
+        spec[len] = '\0';
+
+        int written;
+        if (conversion == '%')
+        {
+            written = snprintf(buffer + out, size - out, "%%");
+        }
+        else if (arg >= record.argc)
+        {
+            written = snprintf(buffer + out, size - out, "?");
+        }
+        else if (strchr("feEgG", conversion))
+        {
+            float value;
+            memcpy(&value, &record.args[arg++], sizeof(value));
+            written = snprintf(buffer + out, size - out, spec, value);
+        }
+        else if (conversion == 'd' || conversion == 'i')
+        {
+            written = snprintf(buffer + out, size - out, "%d", (int)(int32_t)record.args[arg++]);
+        }
+        else
+        {
+            written = snprintf(buffer + out, size - out, spec, (unsigned)record.args[arg++]);
+        }
+        if (written < 0)
+        {
+            break;
+        }
+        out += (size_t)written;
+    }
+    out = out < size ? out : size - 1;
+    buffer[out] = '\0';
+    return out;
+}
+
+void BinaryLog::drainTaskWrapper(void *parameter)
+{
+    BinaryLog *instance = static_cast<BinaryLog *>(parameter);
+    instance->drainTask();
+}
+
+void BinaryLog::drainTask()
+{
+    LogRecord record;
+    uint32_t reportedDrops = 0;
+
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(BINARY_LOG_DRAIN_PERIOD_MS));
+
+#if USE_WEBSERIAL
+        char line[160];
+        while (ring.pop(record))
+        {
+            format(record, line, sizeof(line));
+            webSerial.println(line);
+        }
+#else
+        // Batch records into one frame per drain: [timestamp_us, id, args...]
+        while (true)
+        {
+            JsonDocument doc;
+            JsonArray records = doc["l"].to<JsonArray>();
+            uint8_t count = 0;
+            while (count < BINARY_LOG_BATCH_SIZE && ring.pop(record))
+            {
+                JsonArray entry = records.add<JsonArray>();
+                entry.add(record.timestampUs);
+                entry.add(record.id);
+                for (uint8_t i = 0; i < record.argc; ++i)
+                {
+                    entry.add(record.args[i]);
+                }
+                ++count;
+            }
+
+            uint32_t drops = ring.dropped();
+            if (count == 0 && drops == reportedDrops)
+            {
+                break;
+            }
+            if (drops != reportedDrops)
+            {
+                doc["d"] = drops - reportedDrops;
+                reportedDrops = drops;
+            }
+            serialio.publish(BINARY_LOG_CHANNEL, doc);
+            if (count < BINARY_LOG_BATCH_SIZE)
+            {
+                break;
+            }
+        }
+#endif
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+#include "log_formats.h"
+#include "log_ring.h"
+
+// Deferred structured logging. Call sites record a format id and raw 32 bit arguments
+// into a lock-free ring, a low priority task drains the ring over the link (or WebSerial)
+// in idle time. Formatting happens on the host so logging costs a few stores per call.
+class BinaryLog
+{
+public:
+    void begin();
+
+    // False when the record is above the runtime level or the ring is full
+    template <typename... Args>
+    bool write(LogId id, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_RING_MAX_ARGS, "Too many arguments for a deferred log record");
+        if (LOG_FORMAT_LEVELS[static_cast<uint16_t>(id)] > level.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        uint32_t words[sizeof...(Args) + 1] = {toWord(args)...};
+        return ring.push(micros(), static_cast<uint16_t>(id), words, sizeof...(Args));
+    }
+
+    void setLevel(uint8_t newLevel) { level.store(newLevel, std::memory_order_relaxed); } // esp_log_level_t
+    uint8_t getLevel() const { return level.load(std::memory_order_relaxed); }
+
+    void getFormats(JsonDocument &doc); // Format table and levels for the host, indexed by id
+    uint32_t dropped() const { return ring.dropped(); }
+
+    // Format a record on the device, only used for the WebSerial sink
+    static size_t format(const LogRecord &record, char *buffer, size_t size);
+
+private:
+    static uint32_t toWord(float value)
+    {
+        uint32_t word;
+        memcpy(&word, &value, sizeof(word));
+        return word;
+    }
+    static uint32_t toWord(double value) { return toWord(static_cast<float>(value)); }
+    template <typename T>
+    static uint32_t toWord(T value) { return static_cast<uint32_t>(value); }
+
+    static void drainTaskWrapper(void *parameter);
+    void drainTask();
+
+    LogRing<BINARY_LOG_CAPACITY> ring;
+    std::atomic<uint8_t> level{LOG_LEVEL};
+};
+
+extern BinaryLog binaryLog;
+
+#if BINARY_LOG_ENABLED
+#define LOG_DEFERRED(id, ...) binaryLog.write(LogId::id, ##__VA_ARGS__)
+#else
+#define LOG_DEFERRED(id, ...) ((void)0)
+#endif
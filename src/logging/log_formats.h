@@ -0,0 +1,44 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_log.h"
+
+// Format strings for deferred logging. Only the index of the format string and the raw
+// arguments are recorded on the device, the host formats them. Arguments are 32 bit words,
+// floats are stored as their IEEE-754 bits and matched to %f, %e or %g.
+// Each entry has an ESP log level, records above the runtime level (the log_lvl setting) are
+// not recorded, so per-sample entries only cost link bandwidth at ESP_LOG_VERBOSE.
+// Append new entries at the end so host-side tables stay valid across firmware versions.
+#define LOG_FORMATS(X)                                                                                                      \
+    X(BMI088_SAMPLE, ESP_LOG_VERBOSE, "BMI088 -> Accel: (%f, %f, %f), Gyro: (%f, %f, %f), Temp: %f")                        \
+    X(BME280_BUILTIN_SAMPLE, ESP_LOG_VERBOSE, "Built-in BME280 -> Hum: %f, Temp: %f, Press: %f")                            \
+    X(BME280_BOARD_SAMPLE, ESP_LOG_VERBOSE, "BME280 at address 0x%x -> Hum: %f, Temp: %f, Press: %f")                       \
+    X(BOARD_LED_SET, ESP_LOG_DEBUG, "Set LED at address 0x%x index %u to color (%u, %u, %u)")                               \
+    X(BOARD_NOT_FOUND, ESP_LOG_WARN, "No sensor board found at address 0x%x")                                               \
+    X(BOARD_TRANSACTION_FAILED, ESP_LOG_WARN, "Transaction with sensor board at address 0x%x failed, %u consecutive")       \
+    X(SERIAL_CRC_MISMATCH, ESP_LOG_WARN, "CRC mismatch on channel %u")                                                      \
+    X(SERIAL_DECODE_FAILED, ESP_LOG_WARN, "MsgPack decoding failed on channel %u")                                          \
+    X(SERIAL_BUFFER_OVERFLOW, ESP_LOG_ERROR, "Buffer overflow, clearing buffer")                                            \
+    X(SERIAL_RING_OVERFLOW, ESP_LOG_ERROR, "Ring buffer overflow")                                                          \
+    X(BOARD_LED_FLUSH, ESP_LOG_DEBUG, "Sent %u LEDs (0 for a pattern) to sensor board at address 0x%x")                     \
+    X(COMMAND_REJECTED, ESP_LOG_ERROR, "Command with opcode %u registered twice or the registry is full")
+
+enum class LogId : uint16_t
+{
+#define LOG_FORMAT_ID(id, level, format) id,
+    LOG_FORMATS(LOG_FORMAT_ID)
+#undef LOG_FORMAT_ID
+        COUNT
+};
+
+static constexpr const char *LOG_FORMAT_STRINGS[] = {
+#define LOG_FORMAT_STRING(id, level, format) format,
+    LOG_FORMATS(LOG_FORMAT_STRING)
+#undef LOG_FORMAT_STRING
+};
+
+static constexpr uint8_t LOG_FORMAT_LEVELS[] = {
+#define LOG_FORMAT_LEVEL(id, level, format) level,
+    LOG_FORMATS(LOG_FORMAT_LEVEL)
+#undef LOG_FORMAT_LEVEL
+};
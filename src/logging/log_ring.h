@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LOG_RING_MAX_ARGS 8 // Maximum number of 32 bit arguments per record
+
+// A single deferred log entry, the format string is referenced by id
+struct LogRecord
+{
+    uint32_t timestampUs;
+    uint16_t id;
+    uint8_t argc;
+    uint32_t args[LOG_RING_MAX_ARGS];
+};
+
+// Bounded lock-free ring of log records. Any task or ISR may push, a single drain task pops.
+// Each slot carries a sequence number so producers never block each other (Vyukov style queue).
+template <size_t Capacity>
+class LogRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    LogRing() : enqueuePos_(0), dequeuePos_(0), dropped_(0)
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(uint32_t timestampUs, uint16_t id, const uint32_t *args, uint8_t argc)
+    {
+        uint32_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+            slot = &slots_[pos & (Capacity - 1)];
+            uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0)
+            {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed); // Full, never block the caller
+                return false;
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        argc = argc > LOG_RING_MAX_ARGS ? LOG_RING_MAX_ARGS : argc;
+        slot->record.timestampUs = timestampUs;
+        slot->record.id = id;
+        slot->record.argc = argc;
+        memcpy(slot->record.args, args, argc * sizeof(uint32_t));
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(LogRecord &record)
+    {
+        uint32_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Slot &slot = slots_[pos & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+        {
+            return false; // Empty, or the producer has not finished writing yet
+        }
+        record = slot.record;
+        slot.sequence.store(pos + Capacity, std::memory_order_release);
+        dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence;
+        LogRecord record;
+    };
+
+    Slot slots_[Capacity];
+    std::atomic<uint32_t> enqueuePos_;
+    std::atomic<uint32_t> dequeuePos_;
+    std::atomic<uint32_t> dropped_;
+};
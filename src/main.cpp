@@ -11,6 +11,12 @@
 
 #include "configuration.h"
 #include "tasks/led_control.h"
+#include "logging/binary_log.h"
+#include "serial_coms/telemetry_history.h"
+#include "control/hold_controller.h"
+#include "diagnostics/cpu_profiler.h"
+#include "settings/settings.h"
+#include "diagnostics/alloc_tracker.h"
 
 // SerialIO serialComs;
 extern SerialIO serialio; // Declare the global SerialIO instance
@@ -20,6 +26,7 @@ AsyncWebServer server(80);
 
 #if USE_WEBSERIAL
 WebSerial webSerial;
+volatile uint8_t webSerialLevel = LOG_LEVEL;
 #endif
 
 #if WIFI_ENABLED
@@ -72,22 +79,33 @@ void setup()
     LOG_WEBSERIALLN("ESP32 Bridge starting up...");
     ledControl.setup(); // Initialize LED control
     serialio.begin();   // Initialize serial communication
+    binaryLog.begin();  // Start draining deferred log records
+    telemetryHistory.begin(); // Retain published telemetry for gap backfill
+    setupSettings();          // Restore saved settings before the subsystems read them
 
-    QueueHandle_t *motorTaskQueueHandle = setupMotorControl();         // Initialize motor control
+    CommandMailbox *motorMailboxHandle = setupMotorControl();          // Initialize motor control
     QueueHandle_t *signalingTaskQueueHandle = setupSignalingControl(); // Initialize signaling control
     sensorHandler.startSensorHandler();                                // Start the sensor handler
+    holdController.begin();                                            // Start the depth/heading hold loop
+    cpuProfiler.begin();                                               // Sample per-task CPU load
+    applySettings();                                                   // Push saved settings into the running subsystems
+    allocTracker.begin();                                              // Expose heap accounting
 
-    serialio.subscribe(1, [motorTaskQueueHandle](const JsonDocument &doc)
+    serialio.subscribe(1, [motorMailboxHandle](const JsonDocument &doc)
                        {
                                     // Handle incoming messages on channel 1
-                                    JsonDocument *copy = new JsonDocument;
-                                    *copy = doc;
                                     // LOG_WEBSERIALLN("Received on channel 1: " + doc.as<String>());
-                                    if (xQueueSend(*motorTaskQueueHandle, &copy, 0) != pdPASS) 
-                                    { 
-                                        delete copy;  // Clean up if send fails
+                                    if (motorMailboxHandle != nullptr)
+                                    {
+                                        postMotorCommand(doc); // Overwrites any setpoint the motor task has not applied yet
                                     } });
 
+    serialio.subscribe(WRENCH_CHANNEL, [](const JsonDocument &doc)
+                       { postWrenchCommand(doc); }); // Allocated onto the ESCs by the motor task
+
+    serialio.subscribe(HOLD_CHANNEL, [](const JsonDocument &doc)
+                       { holdController.handleCommand(doc); });
+
     serialio.subscribe(254, [signalingTaskQueueHandle](const JsonDocument &doc)
                        {
                            JsonDocument *copy = new JsonDocument;
@@ -100,6 +118,10 @@ void setup()
 
     // Create a task to handle serial communication
     BaseType_t taskResult = xTaskCreatePinnedToCore(serialTask, "SerialTask", SERIAL_TASK_STACK_SIZE, NULL, SERIAL_TASK_PRIORITY, NULL, 1);
+
+#if ALLOC_STEADY_STATE_AT_BOOT
+    allocTracker.setSteadyState(true); // Every allocation from here on is reported
+#endif
 }
 
 void loop()
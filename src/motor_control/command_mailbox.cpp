@@ -0,0 +1,73 @@
+#include "command_mailbox.h"
+
+CommandMailbox::CommandMailbox()
+{
+    for (auto &slot : slots)
+    {
+        slot.value.store(0, std::memory_order_relaxed);
+        slot.pending.store(false, std::memory_order_relaxed);
+        slot.posted.store(0, std::memory_order_relaxed);
+        slot.skipped.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CommandMailbox::post(uint8_t index, float value)
+{
+    if (index >= NUM_ESC)
+    {
+        return;
+    }
+    Slot &slot = slots[index];
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    slot.value.store(bits, std::memory_order_release);
+    slot.posted.fetch_add(1, std::memory_order_relaxed);
+
+    // If the previous value was never taken it has now been skipped
+    if (slot.pending.exchange(true, std::memory_order_acq_rel))
+    {
+        slot.skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CommandMailbox::notify()
+{
+    if (consumer != NULL)
+    {
+        xTaskNotifyGive(consumer);
+    }
+}
+
+bool CommandMailbox::take(uint8_t index, float &value)
+{
+    if (index >= NUM_ESC)
+    {
+        return false;
+    }
+    Slot &slot = slots[index];
+
+    if (!slot.pending.exchange(false, std::memory_order_acq_rel))
+    {
+        return false;
+    }
+    // A writer racing with us can only make the value newer, never older
+    uint32_t bits = slot.value.load(std::memory_order_acquire);
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+void CommandMailbox::setConsumer(TaskHandle_t task)
+{
+    consumer = task;
+}
+
+uint32_t CommandMailbox::getSkipped(uint8_t index) const
+{
+    return index < NUM_ESC ? slots[index].skipped.load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t CommandMailbox::getPosted(uint8_t index) const
+{
+    return index < NUM_ESC ? slots[index].posted.load(std::memory_order_relaxed) : 0;
+}
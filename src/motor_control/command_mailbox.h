@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "configuration.h"
+
+// Latest-value mailbox with one slot per ESC. Writers overwrite the pending setpoint
+// instead of queueing it, so the control task always applies the freshest command and
+// latency is bounded to one command no matter how fast the host sends.
+class CommandMailbox
+{
+public:
+    CommandMailbox();
+
+    void post(uint8_t index, float value); // Safe from any task, overwrites an unapplied value
+    void notify();                         // Wake the consumer once a batch has been posted
+    bool take(uint8_t index, float &value); // Consumer only, returns false when nothing new was posted
+    void setConsumer(TaskHandle_t task);
+
+    uint32_t getSkipped(uint8_t index) const; // Commands overwritten before they were applied
+    uint32_t getPosted(uint8_t index) const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> value; // Float bits of the latest setpoint
+        std::atomic<bool> pending;
+        std::atomic<uint32_t> posted;
+        std::atomic<uint32_t> skipped;
+    };
+
+    Slot slots[NUM_ESC];
+    TaskHandle_t consumer = NULL;
+};
@@ -0,0 +1,98 @@
+#include "dshot_driver.h"
+#include <MycilaWebSerial.h>
+
+#if ESC_PROTOCOL_IS_DSHOT
+
+#define DSHOT_RMT_TICK_HZ (APB_CLK_FREQ / DSHOT_RMT_CLK_DIV)
+
+static_assert(DSHOT_RMT_CHANNEL_BASE + DSHOT_MAX_ESC <= RMT_CHANNEL_MAX, "DSHOT_MAX_ESC does not fit in the RMT channels after DSHOT_RMT_CHANNEL_BASE");
+static_assert(NUM_ESC <= DSHOT_MAX_ESC, "DShot drives at most DSHOT_MAX_ESC ESCs because RMT channel 0 drives the status LEDs, lower NUM_ESC");
+
+DShotDriver::DShotDriver(int pwm_gpio, int channel)
+    : pwm_gpio_(pwm_gpio), channel_(static_cast<rmt_channel_t>(DSHOT_RMT_CHANNEL_BASE + channel))
+{
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX(static_cast<gpio_num_t>(pwm_gpio_), channel_);
+    config.clk_div = DSHOT_RMT_CLK_DIV;
+    config.tx_config.idle_output_en = true;
+    config.tx_config.idle_level = INVERTING_OPTOCOUPLER ? RMT_IDLE_LEVEL_HIGH : RMT_IDLE_LEVEL_LOW;
+
+    if (rmt_config(&config) != ESP_OK || rmt_driver_install(channel_, 0, 0) != ESP_OK)
+    {
+        LOG_WEBSERIALLN("Failed to configure DShot on RMT channel " + String(channel_));
+    }
+    stageThrottle(0.0f);
+}
+
+void DShotDriver::setThrottle(float percent, bool bidirectional)
+{
+    stageThrottle(percent, bidirectional);
+    latch();
+}
+
+void DShotDriver::setDutyUs(uint32_t set_us)
+{
+    if (stageDutyUs(set_us))
+    {
+        latch();
+    }
+}
+
+void DShotDriver::stageThrottle(float percent, bool bidirectional)
+{
+    stageValue(DShotEncoder::throttleToValue(percent, bidirectional));
+}
+
+bool DShotDriver::stageDutyUs(uint32_t set_us)
+{
+    // Ensure the set_us is within the valid range
+    if (set_us < ESC_MIN || set_us > ESC_MAX)
+    {
+        LOG_WEBSERIALLN("setDutyUs: Value out of range, must be between ESC_MIN and ESC_MAX");
+        return false;
+    }
+#if ESC_BIDIRECTIONAL
+    float percent = set_us >= ESC_MID ? (float)(set_us - ESC_MID) / (ESC_MAX - ESC_MID)
+                                      : -(float)(ESC_MID - set_us) / (ESC_MID - ESC_MIN);
+#else
+    float percent = (float)(set_us - ESC_MIN) / (ESC_MAX - ESC_MIN);
+#endif
+    stageThrottle(percent);
+    return true;
+}
+
+void DShotDriver::requestTelemetry()
+{
+    telemetry_ = true;
+    stageValue(value_);
+}
+
+void DShotDriver::stageValue(uint16_t value)
+{
+    static const DShotEncoder::Timing timing = DShotEncoder::timing(ESC_PROTOCOL, DSHOT_RMT_TICK_HZ);
+
+    value_ = value;
+    DShotEncoder::Symbol symbols[DShotEncoder::FRAME_BITS];
+    DShotEncoder::encode(DShotEncoder::makeFrame(value_, telemetry_), timing, symbols);
+
+    const uint32_t active = INVERTING_OPTOCOUPLER ? 0 : 1;
+    for (size_t i = 0; i < DShotEncoder::FRAME_BITS; ++i)
+    {
+        items_[i].level0 = active;
+        items_[i].duration0 = symbols[i].high;
+        items_[i].level1 = !active;
+        items_[i].duration1 = symbols[i].low;
+    }
+}
+
+void DShotDriver::latch()
+{
+    // Waits for the previous frame of this channel if it is still on the wire
+    rmt_write_items(channel_, items_, DShotEncoder::FRAME_BITS, false);
+    if (telemetry_)
+    {
+        telemetry_ = false; // Only the frame just sent carries the request
+        stageValue(value_);
+    }
+}
+
+#endif // ESC_PROTOCOL_IS_DSHOT
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "driver/rmt.h"
+#include "esp_err.h"
+#include "configuration.h"
+#include "dshot_encoder.h"
+
+// DShot output on one RMT channel, with the same interface as ESCDriver so ESCBank can use
+// either. DShot ESCs disarm when frames stop, so the bank resends every frame (CONTINUOUS).
+class DShotDriver
+{
+public:
+    static constexpr bool CONTINUOUS = true;
+
+    DShotDriver(int pwm_gpio, int channel = 0);
+
+    // Set ESC throttle: value in range [-1.0, 1.0] for bidirectional, or [0.0, 1.0] for unidirectional
+    void setThrottle(float percent, bool bidirectional = ESC_BIDIRECTIONAL);
+    void setDutyUs(uint32_t set_us); // Pulse widths are mapped onto the DShot throttle range
+
+    void stageThrottle(float percent, bool bidirectional = ESC_BIDIRECTIONAL);
+    bool stageDutyUs(uint32_t set_us);
+    void latch(); // Transmit the staged frame
+
+    void requestTelemetry(); // Set the telemetry bit on the next frame only
+
+private:
+    void stageValue(uint16_t value);
+
+    int pwm_gpio_;
+    rmt_channel_t channel_;
+    uint16_t value_ = 0;
+    bool telemetry_ = false;
+    rmt_item32_t items_[DShotEncoder::FRAME_BITS];
+};
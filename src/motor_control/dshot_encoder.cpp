@@ -0,0 +1,80 @@
+#include "dshot_encoder.h"
+
+constexpr uint16_t DShotEncoder::MAX_VALUE;
+constexpr uint16_t DShotEncoder::MIN_THROTTLE;
+constexpr uint16_t DShotEncoder::NEUTRAL_3D;
+constexpr size_t DShotEncoder::FRAME_BITS;
+
+uint16_t DShotEncoder::crc(uint16_t valueAndTelemetry)
+{
+    return (valueAndTelemetry ^ (valueAndTelemetry >> 4) ^ (valueAndTelemetry >> 8)) & 0x0F;
+}
+
+uint16_t DShotEncoder::makeFrame(uint16_t value, bool telemetry)
+{
+    if (value > MAX_VALUE)
+    {
+        value = MAX_VALUE;
+    }
+    uint16_t packet = static_cast<uint16_t>((value << 1) | (telemetry ? 1 : 0));
+    return static_cast<uint16_t>((packet << 4) | crc(packet));
+}
+
+uint16_t DShotEncoder::throttleToValue(float percent, bool bidirectional)
+{
+    const float span = static_cast<float>(MAX_VALUE - MIN_THROTTLE);
+    if (!bidirectional)
+    {
+        if (!(percent > 0.0f))
+        {
+            return 0;
+        }
+        if (percent > 1.0f)
+        {
+            percent = 1.0f;
+        }
+        return static_cast<uint16_t>(MIN_THROTTLE + percent * span + 0.5f);
+    }
+
+    // 3D mode: 48-1047 is reverse, 1048-2047 forward, both increasing with speed
+    const float halfSpan = static_cast<float>(NEUTRAL_3D - 1 - MIN_THROTTLE);
+    if (percent > 0.0f)
+    {
+        if (percent > 1.0f)
+        {
+            percent = 1.0f;
+        }
+        return static_cast<uint16_t>(NEUTRAL_3D + percent * halfSpan + 0.5f);
+    }
+    if (percent < 0.0f)
+    {
+        if (percent < -1.0f)
+        {
+            percent = -1.0f;
+        }
+        return static_cast<uint16_t>(MIN_THROTTLE - percent * halfSpan + 0.5f);
+    }
+    return 0;
+}
+
+DShotEncoder::Timing DShotEncoder::timing(uint32_t kbitPerS, uint32_t tickHz)
+{
+    // High time is 3/8 of the bit for a 0 and 3/4 for a 1
+    uint32_t bit = (tickHz + kbitPerS * 500) / (kbitPerS * 1000);
+    Timing t;
+    t.bit = static_cast<uint16_t>(bit);
+    t.t0h = static_cast<uint16_t>((bit * 3 + 4) / 8);
+    t.t1h = static_cast<uint16_t>((bit * 3 + 2) / 4);
+    return t;
+}
+
+void DShotEncoder::encode(uint16_t frame, const Timing &timing, Symbol (&symbols)[FRAME_BITS])
+{
+    for (size_t i = 0; i < FRAME_BITS; ++i)
+    {
+        bool one = (frame >> (FRAME_BITS - 1 - i)) & 1;
+        uint16_t high = one ? timing.t1h : timing.t0h;
+        symbols[i].high = high;
+        symbols[i].low = static_cast<uint16_t>(timing.bit - high);
+    }
+}
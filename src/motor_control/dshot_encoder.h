@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// DShot frame encoding, free of any hardware dependency so it can be tested on a host.
+// A frame is 16 bits sent MSB first: 11 bit value, telemetry request bit, 4 bit CRC.
+// Values 1-47 are commands, 48-2047 are throttle and 0 means disarmed.
+class DShotEncoder
+{
+public:
+    static constexpr uint16_t MAX_VALUE = 2047;
+    static constexpr uint16_t MIN_THROTTLE = 48;
+    static constexpr uint16_t NEUTRAL_3D = 1048; // First forward value in 3D (bidirectional) mode
+    static constexpr size_t FRAME_BITS = 16;
+
+    // One bit on the wire, high time then low time in timer ticks
+    struct Symbol
+    {
+        uint16_t high;
+        uint16_t low;
+    };
+
+    struct Timing
+    {
+        uint16_t t0h; // High time of a 0 bit
+        uint16_t t1h; // High time of a 1 bit
+        uint16_t bit; // Full bit period
+    };
+
+    static uint16_t crc(uint16_t valueAndTelemetry);
+    static uint16_t makeFrame(uint16_t value, bool telemetry);
+
+    // Throttle in [-1, 1] for bidirectional (3D mode), [0, 1] otherwise. Zero maps to 0
+    // (disarmed) unidirectionally and to 3D neutral, which is also 0, bidirectionally.
+    static uint16_t throttleToValue(float percent, bool bidirectional);
+
+    // Bit timing for DShot150/300/600 (kbit/s) with a timer running at tickHz
+    static Timing timing(uint32_t kbitPerS, uint32_t tickHz);
+
+    static void encode(uint16_t frame, const Timing &timing, Symbol (&symbols)[FRAME_BITS]);
+};
@@ -0,0 +1,90 @@
+#include "esc_bank.h"
+
+#if ESC_ONESHOT_SYNC && (ESC_PROTOCOL == ESC_PROTOCOL_PWM || ESC_PROTOCOL_IS_DSHOT)
+#error "ESC_ONESHOT_SYNC needs one of the one-shot ESC protocols"
+#endif
+
+void ESCBank::begin()
+{
+    int esc_pins[NUM_ESC] = ESC_PINS;
+    for (size_t i = 0; i < NUM_ESC; ++i)
+    {
+        drivers[i] = new ESCOutput(esc_pins[i], i);
+    }
+    setAllThrottle(0.0f); // Initialize ESCs with 0% throttle
+    commit();
+}
+
+void ESCBank::setThrottle(uint8_t index, float percent)
+{
+    if (index >= NUM_ESC || drivers[index] == nullptr)
+    {
+        return;
+    }
+    drivers[index]->stageThrottle(percent);
+    dirty |= 1u << index;
+}
+
+void ESCBank::setDutyUs(uint8_t index, uint32_t set_us)
+{
+    if (index >= NUM_ESC || drivers[index] == nullptr)
+    {
+        return;
+    }
+    if (drivers[index]->stageDutyUs(set_us))
+    {
+        dirty |= 1u << index;
+    }
+}
+
+void ESCBank::setAllThrottle(float percent)
+{
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        setThrottle(i, percent);
+    }
+}
+
+void ESCBank::commit()
+{
+    if (ESCOutput::CONTINUOUS)
+    {
+        // Frame based protocols have to be resent every period whether or not anything changed
+        for (uint8_t i = 0; i < NUM_ESC; ++i)
+        {
+            drivers[i]->latch();
+        }
+        dirty = 0;
+        return;
+    }
+
+    if (dirty == 0)
+    {
+        return;
+    }
+
+#if ESC_ONESHOT_SYNC
+    // Restarting the period mid pulse would cut it short, the ESC would read a lower throttle
+    uint32_t guard = ESCDriver::pulseGuardUs();
+    if (guard > 0)
+    {
+        delayMicroseconds(guard);
+    }
+#endif
+
+    // Latch every staged channel within a few microseconds of each other, far shorter
+    // than the PWM period, so they all pick up their new duty at the same boundary
+    portENTER_CRITICAL(&latchMux);
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        if (dirty & (1u << i))
+        {
+            drivers[i]->latch();
+        }
+    }
+#if ESC_ONESHOT_SYNC
+    ESCDriver::restartPeriod(); // That boundary is now, every ESC gets its new pulse immediately
+#endif
+    portEXIT_CRITICAL(&latchMux);
+    dirty = 0;
+}
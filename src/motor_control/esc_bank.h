@@ -0,0 +1,32 @@
+#pragma once
+#include <Arduino.h>
+#include "configuration.h"
+#include "esc_driver.h"
+#include "dshot_driver.h"
+
+// Output driver picked at build time by ESC_PROTOCOL
+#if ESC_PROTOCOL_IS_DSHOT
+using ESCOutput = DShotDriver;
+#else
+using ESCOutput = ESCDriver;
+#endif
+
+// Owns all ESC outputs and applies staged setpoints together. With PWM every channel runs
+// off the same LEDC timer and the duty updates are latched back to back, so new thrust values
+// take effect at the same period boundary on the whole vehicle. With DShot every commit sends
+// one frame per ESC.
+class ESCBank
+{
+public:
+    void begin();
+
+    void setThrottle(uint8_t index, float percent); // Staged until commit()
+    void setDutyUs(uint8_t index, uint32_t set_us); // Staged until commit()
+    void setAllThrottle(float percent);             // Staged until commit()
+    void commit();
+
+private:
+    ESCOutput *drivers[NUM_ESC] = {};
+    uint32_t dirty = 0; // Bit per ESC with a staged value
+    portMUX_TYPE latchMux = portMUX_INITIALIZER_UNLOCKED;
+};
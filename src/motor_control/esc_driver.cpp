@@ -1,67 +1,100 @@
 #include "esc_driver.h"
 #include <MycilaWebSerial.h>
+#include "esp_timer.h"
 
-ESCDriver::ESCDriver(int pwm_gpio, uint32_t freq_hz, int resolution_bits, int channel)
-    : pwm_gpio_(pwm_gpio), channel_(channel), freq_hz_(freq_hz), resolution_bits_(resolution_bits)
+#define ESC_LEDC_MODE LEDC_HIGH_SPEED_MODE
+#define ESC_LEDC_TIMER LEDC_TIMER_0
+
+static int64_t periodStartUs = 0; // When the shared LEDC timer last started a period
+
+ESCDriver::ESCDriver(int pwm_gpio, int channel)
+    : pwm_gpio_(pwm_gpio), channel_(static_cast<ledc_channel_t>(channel))
 {
-    // Setup the channel with desired frequency and resolution
-    ledcSetup(channel_, freq_hz_, resolution_bits_);
+    configureTimer();
 
-    // Attach the GPIO to the channel
-    ledcAttachPin(pwm_gpio_, channel_);
+    ledc_channel_config_t config = {};
+    config.gpio_num = pwm_gpio_;
+    config.speed_mode = ESC_LEDC_MODE;
+    config.channel = channel_;
+    config.intr_type = LEDC_INTR_DISABLE;
+    config.timer_sel = ESC_LEDC_TIMER;
+    config.duty = ESCDutyMap::throttleToDuty(0.0f, ESC_BIDIRECTIONAL);
+    config.hpoint = 0;
+    if (ledc_channel_config(&config) != ESP_OK)
+    {
+        LOG_WEBSERIALLN("Failed to configure ESC channel " + String(channel));
+    }
 }
 
-void ESCDriver::setThrottle(float percent, bool bidirectional, float min_us, float max_us, float center_us)
+void ESCDriver::configureTimer()
 {
-    float us;
-    if (bidirectional)
+    static bool configured = false;
+    if (configured)
     {
-        percent = (percent < -1.0f) ? -1.0f : (percent > 1.0f ? 1.0f : percent);
-        if (percent >= 0.0f)
-        {
-            us = center_us + (max_us - center_us) * percent;
-        }
-        else
-        {
-            us = center_us + (center_us - min_us) * percent;
-        }
+        return;
     }
-    else
+
+    ledc_timer_config_t timer = {};
+    timer.speed_mode = ESC_LEDC_MODE;
+    timer.duty_resolution = static_cast<ledc_timer_bit_t>(ESCProtocol::RESOLUTION);
+    timer.timer_num = ESC_LEDC_TIMER;
+    timer.freq_hz = ESCProtocol::FREQ_HZ;
+    timer.clk_cfg = LEDC_AUTO_CLK;
+    if (ledc_timer_config(&timer) != ESP_OK)
     {
-        percent = (percent < 0.0f) ? 0.0f : (percent > 1.0f ? 1.0f : percent);
-        us = min_us + (max_us - min_us) * percent;
+        LOG_WEBSERIALLN("Failed to configure ESC timer");
+        return;
     }
-    uint32_t max_duty = (1 << resolution_bits_) - 1;
-    uint32_t duty = static_cast<uint32_t>((us * max_duty * freq_hz_) / 1000000.0f);
-    if (INVERTING_OPTOCOUPLER)
+    configured = true;
+    restartPeriod(); // The pulse guard measures its phase from here, not from boot
+}
+
+void ESCDriver::setThrottle(float percent, bool bidirectional)
+{
+    stageThrottle(percent, bidirectional);
+    latch();
+}
+
+void ESCDriver::setDutyUs(uint32_t set_us)
+{
+    if (stageDutyUs(set_us))
     {
-        duty = invertDuty(duty);
+        latch();
     }
-    ledcWrite(channel_, duty);
 }
 
-void ESCDriver::setDutyUs(uint32_t set_us)
+void ESCDriver::stageThrottle(float percent, bool bidirectional)
+{
+    ledc_set_duty(ESC_LEDC_MODE, channel_, ESCDutyMap::throttleToDuty(percent, bidirectional));
+}
+
+bool ESCDriver::stageDutyUs(uint32_t set_us)
 {
     // Ensure the set_us is within the valid range
     if (set_us < ESC_MIN || set_us > ESC_MAX)
     {
         LOG_WEBSERIALLN("setDutyUs: Value out of range, must be between ESC_MIN and ESC_MAX");
-        return;
+        return false;
     }
+    ledc_set_duty(ESC_LEDC_MODE, channel_, ESCDutyMap::nsToDuty(ESCProtocol::pulseNs(set_us)));
+    return true;
+}
 
-    // Convert microseconds to duty cycle
-    uint32_t max_duty = (1 << resolution_bits_) - 1;
-    uint32_t duty = static_cast<uint32_t>((set_us * max_duty * freq_hz_) / 1000000.0f);
-    // Invert the duty cycle if necessary
-    if (INVERTING_OPTOCOUPLER)
-    {
-        duty = invertDuty(duty);
-    }
-    ledcWrite(channel_, duty);
+void ESCDriver::latch()
+{
+    ledc_update_duty(ESC_LEDC_MODE, channel_);
+}
+
+uint32_t ESCDriver::pulseGuardUs()
+{
+    // Pulses start at the beginning of each period, so the phase tells whether one is on the wire
+    uint64_t elapsedNs = static_cast<uint64_t>(esp_timer_get_time() - periodStartUs) * 1000;
+    uint32_t phase = static_cast<uint32_t>(elapsedNs % ESCProtocol::PERIOD_NS);
+    return phase <= ESCProtocol::MAX_PULSE_NS ? (ESCProtocol::MAX_PULSE_NS - phase) / 1000 + 1 : 0;
 }
 
-uint32_t ESCDriver::invertDuty(uint32_t duty)
+void ESCDriver::restartPeriod()
 {
-    // Invert the duty cycle if necessary
-    return (1 << resolution_bits_) - 1 - duty;
+    ledc_timer_rst(ESC_LEDC_MODE, ESC_LEDC_TIMER);
+    periodStartUs = esp_timer_get_time();
 }
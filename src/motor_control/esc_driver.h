@@ -3,21 +3,41 @@
 #include "driver/ledc.h"
 #include "esp_err.h"
 #include "configuration.h"
+#include "esc_duty_map.h"
+#include "esc_protocol.h"
+
+// Pulse protocol driven through LEDC, DShot builds keep PWM here since they do not use this driver
+using ESCProtocol = EscPulseProtocol<ESC_PROTOCOL_IS_DSHOT ? ESC_PROTOCOL_PWM : ESC_PROTOCOL>;
+
+// Throttle to duty mapping for the configured ESCs, resolved at compile time
+using ESCDutyMap = EscDutyMap<ESCProtocol::pulseNs(ESC_MIN), ESCProtocol::pulseNs(ESC_MID), ESCProtocol::pulseNs(ESC_MAX),
+                              ESCProtocol::FREQ_HZ, ESCProtocol::RESOLUTION, INVERTING_OPTOCOUPLER>;
 
 class ESCDriver
 {
 public:
-    ESCDriver(int pwm_gpio, uint32_t freq_hz = ESC_PWM_FREQUENCY, int resolution_bits = ESC_PWM_RESOLUTION, int channel = 0);
+    static constexpr bool CONTINUOUS = false; // LEDC repeats the last duty by itself
+
+    // All ESCs share one LEDC timer so their periods start together
+    ESCDriver(int pwm_gpio, int channel = 0);
 
     // Set ESC throttle: value in range [-1.0, 1.0] for bidirectional, or [0.0, 1.0] for unidirectional
-    void setThrottle(float percent, bool bidirectional = ESC_BIDIRECTIONAL, float min_us = ESC_MIN, float max_us = ESC_MAX, float center_us = ESC_MID);
+    void setThrottle(float percent, bool bidirectional = ESC_BIDIRECTIONAL);
     void setDutyUs(uint32_t set_us);
 
+    // Staged writes only take effect on latch(), which applies them at the next period boundary
+    void stageThrottle(float percent, bool bidirectional = ESC_BIDIRECTIONAL);
+    bool stageDutyUs(uint32_t set_us);
+    void latch();
+
+    // Start a new PWM period now so freshly latched duties are output without waiting for the
+    // free running period to end (synchronous one-shot). Waits out a pulse still in progress.
+    static void restartPeriod();
+    static uint32_t pulseGuardUs(); // How long restartPeriod() would have to wait right now
+
 private:
+    static void configureTimer();
+
     int pwm_gpio_;
-    int channel_;
-    int timer_;
-    int freq_hz_;
-    int resolution_bits_;
-    uint32_t invertDuty(uint32_t);
-};
\ No newline at end of file
+    ledc_channel_t channel_;
+};
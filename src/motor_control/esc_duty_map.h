@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+
+// Integer throttle to duty mapping specialised at compile time from the ESC configuration.
+// All scaling constants are folded by the compiler, a conversion costs one float to Q15
+// conversion and a couple of integer multiplies.
+// Pulse widths are given in nanoseconds so the fast one-shot modes keep sub-microsecond precision.
+template <uint32_t MinNs, uint32_t MidNs, uint32_t MaxNs, uint32_t FreqHz, uint8_t ResolutionBits, bool Inverted>
+struct EscDutyMap
+{
+    static_assert(MinNs < MidNs && MidNs < MaxNs, "ESC limits must satisfy MIN < MID < MAX");
+    static_assert(ResolutionBits > 0 && ResolutionBits <= 20, "Unsupported PWM resolution");
+    static_assert((uint64_t)MaxNs * FreqHz < 1000000000ULL, "Pulse does not fit in the PWM period");
+
+    static constexpr uint32_t MAX_DUTY = (1u << ResolutionBits) - 1;
+    static constexpr int32_t THROTTLE_ONE = 32767; // Q15 full scale
+
+    // Duty ticks per nanosecond in Q24, rounded
+    static constexpr uint64_t TICKS_PER_NS_Q24 = ((uint64_t)MAX_DUTY * FreqHz * (1ULL << 24) + 500000000ULL) / 1000000000ULL;
+
+    static constexpr uint32_t nsToDuty(uint32_t ns)
+    {
+        return invert(clampDuty((uint32_t)(((uint64_t)ns * TICKS_PER_NS_Q24 + (1u << 23)) >> 24)));
+    }
+
+    // Throttle in Q15, [-THROTTLE_ONE, THROTTLE_ONE] when bidirectional, [0, THROTTLE_ONE] otherwise.
+    // Interpolates in Q24 duty ticks so no precision is lost to whole nanoseconds.
+    static constexpr uint32_t q15ToDuty(int32_t q, bool bidirectional)
+    {
+        return invert(clampDuty((uint32_t)((
+            (bidirectional
+                 ? (q >= 0 ? MID_Q24 + (UP_SPAN_Q24 * q) / THROTTLE_ONE
+                           : MID_Q24 - (DOWN_SPAN_Q24 * -q) / THROTTLE_ONE)
+                 : MIN_Q24 + (FULL_SPAN_Q24 * q) / THROTTLE_ONE) +
+            (1 << 23)) >> 24)));
+    }
+
+    static int32_t throttleToQ15(float percent, bool bidirectional)
+    {
+        float lo = bidirectional ? -1.0f : 0.0f;
+        percent = (percent < lo) ? lo : (percent > 1.0f ? 1.0f : percent);
+        return (int32_t)(percent * THROTTLE_ONE + (percent >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    static uint32_t throttleToDuty(float percent, bool bidirectional)
+    {
+        return q15ToDuty(throttleToQ15(percent, bidirectional), bidirectional);
+    }
+
+private:
+    static constexpr int64_t MIN_Q24 = (int64_t)MinNs * TICKS_PER_NS_Q24;
+    static constexpr int64_t MID_Q24 = (int64_t)MidNs * TICKS_PER_NS_Q24;
+    static constexpr int64_t UP_SPAN_Q24 = (int64_t)(MaxNs - MidNs) * TICKS_PER_NS_Q24;
+    static constexpr int64_t DOWN_SPAN_Q24 = (int64_t)(MidNs - MinNs) * TICKS_PER_NS_Q24;
+    static constexpr int64_t FULL_SPAN_Q24 = (int64_t)(MaxNs - MinNs) * TICKS_PER_NS_Q24;
+
+    static constexpr uint32_t clampDuty(uint32_t duty) { return duty > MAX_DUTY ? MAX_DUTY : duty; }
+    static constexpr uint32_t invert(uint32_t duty) { return Inverted ? MAX_DUTY - duty : duty; }
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include "configuration.h"
+
+// Timing of the pulse based ESC protocols. Commands are always given as standard 1000-2000 us
+// pulses (ESC_MIN/MID/MAX) and scaled to the protocol's pulse range:
+// pulse_ns = OFFSET_NS + us * 1000 / DIVISOR.
+template <int Protocol>
+struct EscProtocolTraits;
+
+template <>
+struct EscProtocolTraits<ESC_PROTOCOL_PWM>
+{
+    static constexpr uint32_t FREQ_HZ = ESC_PWM_FREQUENCY;
+    static constexpr uint8_t RESOLUTION = ESC_PWM_RESOLUTION;
+    static constexpr int32_t OFFSET_NS = 0;
+    static constexpr uint32_t DIVISOR = 1;
+};
+
+template <>
+struct EscProtocolTraits<ESC_PROTOCOL_ONESHOT125> // 125-250 us
+{
+    static constexpr uint32_t FREQ_HZ = 2000;
+    static constexpr uint8_t RESOLUTION = 15;
+    static constexpr int32_t OFFSET_NS = 0;
+    static constexpr uint32_t DIVISOR = 8;
+};
+
+template <>
+struct EscProtocolTraits<ESC_PROTOCOL_ONESHOT42> // 42-84 us
+{
+    static constexpr uint32_t FREQ_HZ = 8000;
+    static constexpr uint8_t RESOLUTION = 13;
+    static constexpr int32_t OFFSET_NS = 0;
+    static constexpr uint32_t DIVISOR = 24;
+};
+
+template <>
+struct EscProtocolTraits<ESC_PROTOCOL_MULTISHOT> // 5-25 us
+{
+    static constexpr uint32_t FREQ_HZ = 32000;
+    static constexpr uint8_t RESOLUTION = 11;
+    static constexpr int32_t OFFSET_NS = -15000;
+    static constexpr uint32_t DIVISOR = 50;
+};
+
+// LEDC timing for the configured protocol, DShot builds fall back to PWM since they do not use LEDC
+template <int Protocol>
+struct EscPulseProtocol : EscProtocolTraits<Protocol>
+{
+    using Traits = EscProtocolTraits<Protocol>;
+
+    static_assert((1ULL << Traits::RESOLUTION) * Traits::FREQ_HZ <= 80000000ULL, "LEDC cannot reach this frequency at this resolution");
+
+    static constexpr uint32_t pulseNs(uint32_t us)
+    {
+        return (uint32_t)(Traits::OFFSET_NS + (int32_t)(us * 1000u / Traits::DIVISOR));
+    }
+    static constexpr uint32_t PERIOD_NS = 1000000000u / Traits::FREQ_HZ;
+    static constexpr uint32_t MAX_PULSE_NS = (uint32_t)(Traits::OFFSET_NS + (int32_t)(ESC_MAX * 1000u / Traits::DIVISOR));
+};
@@ -0,0 +1,102 @@
+#include "esc_watchdog.h"
+
+bool ESCWatchdog::begin(ExpiryHandler expiryHandler)
+{
+    handler = expiryHandler;
+
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        timeoutMs[i].store(SAFETY_TIMEOUT_MS, std::memory_order_relaxed);
+        trips[i].store(0, std::memory_order_relaxed);
+
+        contexts[i] = {this, i};
+        esp_timer_create_args_t args = {};
+        args.callback = onTimer;
+        args.arg = &contexts[i];
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "esc_failsafe";
+        if (esp_timer_create(&args, &timers[i]) != ESP_OK)
+        {
+            LOG_WEBSERIALLN("Failed to create failsafe timer for ESC " + String(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+void ESCWatchdog::feed(uint8_t index)
+{
+    if (index >= NUM_ESC || timers[index] == nullptr)
+    {
+        return;
+    }
+    uint32_t timeout = timeoutMs[index].load(std::memory_order_relaxed);
+
+    // esp_timer_start_once refuses a running timer, so stop it first
+    esp_timer_stop(timers[index]);
+    tripped.fetch_and(~(1u << index), std::memory_order_acq_rel);
+    if (timeout > 0)
+    {
+        esp_timer_start_once(timers[index], static_cast<uint64_t>(timeout) * 1000ULL);
+    }
+}
+
+bool ESCWatchdog::setTimeoutMs(uint8_t index, uint32_t timeout)
+{
+    if (index >= NUM_ESC)
+    {
+        return false;
+    }
+    timeoutMs[index].store(timeout, std::memory_order_relaxed);
+    if (timeout == 0 && timers[index] != nullptr)
+    {
+        esp_timer_stop(timers[index]);
+    }
+    return true;
+}
+
+uint32_t ESCWatchdog::getTimeoutMs(uint8_t index) const
+{
+    return index < NUM_ESC ? timeoutMs[index].load(std::memory_order_relaxed) : 0;
+}
+
+void ESCWatchdog::setConsumer(TaskHandle_t task)
+{
+    consumer = task;
+}
+
+uint32_t ESCWatchdog::takeExpired()
+{
+    return expired.exchange(0, std::memory_order_acq_rel);
+}
+
+uint32_t ESCWatchdog::getTripped() const
+{
+    return tripped.load(std::memory_order_acquire);
+}
+
+uint32_t ESCWatchdog::getTrips(uint8_t index) const
+{
+    return index < NUM_ESC ? trips[index].load(std::memory_order_relaxed) : 0;
+}
+
+void ESCWatchdog::onTimer(void *arg)
+{
+    TimerContext *context = static_cast<TimerContext *>(arg);
+    ESCWatchdog *self = context->owner;
+    uint8_t index = context->index;
+
+    // Mark the trip before the handler applies the fallback, a writer that checks getTripped()
+    // afterwards is refused and one that checked before is overwritten by the fallback
+    self->tripped.fetch_or(1u << index, std::memory_order_acq_rel);
+    if (self->handler != nullptr)
+    {
+        self->handler(index);
+    }
+    self->trips[index].fetch_add(1, std::memory_order_relaxed);
+    self->expired.fetch_or(1u << index, std::memory_order_acq_rel);
+    if (self->consumer != NULL)
+    {
+        xTaskNotifyGive(self->consumer); // Reporting happens in task context
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+#include "configuration.h"
+
+// Per-ESC failsafe deadline backed by one-shot esp_timers. Each applied command re-arms
+// the deadline of its own ESC, and expiry is handled from the timer itself, so reaction
+// time does not depend on the control task waking up.
+class ESCWatchdog
+{
+public:
+    typedef void (*ExpiryHandler)(uint8_t index);
+
+    bool begin(ExpiryHandler handler);
+
+    void feed(uint8_t index);                          // Re-arm the deadline for one ESC
+    bool setTimeoutMs(uint8_t index, uint32_t timeoutMs); // 0 disables the watchdog for that ESC
+    uint32_t getTimeoutMs(uint8_t index) const;
+    void setConsumer(TaskHandle_t task);                  // Notified after an expiry
+
+    uint32_t takeExpired();                  // Bit per ESC that expired since the last call
+    uint32_t getTripped() const;             // Bit per ESC held at its fallback until the next feed
+    uint32_t getTrips(uint8_t index) const; // Total expiries since boot
+
+private:
+    struct TimerContext
+    {
+        ESCWatchdog *owner;
+        uint8_t index;
+    };
+
+    static void onTimer(void *arg);
+
+    esp_timer_handle_t timers[NUM_ESC] = {};
+    TimerContext contexts[NUM_ESC];
+    std::atomic<uint32_t> timeoutMs[NUM_ESC];
+    std::atomic<uint32_t> trips[NUM_ESC];
+    std::atomic<uint32_t> expired{0};
+    std::atomic<uint32_t> tripped{0};
+    ExpiryHandler handler = nullptr;
+    TaskHandle_t consumer = NULL;
+};
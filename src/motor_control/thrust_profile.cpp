@@ -0,0 +1,95 @@
+#include "thrust_profile.h"
+#include <math.h>
+
+ThrustProfile::ThrustProfile(float initial) : output(initial), target(initial) {}
+
+void ThrustProfile::setLimits(float slewPerS, float accelPerS2)
+{
+    slewLimit = slewPerS > 0.0f ? slewPerS : 0.0f;
+    accelLimit = accelPerS2 > 0.0f ? accelPerS2 : 0.0f;
+}
+
+void ThrustProfile::setTarget(float newTarget)
+{
+    target = newTarget;
+    ramping = false;
+}
+
+void ThrustProfile::rampTo(float newTarget, float durationS)
+{
+    if (durationS <= 0.0f)
+    {
+        setTarget(newTarget);
+        return;
+    }
+    target = newTarget;
+    rampStart = output;
+    rampDuration = durationS;
+    rampElapsed = 0.0f;
+    ramping = true;
+}
+
+void ThrustProfile::reset(float value)
+{
+    output = value;
+    target = value;
+    velocity = 0.0f;
+    ramping = false;
+}
+
+float ThrustProfile::step(float dt)
+{
+    if (dt <= 0.0f)
+    {
+        return output;
+    }
+
+    // Where the setpoint should be right now
+    float desired = target;
+    if (ramping)
+    {
+        rampElapsed += dt;
+        if (rampElapsed >= rampDuration)
+        {
+            ramping = false;
+        }
+        else
+        {
+            desired = rampStart + (target - rampStart) * (rampElapsed / rampDuration);
+        }
+    }
+
+    float error = desired - output;
+    if (error == 0.0f && velocity == 0.0f)
+    {
+        return output;
+    }
+
+    // Velocity that would close the gap in this step, then bounded by the limits
+    float unlimited = error / dt;
+    float v = unlimited;
+    if (slewLimit > 0.0f)
+    {
+        v = fmaxf(-slewLimit, fminf(slewLimit, v));
+    }
+    if (accelLimit > 0.0f)
+    {
+        // Never faster than what still allows stopping at the setpoint
+        float stopping = sqrtf(2.0f * accelLimit * fabsf(error));
+        v = fmaxf(-stopping, fminf(stopping, v));
+
+        float dv = accelLimit * dt;
+        v = fmaxf(velocity - dv, fminf(velocity + dv, v));
+    }
+
+    float next = output + v * dt;
+    if (v == unlimited || (error != 0.0f && (v > 0.0f) == (error > 0.0f) && fabsf(v * dt) >= fabsf(error)))
+    {
+        // Reached the setpoint, only carry velocity along while a ramp is still running
+        next = desired;
+        v = ramping ? v : 0.0f;
+    }
+    output = next;
+    velocity = v;
+    return output;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stdint.h>
+
+// Motion profile for a single ESC. Setpoints are shaped by an optional slew limit
+// (units/s) and acceleration limit (units/s^2), and can be reached over a fixed time
+// with a linear ramp. step() is called from the profile timer at the PWM frame rate.
+class ThrustProfile
+{
+public:
+    explicit ThrustProfile(float initial = 0.0f);
+
+    void setLimits(float slewPerS, float accelPerS2); // 0 disables a limit
+    void setTarget(float target);                      // Cancels a running ramp
+    void rampTo(float target, float durationS);        // Linear ramp, still bounded by the limits
+    void reset(float value);                           // Jump straight to value, used for failsafe
+
+    float step(float dt); // Advance by dt seconds and return the new output
+
+    float getOutput() const { return output; }
+    float getTarget() const { return target; }
+    bool isSettled() const { return !ramping && output == target && velocity == 0.0f; }
+
+private:
+    float output;
+    float velocity = 0.0f;
+    float target;
+
+    float slewLimit = 0.0f;
+    float accelLimit = 0.0f;
+
+    bool ramping = false;
+    float rampStart = 0.0f;
+    float rampDuration = 0.0f;
+    float rampElapsed = 0.0f;
+};
@@ -0,0 +1,122 @@
+#include "mahony_ahrs.h"
+#include <cmath>
+
+// Accelerometer samples whose magnitude differs from 1g by more than this fraction
+// are dominated by linear acceleration and are not used for correction.
+static constexpr float ACCEL_GATE = 0.15f;
+static constexpr float STANDARD_GRAVITY = 9.80665f;
+static constexpr float MAX_BIAS = 0.1f; // rad/s, clamp for the bias integrator
+
+MahonyAHRS::MahonyAHRS(float kp, float ki) : kp_(kp), ki_(ki)
+{
+    reset();
+}
+
+void MahonyAHRS::reset()
+{
+    q_ = {1.0f, 0.0f, 0.0f, 0.0f};
+    bias_ = {0.0f, 0.0f, 0.0f};
+    initialized_ = false;
+}
+
+void MahonyAHRS::setGains(float kp, float ki)
+{
+    kp_ = kp;
+    ki_ = ki;
+}
+
+void MahonyAHRS::alignToGravity(float ax, float ay, float az)
+{
+    // Start from the attitude implied by gravity so the filter does not have to converge from identity
+    float roll = atan2f(ay, az);
+    float pitch = atan2f(-ax, sqrtf(ay * ay + az * az));
+
+    float cr = cosf(roll * 0.5f);
+    float sr = sinf(roll * 0.5f);
+    float cp = cosf(pitch * 0.5f);
+    float sp = sinf(pitch * 0.5f);
+
+    q_ = {cr * cp, sr * cp, cr * sp, -sr * sp};
+    initialized_ = true;
+}
+
+void MahonyAHRS::update(float gx, float gy, float gz, float ax, float ay, float az, float dt)
+{
+    if (dt <= 0.0f)
+    {
+        return;
+    }
+
+    float norm = sqrtf(ax * ax + ay * ay + az * az);
+    if (!initialized_)
+    {
+        if (norm > 0.0f)
+        {
+            alignToGravity(ax, ay, az);
+        }
+        return;
+    }
+
+    float qw = q_.w, qx = q_.x, qy = q_.y, qz = q_.z;
+
+    // Skip correction when the accelerometer does not measure gravity alone.
+    // The magnitude is compared in g when the input looks like m/s^2.
+    float g = norm > 2.0f ? norm / STANDARD_GRAVITY : norm;
+    if (norm > 0.0f && fabsf(g - 1.0f) < ACCEL_GATE)
+    {
+        ax /= norm;
+        ay /= norm;
+        az /= norm;
+
+        // Gravity direction predicted by the current estimate
+        float vx = 2.0f * (qx * qz - qw * qy);
+        float vy = 2.0f * (qw * qx + qy * qz);
+        float vz = qw * qw - qx * qx - qy * qy + qz * qz;
+
+        // Error is the cross product between measured and predicted gravity
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        if (ki_ > 0.0f)
+        {
+            bias_.x = fminf(fmaxf(bias_.x + ki_ * ex * dt, -MAX_BIAS), MAX_BIAS);
+            bias_.y = fminf(fmaxf(bias_.y + ki_ * ey * dt, -MAX_BIAS), MAX_BIAS);
+            bias_.z = fminf(fmaxf(bias_.z + ki_ * ez * dt, -MAX_BIAS), MAX_BIAS);
+        }
+
+        gx += kp_ * ex;
+        gy += kp_ * ey;
+        gz += kp_ * ez;
+    }
+
+    gx += bias_.x;
+    gy += bias_.y;
+    gz += bias_.z;
+
+    // Integrate the quaternion rate
+    float hdt = 0.5f * dt;
+    q_.w = qw + (-qx * gx - qy * gy - qz * gz) * hdt;
+    q_.x = qx + (qw * gx + qy * gz - qz * gy) * hdt;
+    q_.y = qy + (qw * gy - qx * gz + qz * gx) * hdt;
+    q_.z = qz + (qw * gz + qx * gy - qy * gx) * hdt;
+
+    float qnorm = sqrtf(q_.w * q_.w + q_.x * q_.x + q_.y * q_.y + q_.z * q_.z);
+    if (qnorm > 0.0f)
+    {
+        q_.w /= qnorm;
+        q_.x /= qnorm;
+        q_.y /= qnorm;
+        q_.z /= qnorm;
+    }
+}
+
+MahonyAHRS::Euler MahonyAHRS::getEuler() const
+{
+    Euler e;
+    e.roll = atan2f(2.0f * (q_.w * q_.x + q_.y * q_.z), 1.0f - 2.0f * (q_.x * q_.x + q_.y * q_.y));
+    float sinp = 2.0f * (q_.w * q_.y - q_.z * q_.x);
+    e.pitch = fabsf(sinp) >= 1.0f ? copysignf(1.57079632f, sinp) : asinf(sinp);
+    e.yaw = atan2f(2.0f * (q_.w * q_.z + q_.x * q_.y), 1.0f - 2.0f * (q_.y * q_.y + q_.z * q_.z));
+    return e;
+}
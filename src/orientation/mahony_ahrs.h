@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+
+// Mahony complementary filter with integral feedback.
+// Plain C++ with fixed-size state so it can run against recorded IMU logs off-target.
+class MahonyAHRS
+{
+public:
+    struct Quaternion
+    {
+        float w;
+        float x;
+        float y;
+        float z;
+    };
+
+    struct Euler
+    {
+        float roll;  // Rotation about X in radians
+        float pitch; // Rotation about Y in radians
+        float yaw;   // Rotation about Z in radians
+    };
+
+    struct Vector3
+    {
+        float x;
+        float y;
+        float z;
+    };
+
+    // kp: proportional gain pulling the estimate towards the accelerometer
+    // ki: integral gain, the integrator is the gyro bias estimate
+    MahonyAHRS(float kp = 2.0f, float ki = 0.05f);
+
+    void reset();
+    void setGains(float kp, float ki);
+
+    // Gyro in rad/s, accel in any unit (only the direction is used), dt in seconds
+    void update(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+
+    Quaternion getQuaternion() const { return q_; }
+    Euler getEuler() const;
+    Vector3 getGyroBias() const { return {-bias_.x, -bias_.y, -bias_.z}; }
+    bool isInitialized() const { return initialized_; }
+
+private:
+    void alignToGravity(float ax, float ay, float az);
+
+    float kp_;
+    float ki_;
+    Quaternion q_;
+    Vector3 bias_; // Integral feedback term, negated gyro bias
+    bool initialized_;
+};
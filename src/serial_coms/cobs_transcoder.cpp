@@ -1,74 +1,81 @@
 #include <vector>
 #include <cstdint>
+#include "cobs_transcoder.h"
 
 namespace cobs_transcoder
 {
 
     // COBS encode
-    std::vector<uint8_t> encode(const std::vector<uint8_t> &input)
+    size_t encode(const uint8_t *input, size_t size, uint8_t *output)
     {
-        std::vector<uint8_t> output;
-        output.reserve(input.size() + 2); // Worst case
-
-        size_t idx = 0;
+        size_t out = 1; // Slot 0 is the placeholder for the first code byte
         size_t code_idx = 0;
-        output.push_back(0); // Placeholder for first code byte
-
         uint8_t code = 1;
 
-        while (idx < input.size())
+        for (size_t idx = 0; idx < size; ++idx)
         {
             if (input[idx] == 0)
             {
                 output[code_idx] = code;
-                code_idx = output.size();
-                output.push_back(0); // Placeholder for next code byte
+                code_idx = out++; // Placeholder for next code byte
                 code = 1;
             }
             else
             {
-                output.push_back(input[idx]);
+                output[out++] = input[idx];
                 code++;
                 if (code == 0xFF)
                 {
                     output[code_idx] = code;
-                    code_idx = output.size();
-                    output.push_back(0); // Placeholder for next code byte
+                    code_idx = out++; // Placeholder for next code byte
                     code = 1;
                 }
             }
-            ++idx;
         }
         output[code_idx] = code;
-        return output;
+        return out;
     }
 
-    std::vector<uint8_t> decode(const std::vector<uint8_t> &input)
+    // Every group writes no further than the code byte it was read from, so the
+    // write index never overtakes the read index and decoding in place is safe.
+    size_t decode(const uint8_t *input, size_t size, uint8_t *output)
     {
-        std::vector<uint8_t> output;
+        size_t out = 0;
         size_t idx = 0;
 
-        while (idx < input.size())
+        while (idx < size)
         {
             uint8_t code = input[idx];
-            if (code == 0 || idx + code - 1 >= input.size())
+            if (code == 0 || idx + code - 1 >= size)
             {
                 // Invalid COBS stream
-                return {};
+                return 0;
             }
             ++idx;
             for (uint8_t i = 1; i < code; ++i)
             {
-                if (idx >= input.size())
-                    return {};
-                output.push_back(input[idx++]);
+                output[out++] = input[idx++];
             }
-            if (code != 0xFF && idx < input.size())
+            if (code != 0xFF && idx < size)
             {
-                output.push_back(0);
+                output[out++] = 0;
             }
         }
 
+        return out;
+    }
+
+    std::vector<uint8_t> encode(const std::vector<uint8_t> &input)
+    {
+        std::vector<uint8_t> output(maxEncodedSize(input.size()));
+        output.resize(encode(input.data(), input.size(), output.data()));
+        return output;
+    }
+
+    std::vector<uint8_t> decode(const std::vector<uint8_t> &input)
+    {
+        std::vector<uint8_t> output(input.size());
+        output.resize(decode(input.data(), input.size(), output.data()));
         return output;
     }
 } // namespace cobs_transcoder
\ No newline at end of file
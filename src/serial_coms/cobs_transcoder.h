@@ -1,11 +1,21 @@
 #pragma once
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 namespace cobs_transcoder
 {
 
+    // Largest COBS encoding of a block of the given size (no delimiter)
+    constexpr size_t maxEncodedSize(size_t size) { return size + size / 254 + 1; }
+
     std::vector<uint8_t> encode(const std::vector<uint8_t> &input);
     std::vector<uint8_t> decode(const std::vector<uint8_t> &input);
 
+    // Buffer variants. output must hold maxEncodedSize(size) bytes for encode and
+    // size bytes for decode; decode may run in place (output == input).
+    // Both return the number of bytes written, decode returns 0 on an invalid stream.
+    size_t encode(const uint8_t *input, size_t size, uint8_t *output);
+    size_t decode(const uint8_t *input, size_t size, uint8_t *output);
+
 } // namespace cobs_transcoder
\ No newline at end of file
@@ -1,11 +1,13 @@
-#include <Arduino.h>
 #include "crc8_calc.h"
 
 // Compute CRC-8 with configurable init and poly
 uint8_t crc8(const uint8_t *data, size_t len)
 {
-    uint8_t crc = CRC8_INIT;
+    return crc8(data, len, CRC8_INIT);
+}
 
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc)
+{
     for (size_t i = 0; i < len; ++i)
     {
         crc ^= data[i];
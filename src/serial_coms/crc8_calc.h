@@ -1,8 +1,12 @@
 #pragma once
-#include <Arduino.h>
+#include <cstddef>
+#include <cstdint>
 
 // CRC parameters
 #define CRC8_INIT 0x00 // Default initial value for SMBus
 #define CRC8_POLY 0x07 // Default polynomial for SMBus: x^8 + x^2 + x^1 + 1
 
-uint8_t crc8(const uint8_t *data, size_t len);
\ No newline at end of file
+uint8_t crc8(const uint8_t *data, size_t len);
+
+// Continue a running CRC over more data, crc8(a|b) == crc8(b, crc8(a))
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc);
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "frame_codec.h"
+#include "crc8_calc.h"
+
+namespace frame_codec
+{
+
+    namespace
+    {
+        // Streaming COBS encoder so the channel and CRC bytes never have to be
+        // copied next to the payload. Produces the same output as cobs_transcoder::encode.
+        struct CobsWriter
+        {
+            uint8_t *output;
+            size_t out = 1;
+            size_t codeIdx = 0;
+            uint8_t code = 1;
+
+            explicit CobsWriter(uint8_t *buffer) : output(buffer) {}
+
+            void put(uint8_t byte)
+            {
+                if (byte != 0)
+                {
+                    output[out++] = byte;
+                    if (++code != 0xFF)
+                        return;
+                }
+                output[codeIdx] = code;
+                codeIdx = out++;
+                code = 1;
+            }
+
+            size_t finish()
+            {
+                output[codeIdx] = code;
+                return out;
+            }
+        };
+    } // namespace
+
+    size_t encode(uint8_t channel, const uint8_t *payload, size_t size, uint8_t *output)
+    {
+        CobsWriter writer(output);
+        writer.put(channel);
+        for (size_t i = 0; i < size; ++i)
+        {
+            writer.put(payload[i]);
+        }
+
+        // CRC covers the channel byte and the payload
+        writer.put(crc8(payload, size, crc8(&channel, 1)));
+
+        size_t length = writer.finish();
+        output[length++] = DELIMITER;
+        return length;
+    }
+
+    Status decode(uint8_t *data, size_t size, Frame &frame)
+    {
+        size_t decoded = cobs_transcoder::decode(data, size, data);
+        if (decoded == 0 && size != 0)
+        {
+            return Status::BadCobs;
+        }
+        if (decoded < MIN_DECODED_SIZE)
+        {
+            return Status::TooShort;
+        }
+        if (crc8(data, decoded - 1) != data[decoded - 1])
+        {
+            return Status::BadCrc;
+        }
+
+        frame.channel = data[0];
+        frame.payload = data + 1;
+        frame.size = decoded - 2;
+        return Status::Ok;
+    }
+
+} // namespace frame_codec
\ No newline at end of file
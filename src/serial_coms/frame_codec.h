@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "cobs_transcoder.h"
+
+// Channel framing shared by the firmware and the host library:
+// COBS(channel | payload | crc8(channel | payload)) followed by a 0x00 delimiter.
+namespace frame_codec
+{
+
+    constexpr uint8_t DELIMITER = 0x00;
+    constexpr size_t MIN_DECODED_SIZE = 3; // Channel, at least one payload byte, CRC
+
+    // Bytes needed by encode() for a payload of the given size, delimiter included
+    constexpr size_t maxFrameSize(size_t payloadSize) { return cobs_transcoder::maxEncodedSize(payloadSize + 2) + 1; }
+
+    enum class Status : uint8_t
+    {
+        Ok,
+        TooShort,
+        BadCobs,
+        BadCrc,
+    };
+
+    // A decoded frame. payload points into the buffer handed to decode().
+    struct Frame
+    {
+        uint8_t channel;
+        const uint8_t *payload;
+        size_t size;
+    };
+
+    // Encodes a complete frame into output, which must hold maxFrameSize(size) bytes.
+    // Returns the number of bytes written including the trailing delimiter.
+    size_t encode(uint8_t channel, const uint8_t *payload, size_t size, uint8_t *output);
+
+    // Decodes one frame (without its delimiter) in place and verifies the CRC.
+    Status decode(uint8_t *data, size_t size, Frame &frame);
+
+} // namespace frame_codec
\ No newline at end of file
@@ -1,34 +1,39 @@
 #include <ArduinoJson.h>
 #include <vector>
+#include "msgpack_transcoder.h"
+#ifdef ARDUINO
 #include "configuration.h"
+#endif
 
 // Encode ArduinoJson document to MessagePack
 std::vector<uint8_t> encodeToMsgPack(const JsonDocument &doc)
 {
 
     // Check if the document is empty
+#ifdef ARDUINO
     if (doc.isNull() || doc.size() == 0)
     {
         LOG_WEBSERIALLN("Document is empty, returning empty vector.");
     }
+#endif
 
     // Estimate the required size and preallocate the buffer
     size_t estimatedSize = measureMsgPack(doc);
     std::vector<uint8_t> buffer;
     buffer.reserve(estimatedSize);
 
-    // Use a lambda to write directly to the buffer
-    struct VectorWriter : public Print
+    // Custom ArduinoJson writer, no Print base so the host library can share this file
+    struct VectorWriter
     {
         std::vector<uint8_t> &buffer;
         VectorWriter(std::vector<uint8_t> &buf) : buffer(buf) {}
 
-        size_t write(uint8_t byte) override
+        size_t write(uint8_t byte)
         {
             buffer.push_back(byte);
             return 1;
         }
-        size_t write(const uint8_t *data, size_t size) override
+        size_t write(const uint8_t *data, size_t size)
         {
             buffer.insert(buffer.end(), data, data + size);
             return size;
@@ -1,11 +1,14 @@
 #include <Arduino.h>
 #include "serial_io.h"
 #include "msgpack_transcoder.h"
-#include "crc8_calc.h"
-#include "cobs_transcoder.h"
+#include "frame_codec.h"
 #include "MycilaWebSerial.h"
 #include "configuration.h"
 #include "driver/uart.h"
+#include "logging/binary_log.h"
+#include "telemetry_history.h"
+#include "diagnostics/latency_probe.h"
+#include "tasks/led_control.h"
 
 SerialIO serialio;
 
@@ -33,60 +36,71 @@ void SerialIO::publish(int channel, const JsonDocument &doc)
     //     return;
     // }
 
-    digitalWrite(LED_PIN, HIGH); // Turn on the LED to indicate activity
-    auto msgpackdata = encodeToMsgPack(doc);
-    // add channel information to the beginning of the message
-    std::vector<uint8_t> message;
-
-    message.push_back(static_cast<uint8_t>(channel));
-    message.insert(message.end(), msgpackdata.begin(), msgpackdata.end());
-
-    // calculate CRC8 for the message
-    uint8_t crc = crc8(message.data(), message.size());
-
-    // append CRC8 to the end of the message
-    message.push_back(crc);
-
-    // encode the message using COBS
-    auto encoded_message = cobs_transcoder::encode(message);
+    // Retained channels carry their sequence number and device time, so the host can tell
+    // what it missed and ask for it with get_history
+    std::vector<uint8_t> msgpackdata;
+    uint32_t seq;
+    uint32_t timestampMs;
+    if (telemetryHistory.stamp(static_cast<uint8_t>(channel), seq, timestampMs))
+    {
+        JsonDocument stamped;
+        stamped.set(doc);
+        stamped["sq"] = seq;
+        stamped["tm"] = timestampMs;
+        msgpackdata = encodeToMsgPack(stamped);
+        telemetryHistory.record(static_cast<uint8_t>(channel), seq, timestampMs, msgpackdata.data(), msgpackdata.size());
+    }
+    else
+    {
+        msgpackdata = encodeToMsgPack(doc);
+    }
 
-    // append 0x00 byte to the end of the encoded message
-    encoded_message.push_back(0x00);
+    // channel byte, payload and CRC8, COBS encoded and terminated with 0x00
+    std::vector<uint8_t> frame(frame_codec::maxFrameSize(msgpackdata.size()));
+    frame.resize(frame_codec::encode(static_cast<uint8_t>(channel), msgpackdata.data(), msgpackdata.size(), frame.data()));
 
     // write the encoded message to the serial port
-    write(encoded_message.data(), encoded_message.size());
-    digitalWrite(LED_PIN, LOW); // Turn off the LED after sending
+    write(frame.data(), frame.size());
+    ledControl.signal(LedControl::EVENT_TX);
     return;
 }
 
-void SerialIO::_processPacket(const std::vector<uint8_t> &packet)
+void SerialIO::_processPacket(uint8_t *packet, size_t size)
 {
-    if (packet.size() < 3)
+    frame_codec::Frame frame;
+    switch (frame_codec::decode(packet, size, frame))
     {
-        LOG_WEBSERIALLN("Packet too short");
+    case frame_codec::Status::Ok:
+        break;
+    case frame_codec::Status::BadCrc:
+        LOG_DEFERRED(SERIAL_CRC_MISMATCH, packet[0]);
+        ledControl.signal(LedControl::EVENT_ERROR);
         return;
-    }
-
-    uint8_t received_crc = packet.back();
-    std::vector<uint8_t> message(packet.begin(), packet.end() - 1);
-
-    if (crc8(message.data(), message.size()) != received_crc)
-    {
-        LOG_WEBSERIALLN("CRC mismatch");
+    default:
+        LOG_WEBSERIALLN("Packet too short");
+        ledControl.signal(LedControl::EVENT_ERROR);
         return;
     }
 
-    uint8_t channel = message[0];
-    std::vector<uint8_t> payload(message.begin() + 1, message.end());
+    uint8_t channel = frame.channel;
 
     JsonDocument doc; // Adjust size as needed
     doc.clear();      // Clear the document to avoid residual data
 
-    if (!decodeFromMsgPack(payload.data(), payload.size(), doc))
+    if (!decodeFromMsgPack(frame.payload, frame.size, doc))
     {
-        LOG_WEBSERIALLN("MsgPack decoding failed");
+        LOG_DEFERRED(SERIAL_DECODE_FAILED, channel);
+        ledControl.signal(LedControl::EVENT_ERROR);
         return;
     }
+#if LATENCY_PROBE_ENABLED
+    if (channel == LATENCY_PROBE_CHANNEL)
+    {
+        latencyProbe.begin(_frameNumber, _frameCompleteUs);
+        LATENCY_MARK(Decoded);
+    }
+#endif
+    ledControl.signal(LedControl::EVENT_RX);
 
     auto it = _callbacks.find(channel);
     if (it != _callbacks.end())
@@ -99,8 +113,6 @@ void SerialIO::_processPacket(const std::vector<uint8_t> &packet)
 
 void SerialIO::begin()
 {
-    pinMode(LED_PIN, OUTPUT);
-
     ESP32_SERIAL.begin(ESP32_BAUDRATE);
     ESP32_SERIAL.onReceive([this]()
                            { this->onUartRx(); }); // Register the ISR callback as lambda
@@ -140,13 +152,16 @@ void SerialIO::updateSubscribers()
     {
         if (byte == 0x00)
         {
+#if LATENCY_PROBE_ENABLED
+            _frameNumber = latencyProbe.notePop(); // Every delimiter, notePush counted empty frames too
+#endif
             if (!_buffer.empty())
             {
-                digitalWrite(LED_PIN, HIGH); // Turn on the LED to indicate activity
-                auto decoded = cobs_transcoder::decode(_buffer);
-                _processPacket(decoded);
+#if LATENCY_PROBE_ENABLED
+                _frameCompleteUs = LatencyProbe::nowUs();
+#endif
+                _processPacket(_buffer.data(), _buffer.size()); // decoded in place
                 _buffer.clear();
-                digitalWrite(LED_PIN, LOW); // Turn off the LED after processing
             }
         }
         else
@@ -154,7 +169,8 @@ void SerialIO::updateSubscribers()
             _buffer.push_back(byte);
             if (_buffer.size() > MAX_SERIAL_BUFFER_SIZE)
             {
-                LOG_WEBSERIALLN("Buffer overflow, clearing buffer");
+                LOG_DEFERRED(SERIAL_BUFFER_OVERFLOW);
+                ledControl.signal(LedControl::EVENT_ERROR);
                 _buffer.clear();
             }
         }
@@ -168,7 +184,13 @@ void SerialIO::onUartRx()
         uint8_t byte = ESP32_SERIAL.read();
         if (!_rxRing.push(byte))
         {
-            LOG_WEBSERIALLN("Ring buffer overflow");
+            LOG_DEFERRED(SERIAL_RING_OVERFLOW);
+        }
+#if LATENCY_PROBE_ENABLED
+        else if (byte == 0x00)
+        {
+            latencyProbe.notePush();
         }
+#endif
     }
 }
\ No newline at end of file
@@ -7,8 +7,6 @@
 #include <vector>
 #include "ring_buffer.h"
 
-#define LED_PIN 2 // Built-in LED on many ESP32 boards
-
 // Callback function type for subscription
 using SubscriptionCallback = void (*)(JsonDocument &doc);
 
@@ -32,10 +30,12 @@ private:
 
     std::unordered_map<uint8_t, Callback> _callbacks;
     std::vector<uint8_t> _buffer;
-    void _processPacket(const std::vector<uint8_t> &packet);
+    void _processPacket(uint8_t *packet, size_t size);
 
     void onUartRx();
     RingBuffer _rxRing;
+    uint32_t _frameCompleteUs = 0; // When the delimiter of the frame being processed was popped
+    uint32_t _frameNumber = 0;     // Latency probe number of that delimiter
 };
 
 void serialTask(void *parameter);
\ No newline at end of file
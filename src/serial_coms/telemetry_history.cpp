@@ -0,0 +1,223 @@
+#include "telemetry_history.h"
+#include "serial_io.h"
+#include "esp_heap_caps.h"
+
+TelemetryHistory telemetryHistory;
+extern SerialIO serialio;
+
+bool TelemetryHistory::begin()
+{
+    const uint8_t channels[HISTORY_NUM_CHANNELS] = HISTORY_CHANNELS;
+    const size_t bytes = HISTORY_DEPTH * sizeof(Entry);
+
+    for (size_t i = 0; i < HISTORY_NUM_CHANNELS; ++i)
+    {
+        ChannelHistory &history = histories[i];
+        history.channel = channels[i];
+        history.nextSeq = 1;
+        history.dropped = 0;
+        history.lock = portMUX_INITIALIZER_UNLOCKED;
+
+        // Prefer PSRAM when the board has it, the history is never on a hot read path
+        history.entries = (Entry *)heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM);
+        if (history.entries == nullptr)
+        {
+            history.entries = (Entry *)heap_caps_calloc(1, bytes, MALLOC_CAP_8BIT);
+        }
+        if (history.entries == nullptr)
+        {
+            LOG_WEBSERIALLN("Failed to allocate telemetry history for channel " + String(history.channel));
+            return false;
+        }
+    }
+
+    replayQueue = xQueueCreate(HISTORY_REPLAY_QUEUE_SIZE, sizeof(ReplayRequest));
+    if (replayQueue == NULL)
+    {
+        LOG_WEBSERIALLN("Failed to create history replay queue");
+        return false;
+    }
+
+    BaseType_t taskResult = xTaskCreatePinnedToCore(replayTaskWrapper, "HistoryTask", HISTORY_TASK_STACK_SIZE, this, HISTORY_TASK_PRIORITY, NULL, 1);
+    if (taskResult != pdPASS)
+    {
+        LOG_WEBSERIALLN("Failed to create history replay task");
+        return false;
+    }
+    return true;
+}
+
+TelemetryHistory::ChannelHistory *TelemetryHistory::find(uint8_t channel)
+{
+    for (auto &history : histories)
+    {
+        if (history.entries != nullptr && history.channel == channel)
+        {
+            return &history;
+        }
+    }
+    return nullptr;
+}
+
+bool TelemetryHistory::stamp(uint8_t channel, uint32_t &seq, uint32_t &timestampMs)
+{
+    ChannelHistory *history = find(channel);
+    if (history == nullptr)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&history->lock);
+    seq = history->nextSeq++;
+    portEXIT_CRITICAL(&history->lock);
+    timestampMs = millis();
+    return true;
+}
+
+void TelemetryHistory::record(uint8_t channel, uint32_t seq, uint32_t timestampMs, const uint8_t *payload, size_t length)
+{
+    ChannelHistory *history = find(channel);
+    if (history == nullptr)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&history->lock);
+    if (length > HISTORY_SLOT_SIZE)
+    {
+        history->dropped++; // The sequence number was still used so the host sees the gap
+        portEXIT_CRITICAL(&history->lock);
+        return;
+    }
+    Entry &entry = history->entries[seq % HISTORY_DEPTH];
+    entry.seq = seq;
+    entry.timestampMs = timestampMs;
+    entry.length = length;
+    memcpy(entry.data, payload, length);
+    portEXIT_CRITICAL(&history->lock);
+}
+
+uint32_t TelemetryHistory::oldestSeq(const ChannelHistory &history)
+{
+    return history.nextSeq > HISTORY_DEPTH ? history.nextSeq - HISTORY_DEPTH : 1;
+}
+
+bool TelemetryHistory::copyEntry(ChannelHistory &history, uint32_t seq, Entry &entry)
+{
+    portENTER_CRITICAL(&history.lock);
+    const Entry &slot = history.entries[seq % HISTORY_DEPTH];
+    bool valid = slot.seq == seq; // Overwritten or dropped frames no longer match
+    if (valid)
+    {
+        entry = slot;
+    }
+    portEXIT_CRITICAL(&history.lock);
+    return valid;
+}
+
+bool TelemetryHistory::requestReplay(uint8_t channel, uint32_t sinceSeq, uint32_t sinceMs)
+{
+    if (replayQueue == NULL || find(channel) == nullptr)
+    {
+        return false;
+    }
+    ReplayRequest request = {channel, sinceSeq, sinceMs};
+    return xQueueSend(replayQueue, &request, 0) == pdPASS;
+}
+
+void TelemetryHistory::getInfo(JsonDocument &doc)
+{
+    JsonArray channels = doc["history"].to<JsonArray>();
+    for (auto &history : histories)
+    {
+        if (history.entries == nullptr)
+        {
+            continue;
+        }
+        portENTER_CRITICAL(&history.lock);
+        uint32_t next = history.nextSeq;
+        uint32_t oldest = oldestSeq(history);
+        uint32_t oldestMs = history.entries[oldest % HISTORY_DEPTH].timestampMs;
+        uint32_t dropped = history.dropped;
+        portEXIT_CRITICAL(&history.lock);
+
+        JsonObject info = channels.add<JsonObject>();
+        info["c"] = history.channel;
+        info["first"] = oldest;
+        info["next"] = next;
+        info["t"] = oldestMs;
+        info["dropped"] = dropped;
+    }
+}
+
+void TelemetryHistory::replay(const ReplayRequest &request)
+{
+    ChannelHistory *history = find(request.channel);
+    if (history == nullptr)
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&history->lock);
+    uint32_t end = history->nextSeq; // Replay up to what existed when the request was handled
+    uint32_t seq = oldestSeq(*history);
+    portEXIT_CRITICAL(&history->lock);
+
+    if (request.sinceSeq + 1 > seq)
+    {
+        seq = request.sinceSeq + 1;
+    }
+
+    Entry entry;
+    JsonDocument payload;
+    uint32_t sent = 0;
+    for (; seq < end; ++seq)
+    {
+        if (!copyEntry(*history, seq, entry) || entry.timestampMs < request.sinceMs)
+        {
+            continue;
+        }
+
+        payload.clear();
+        if (deserializeMsgPack(payload, entry.data, entry.length))
+        {
+            continue;
+        }
+
+        JsonDocument frame;
+        frame["c"] = request.channel;
+        frame["s"] = seq;
+        frame["t"] = entry.timestampMs;
+        frame["d"] = payload;
+        serialio.publish(HISTORY_CHANNEL, frame);
+
+        // Stay out of the way of live telemetry
+        if (++sent % HISTORY_REPLAY_BURST == 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    // Mark the end of the replay so the host knows which sequence to continue from
+    JsonDocument done;
+    done["c"] = request.channel;
+    done["e"] = end;
+    serialio.publish(HISTORY_CHANNEL, done);
+}
+
+void TelemetryHistory::replayTaskWrapper(void *parameter)
+{
+    TelemetryHistory *instance = static_cast<TelemetryHistory *>(parameter);
+    instance->replayTask();
+}
+
+void TelemetryHistory::replayTask()
+{
+    ReplayRequest request;
+    for (;;)
+    {
+        if (xQueueReceive(replayQueue, &request, portMAX_DELAY) == pdPASS)
+        {
+            replay(request);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+
+// Fixed-size history of published telemetry frames per channel. Every frame gets a
+// sequence number, so after a link dropout the host can ask for everything it missed
+// and have it streamed back at low priority on HISTORY_CHANNEL.
+class TelemetryHistory
+{
+public:
+    // Worst-case MsgPack size of a flat map with `entries` keys of up to `keyLength` characters
+    // and scalar values of up to `valueSize` bytes (5 for float32 and uint32, 9 for 64 bit values)
+    static constexpr size_t mapSize(size_t entries, size_t keyLength, size_t valueSize)
+    {
+        return 1 + entries * (1 + keyLength + valueSize);
+    }
+    static constexpr size_t STAMP_SIZE = 2 * (1 + 2 + 5); // "sq" and "tm" added to retained frames
+
+    bool begin();
+
+    // Assign the next sequence number and the device time to a frame, false if the channel is not retained
+    bool stamp(uint8_t channel, uint32_t &seq, uint32_t &timestampMs);
+    // Store the MsgPack payload of a stamped frame
+    void record(uint8_t channel, uint32_t seq, uint32_t timestampMs, const uint8_t *payload, size_t length);
+
+    // Queue a replay of everything on `channel` after sequence `sinceSeq` (or from timestamp `sinceMs`)
+    bool requestReplay(uint8_t channel, uint32_t sinceSeq, uint32_t sinceMs);
+    void getInfo(JsonDocument &doc);
+
+private:
+    struct Entry
+    {
+        uint32_t seq; // 0 marks an empty slot
+        uint32_t timestampMs;
+        uint16_t length;
+        uint8_t data[HISTORY_SLOT_SIZE];
+    };
+
+    struct ChannelHistory
+    {
+        uint8_t channel;
+        uint32_t nextSeq; // Sequence number the next frame will get, starts at 1
+        uint32_t dropped; // Frames too large for a slot
+        Entry *entries;
+        portMUX_TYPE lock;
+    };
+
+    struct ReplayRequest
+    {
+        uint8_t channel;
+        uint32_t sinceSeq;
+        uint32_t sinceMs;
+    };
+
+    ChannelHistory *find(uint8_t channel);
+    uint32_t oldestSeq(const ChannelHistory &history);
+    bool copyEntry(ChannelHistory &history, uint32_t seq, Entry &entry);
+    void replay(const ReplayRequest &request);
+
+    static void replayTaskWrapper(void *parameter);
+    void replayTask();
+
+    ChannelHistory histories[HISTORY_NUM_CHANNELS];
+    QueueHandle_t replayQueue = NULL;
+};
+
+// Channel 9 (seven float entries) is the largest retained payload
+static_assert(HISTORY_SLOT_SIZE >= TelemetryHistory::mapSize(7, 1, 5) + TelemetryHistory::STAMP_SIZE,
+              "HISTORY_SLOT_SIZE does not hold a stamped orientation frame");
+
+extern TelemetryHistory telemetryHistory;
@@ -0,0 +1,62 @@
+#include "file_settings_backend.h"
+#include <cinttypes>
+#include <cstdio>
+
+bool FileSettingsBackend::open()
+{
+    values.clear();
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr)
+    {
+        return true; // Nothing persisted yet
+    }
+    char key[16];
+    uint32_t raw;
+    while (fscanf(file, "%15s %" SCNu32, key, &raw) == 2)
+    {
+        values[key] = raw;
+    }
+    fclose(file);
+    return true;
+}
+
+bool FileSettingsBackend::read(const char *key, uint32_t &raw)
+{
+    auto it = values.find(key);
+    if (it == values.end())
+    {
+        return false;
+    }
+    raw = it->second;
+    return true;
+}
+
+bool FileSettingsBackend::write(const char *key, uint32_t raw)
+{
+    values[key] = raw;
+    return true;
+}
+
+bool FileSettingsBackend::erase(const char *key)
+{
+    values.erase(key);
+    return true;
+}
+
+bool FileSettingsBackend::commit()
+{
+    // Write a temporary file and rename it so a crash never leaves half a file behind
+    std::string temp = path + ".tmp";
+    FILE *file = fopen(temp.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+    bool ok = true;
+    for (const auto &kv : values)
+    {
+        ok &= fprintf(file, "%s %" PRIu32 "\n", kv.first.c_str(), kv.second) > 0;
+    }
+    ok &= fclose(file) == 0;
+    return ok && rename(temp.c_str(), path.c_str()) == 0;
+}
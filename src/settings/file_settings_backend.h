@@ -0,0 +1,22 @@
+#pragma once
+#include "settings_backend.h"
+#include <map>
+#include <string>
+
+// Stand-in for NVS in host builds. Keeps "key value" lines in a text file, the file is
+// read by open() and rewritten by commit().
+class FileSettingsBackend : public SettingsBackend
+{
+public:
+    explicit FileSettingsBackend(const std::string &path) : path(path) {}
+
+    bool open() override;
+    bool read(const char *key, uint32_t &raw) override;
+    bool write(const char *key, uint32_t raw) override;
+    bool erase(const char *key) override;
+    bool commit() override;
+
+private:
+    std::string path;
+    std::map<std::string, uint32_t> values;
+};
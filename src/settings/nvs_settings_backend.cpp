@@ -0,0 +1,50 @@
+#include "nvs_settings_backend.h"
+
+#ifdef ESP_PLATFORM
+NvsSettingsBackend::~NvsSettingsBackend()
+{
+    if (opened)
+    {
+        nvs_close(handle);
+    }
+}
+
+bool NvsSettingsBackend::open()
+{
+    if (!opened)
+    {
+        opened = nvs_open(ns, NVS_READWRITE, &handle) == ESP_OK;
+    }
+    return opened;
+}
+
+bool NvsSettingsBackend::read(const char *key, uint32_t &raw)
+{
+    return opened && nvs_get_u32(handle, key, &raw) == ESP_OK;
+}
+
+bool NvsSettingsBackend::write(const char *key, uint32_t raw)
+{
+    uint32_t stored;
+    if (read(key, stored) && stored == raw)
+    {
+        return true; // Unchanged, spare the flash
+    }
+    return opened && nvs_set_u32(handle, key, raw) == ESP_OK;
+}
+
+bool NvsSettingsBackend::erase(const char *key)
+{
+    if (!opened)
+    {
+        return false;
+    }
+    esp_err_t err = nvs_erase_key(handle, key);
+    return err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND;
+}
+
+bool NvsSettingsBackend::commit()
+{
+    return opened && nvs_commit(handle) == ESP_OK;
+}
+#endif
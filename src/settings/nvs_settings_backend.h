@@ -0,0 +1,25 @@
+#pragma once
+#include "settings_backend.h"
+
+#ifdef ESP_PLATFORM
+#include <nvs.h>
+
+// Settings stored in one NVS namespace, NVS itself is initialized by the Arduino core
+class NvsSettingsBackend : public SettingsBackend
+{
+public:
+    explicit NvsSettingsBackend(const char *ns) : ns(ns) {}
+    ~NvsSettingsBackend();
+
+    bool open() override;
+    bool read(const char *key, uint32_t &raw) override;
+    bool write(const char *key, uint32_t raw) override;
+    bool erase(const char *key) override;
+    bool commit() override;
+
+private:
+    const char *ns;
+    nvs_handle_t handle = 0;
+    bool opened = false;
+};
+#endif
@@ -0,0 +1,142 @@
+#include "settings.h"
+#include "nvs_settings_backend.h"
+#include "device_bus/sensor_handler.h"
+#include "diagnostics/cpu_profiler.h"
+#include "logging/binary_log.h"
+#include "tasks/command_registry.h"
+#include "tasks/motor_control.h"
+
+extern SensorHandler sensorHandler;
+
+static void applyI2cSpeed(size_t id)
+{
+    sensorHandler.setI2cSpeed(settings.getU32(id));
+}
+
+// One level for the ESP log, the WebSerial lines and the deferred log records
+static void applyLogLevel(size_t id)
+{
+    uint8_t level = static_cast<uint8_t>(settings.getU32(id));
+    esp_log_level_set("*", static_cast<esp_log_level_t>(level));
+#if USE_WEBSERIAL
+    webSerialLevel = level;
+#endif
+    binaryLog.setLevel(level);
+}
+
+static void applyOrientation(size_t id)
+{
+    sensorHandler.setOrientationConfig(settingU32(Setting::OrientationPeriodMs), settingBool(Setting::OrientationEnabled));
+}
+
+static void applyFailsafe(size_t id)
+{
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        setMotorFailsafe(i, settings.getU32(id), getMotorFailsafeValue(i));
+    }
+}
+
+static void applyMotorLimits(size_t id)
+{
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        setMotorLimits(i, settingFloat(Setting::MotorSlewLimit), settingFloat(Setting::MotorAccelLimit));
+    }
+}
+
+static void applyCpuProfile(size_t id)
+{
+    cpuProfiler.setConfig(settingU32(Setting::CpuProfilePeriodMs), settingBool(Setting::CpuProfileStream));
+}
+
+// Periods and enables of the sensor tasks have no hook, the tasks read them every cycle
+static const SettingsStore::Descriptor SETTINGS_TABLE[] = {
+    {"i2c_hz", SettingsStore::Type::U32, I2C_SPEED, 10000, 1000000, applyI2cSpeed},
+    {"log_lvl", SettingsStore::Type::U32, LOG_LEVEL, ESP_LOG_NONE, ESP_LOG_VERBOSE, applyLogLevel},
+    {"bme_ms", SettingsStore::Type::U32, BME280_SAMPLE_PERIOD_MS, 10, 60000, nullptr},
+    {"bme_en", SettingsStore::Type::Bool, true, 0, 1, nullptr},
+    {"ain_ms", SettingsStore::Type::U32, ANALOG_SAMPLE_PERIOD_MS, 10, 60000, nullptr},
+    {"ain_en", SettingsStore::Type::Bool, true, 0, 1, nullptr},
+    {"din_ms", SettingsStore::Type::U32, DIGITAL_SAMPLE_PERIOD_MS, 10, 60000, nullptr},
+    {"din_en", SettingsStore::Type::Bool, true, 0, 1, nullptr},
+    {"ahrs_ms", SettingsStore::Type::U32, AHRS_PUBLISH_PERIOD_MS, 10, 60000, applyOrientation},
+    {"ahrs_en", SettingsStore::Type::Bool, AHRS_ENABLED, 0, 1, applyOrientation},
+    {"safety_ms", SettingsStore::Type::U32, SAFETY_TIMEOUT_MS, 0, 600000, applyFailsafe},
+    {"slew", SettingsStore::Type::Float, MOTOR_SLEW_LIMIT, 0, 1000, applyMotorLimits},
+    {"accel", SettingsStore::Type::Float, MOTOR_ACCEL_LIMIT, 0, 10000, applyMotorLimits},
+    {"cpu_ms", SettingsStore::Type::U32, CPU_PROFILE_PERIOD_MS, CPU_PROFILE_MIN_PERIOD_MS, 60000, applyCpuProfile},
+    {"cpu_en", SettingsStore::Type::Bool, CPU_PROFILE_STREAM, 0, 1, applyCpuProfile},
+};
+
+static_assert(sizeof(SETTINGS_TABLE) / sizeof(SETTINGS_TABLE[0]) == static_cast<size_t>(Setting::COUNT), "SETTINGS_TABLE must match Setting");
+static_assert(static_cast<size_t>(Setting::COUNT) <= SettingsStore::MAX_ENTRIES, "Too many settings");
+
+SettingsStore settings(SETTINGS_TABLE, static_cast<size_t>(Setting::COUNT));
+static NvsSettingsBackend backend(SETTINGS_NVS_NAMESPACE);
+
+static int handleGetSettings(const JsonDocument &request, JsonDocument &response)
+{
+    settings.toJson(response["s"].to<JsonObject>());
+    return 200;
+}
+
+static int handleSetSettings(const JsonDocument &request, JsonDocument &response)
+{
+    JsonObjectConst values = request["s"];
+    // Check everything first so a bad entry leaves all settings untouched
+    for (JsonPairConst kv : values)
+    {
+        size_t id;
+        if (!settings.find(kv.key().c_str(), id) || !settings.validate(id, kv.value()))
+        {
+            response["error"] = String("Invalid setting ") + kv.key().c_str();
+            return 400;
+        }
+    }
+    for (JsonPairConst kv : values)
+    {
+        size_t id;
+        settings.find(kv.key().c_str(), id);
+        settings.set(id, kv.value());
+    }
+    if ((request["save"] | false) && !saveSettings())
+    {
+        response["error"] = "Failed to save settings";
+        return 500;
+    }
+    return 200;
+}
+
+static int handleResetSettings(const JsonDocument &request, JsonDocument &response)
+{
+    settings.reset();
+    if (!settings.save(backend))
+    {
+        response["error"] = "Failed to save settings";
+        return 500;
+    }
+    return 200;
+}
+
+void setupSettings()
+{
+    size_t restored = settings.load(backend);
+    if (restored > 0)
+    {
+        LOG_WEBSERIALLN("Restored " + String(restored) + " saved settings");
+    }
+    commandRegistry.add(Command::GetSettings, handleGetSettings);
+    commandRegistry.add(Command::SetSettings, handleSetSettings);
+    commandRegistry.add(Command::ResetSettings, handleResetSettings);
+}
+
+void applySettings()
+{
+    settings.applyAll();
+}
+
+bool saveSettings()
+{
+    return settings.save(backend);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+#include "settings_store.h"
+
+// Settings that can be changed over channel 254 without reflashing. Defaults come from
+// configuration.h, values saved with set_settings survive a reboot in NVS.
+enum class Setting : uint8_t
+{
+    I2cSpeed,
+    LogLevel,
+    Bme280PeriodMs,
+    Bme280Enabled,
+    AnalogPeriodMs,
+    AnalogEnabled,
+    DigitalPeriodMs,
+    DigitalEnabled,
+    OrientationPeriodMs,
+    OrientationEnabled,
+    SafetyTimeoutMs,
+    MotorSlewLimit,
+    MotorAccelLimit,
+    CpuProfilePeriodMs,
+    CpuProfileStream,
+    COUNT
+};
+
+extern SettingsStore settings;
+
+void setupSettings();  // Restore the saved values and register the commands, before the subsystems start
+void applySettings();  // Push the values into the subsystems, once they are running
+bool saveSettings();   // Store the current values in NVS, as set_settings does with "save"
+
+inline bool settingBool(Setting s) { return settings.getBool(static_cast<size_t>(s)); }
+inline uint32_t settingU32(Setting s) { return settings.getU32(static_cast<size_t>(s)); }
+inline float settingFloat(Setting s) { return settings.getFloat(static_cast<size_t>(s)); }
+inline bool setSetting(Setting s, JsonVariantConst value) { return settings.set(static_cast<size_t>(s), value); }
+inline bool setSetting(Setting s, float value) { return settings.set(static_cast<size_t>(s), value); }
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// Persistent storage for settings. Values are kept as their raw 32 bits under a short key
+// (at most 15 characters, the NVS limit). Writes may be buffered until commit().
+class SettingsBackend
+{
+public:
+    virtual ~SettingsBackend() {}
+    virtual bool open() = 0;
+    virtual bool read(const char *key, uint32_t &raw) = 0; // False when the key was never written
+    virtual bool write(const char *key, uint32_t raw) = 0;
+    virtual bool erase(const char *key) = 0;
+    virtual bool commit() = 0;
+};
@@ -0,0 +1,190 @@
+#include "settings_store.h"
+#include <cmath>
+#include <cstring>
+
+SettingsStore::SettingsStore(const Descriptor *table, size_t count)
+    : table(table), count(count < MAX_ENTRIES ? count : MAX_ENTRIES)
+{
+    for (size_t id = 0; id < this->count; ++id)
+    {
+        values[id].store(defaultRaw(id), std::memory_order_relaxed);
+    }
+}
+
+bool SettingsStore::find(const char *key, size_t &id) const
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (strcmp(table[i].key, key) == 0)
+        {
+            id = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+float SettingsStore::getFloat(size_t id) const
+{
+    return toFloat(id, raw(id));
+}
+
+float SettingsStore::toFloat(size_t id, uint32_t raw) const
+{
+    switch (table[id].type)
+    {
+    case Type::Bool:
+        return raw != 0 ? 1.0f : 0.0f;
+    case Type::U32:
+        return static_cast<float>(raw);
+    case Type::Float:
+    {
+        float value;
+        memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+    }
+    return 0.0f;
+}
+
+bool SettingsStore::toRaw(size_t id, float value, uint32_t &out) const
+{
+    const Descriptor &d = table[id];
+    if (std::isnan(value) || value < d.min || value > d.max)
+    {
+        return false;
+    }
+    switch (d.type)
+    {
+    case Type::Bool:
+        out = value != 0.0f ? 1 : 0;
+        return true;
+    case Type::U32:
+        out = static_cast<uint32_t>(value);
+        return static_cast<float>(out) == value; // No fractions
+    case Type::Float:
+        memcpy(&out, &value, sizeof(out));
+        return true;
+    }
+    return false;
+}
+
+uint32_t SettingsStore::defaultRaw(size_t id) const
+{
+    uint32_t out = 0;
+    toRaw(id, table[id].defaultValue, out);
+    return out;
+}
+
+bool SettingsStore::validate(size_t id, JsonVariantConst value) const
+{
+    uint32_t out;
+    if (id >= count)
+    {
+        return false;
+    }
+    if (value.is<bool>())
+    {
+        return table[id].type == Type::Bool;
+    }
+    return value.is<float>() && toRaw(id, value.as<float>(), out);
+}
+
+bool SettingsStore::set(size_t id, JsonVariantConst value)
+{
+    if (!validate(id, value))
+    {
+        return false;
+    }
+    return set(id, value.is<bool>() ? (value.as<bool>() ? 1.0f : 0.0f) : value.as<float>());
+}
+
+bool SettingsStore::set(size_t id, float value)
+{
+    uint32_t out;
+    if (id >= count || !toRaw(id, value, out))
+    {
+        return false;
+    }
+    uint32_t previous = values[id].exchange(out, std::memory_order_relaxed);
+    if (previous != out && table[id].apply != nullptr)
+    {
+        table[id].apply(id);
+    }
+    return true;
+}
+
+void SettingsStore::reset()
+{
+    for (size_t id = 0; id < count; ++id)
+    {
+        values[id].store(defaultRaw(id), std::memory_order_relaxed);
+    }
+    applyAll();
+}
+
+void SettingsStore::applyAll()
+{
+    for (size_t id = 0; id < count; ++id)
+    {
+        if (table[id].apply != nullptr)
+        {
+            table[id].apply(id);
+        }
+    }
+}
+
+void SettingsStore::toJson(JsonObject out) const
+{
+    for (size_t id = 0; id < count; ++id)
+    {
+        switch (table[id].type)
+        {
+        case Type::Bool:
+            out[table[id].key] = getBool(id);
+            break;
+        case Type::U32:
+            out[table[id].key] = getU32(id);
+            break;
+        case Type::Float:
+            out[table[id].key] = getFloat(id);
+            break;
+        }
+    }
+}
+
+size_t SettingsStore::load(SettingsBackend &backend)
+{
+    size_t restored = 0;
+    if (!backend.open())
+    {
+        return 0;
+    }
+    for (size_t id = 0; id < count; ++id)
+    {
+        uint32_t stored;
+        uint32_t checked;
+        // Range is checked again, the table may have changed since the value was saved
+        if (backend.read(table[id].key, stored) && toRaw(id, toFloat(id, stored), checked))
+        {
+            values[id].store(checked, std::memory_order_relaxed);
+            ++restored;
+        }
+    }
+    return restored;
+}
+
+bool SettingsStore::save(SettingsBackend &backend) const
+{
+    if (!backend.open())
+    {
+        return false;
+    }
+    bool ok = true;
+    for (size_t id = 0; id < count; ++id)
+    {
+        uint32_t value = raw(id);
+        ok &= value == defaultRaw(id) ? backend.erase(table[id].key) : backend.write(table[id].key, value);
+    }
+    return backend.commit() && ok;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <ArduinoJson.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "settings_backend.h"
+
+// Typed runtime settings described by a constant table. Values are held as atomic 32-bit
+// patterns so any task can read them without locking. set() validates against the table and
+// runs the entry's apply hook, persistence is explicit through a SettingsBackend.
+// Has no Arduino dependency so it builds on the host with FileSettingsBackend.
+class SettingsStore
+{
+public:
+    static constexpr size_t MAX_ENTRIES = 32;
+
+    enum class Type : uint8_t
+    {
+        Bool,
+        U32,
+        Float
+    };
+
+    struct Descriptor
+    {
+        const char *key;           // Name on the wire and in storage, at most 15 characters
+        Type type;
+        float defaultValue;        // Integers must stay below 2^24 to be exact
+        float min;
+        float max;
+        void (*apply)(size_t id);  // Called after the value changed at runtime, may be null
+    };
+
+    SettingsStore(const Descriptor *table, size_t count);
+
+    size_t size() const { return count; }
+    const Descriptor &descriptor(size_t id) const { return table[id]; }
+    bool find(const char *key, size_t &id) const;
+
+    bool getBool(size_t id) const { return raw(id) != 0; }
+    uint32_t getU32(size_t id) const { return raw(id); }
+    float getFloat(size_t id) const;
+
+    bool validate(size_t id, JsonVariantConst value) const;
+    bool set(size_t id, JsonVariantConst value); // Validates, stores and applies
+    bool set(size_t id, float value);            // Bools as 0 or 1
+    void reset();                                // Back to the defaults, applied
+    void applyAll();                             // Run every apply hook with the current values
+    void toJson(JsonObject out) const;
+
+    size_t load(SettingsBackend &backend); // Number of values restored, out of range values are ignored
+    bool save(SettingsBackend &backend) const; // Values at their default are erased
+
+private:
+    uint32_t raw(size_t id) const { return values[id].load(std::memory_order_relaxed); }
+    bool toRaw(size_t id, float value, uint32_t &out) const;
+    float toFloat(size_t id, uint32_t raw) const;
+    uint32_t defaultRaw(size_t id) const;
+
+    const Descriptor *table;
+    size_t count;
+    std::atomic<uint32_t> values[MAX_ENTRIES];
+};
@@ -0,0 +1,155 @@
+#include "stream_filter.h"
+#include <cmath>
+#include <cstring>
+
+StreamFilter::StreamFilter()
+    : b0_(1.0f), b1_(0.0f), b2_(0.0f), a1_(0.0f), a2_(0.0f)
+{
+    reset();
+}
+
+bool StreamFilter::configure(const Config &config)
+{
+    if (config.decimation == 0)
+    {
+        return false;
+    }
+
+    if (config.type == Type::MovingAverage && (config.window == 0 || config.window > MAX_WINDOW))
+    {
+        return false;
+    }
+
+    if (config.type == Type::Biquad)
+    {
+        // Cut-off has to be below the Nyquist frequency of the decimated output, anything above
+        // it would alias back into the published samples
+        if (config.sampleRateHz <= 0.0f || config.cutoffHz <= 0.0f ||
+            config.cutoffHz >= 0.5f * config.sampleRateHz / config.decimation)
+        {
+            return false;
+        }
+
+        // RBJ cookbook low-pass with Q = 1/sqrt(2)
+        float w0 = 2.0f * 3.14159265f * config.cutoffHz / config.sampleRateHz;
+        float cw = cosf(w0);
+        float alpha = sinf(w0) * 0.70710678f;
+        float a0 = 1.0f + alpha;
+        b0_ = (1.0f - cw) * 0.5f / a0;
+        b1_ = (1.0f - cw) / a0;
+        b2_ = b0_;
+        a1_ = -2.0f * cw / a0;
+        a2_ = (1.0f - alpha) / a0;
+    }
+
+    config_ = config;
+    reset();
+    return true;
+}
+
+void StreamFilter::reset()
+{
+    count_ = 0;
+    accumulator_ = 0.0f;
+    windowIndex_ = 0;
+    windowFill_ = 0;
+    z1_ = 0.0f;
+    z2_ = 0.0f;
+    primed_ = false;
+    memset(window_, 0, sizeof(window_));
+}
+
+bool StreamFilter::push(float in, float &out)
+{
+    float value = in;
+
+    switch (config_.type)
+    {
+    case Type::None:
+        break;
+
+    case Type::MovingAverage:
+    {
+        window_[windowIndex_] = in;
+        windowIndex_ = (windowIndex_ + 1) % config_.window;
+        if (windowFill_ < config_.window)
+        {
+            ++windowFill_;
+        }
+        float sum = 0.0f;
+        for (uint8_t i = 0; i < windowFill_; ++i)
+        {
+            sum += window_[i];
+        }
+        value = sum / windowFill_;
+        break;
+    }
+
+    case Type::Boxcar:
+        accumulator_ = (count_ == 0) ? in : accumulator_ + in;
+        value = accumulator_ / (count_ + 1);
+        break;
+
+    case Type::Biquad:
+    {
+        if (!primed_)
+        {
+            // Start from steady state so the first outputs do not ramp up from zero
+            z1_ = in * (1.0f - b0_);
+            z2_ = in * (b2_ - a2_);
+            primed_ = true;
+        }
+        value = b0_ * in + z1_;
+        z1_ = b1_ * in - a1_ * value + z2_;
+        z2_ = b2_ * in - a2_ * value;
+        break;
+    }
+
+    case Type::Min:
+        accumulator_ = (count_ == 0 || in < accumulator_) ? in : accumulator_;
+        value = accumulator_;
+        break;
+
+    case Type::Max:
+        accumulator_ = (count_ == 0 || in > accumulator_) ? in : accumulator_;
+        value = accumulator_;
+        break;
+    }
+
+    if (++count_ < config_.decimation)
+    {
+        return false;
+    }
+    count_ = 0;
+    out = value;
+    return true;
+}
+
+static const char *const TYPE_NAMES[] = {"none", "ma", "boxcar", "biquad", "min", "max"};
+
+bool StreamFilter::parseType(const char *name, Type &type)
+{
+    if (name == nullptr)
+    {
+        return false;
+    }
+    if (strcmp(name, "mean") == 0)
+    {
+        type = Type::Boxcar; // A block mean is a first order CIC
+        return true;
+    }
+    for (uint8_t i = 0; i < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]); ++i)
+    {
+        if (strcmp(name, TYPE_NAMES[i]) == 0)
+        {
+            type = static_cast<Type>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *StreamFilter::typeName(Type type)
+{
+    return TYPE_NAMES[static_cast<uint8_t>(type)];
+}
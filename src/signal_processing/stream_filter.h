@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+// Per-stream filter stage placed between acquisition and publish.
+// Every filter produces one output per `decimation` inputs so the host receives
+// fewer, anti-aliased samples instead of point samples. State is statically sized.
+class StreamFilter
+{
+public:
+    static constexpr uint8_t MAX_WINDOW = 32; // Longest moving average window
+
+    enum class Type : uint8_t
+    {
+        None,          // Point sample every `decimation` inputs
+        MovingAverage, // Sliding mean over the last `window` inputs
+        Boxcar,        // Mean of each block of `decimation` inputs (first order CIC)
+        Biquad,        // Second order Butterworth low-pass at `cutoffHz`
+        Min,           // Minimum of each block of `decimation` inputs
+        Max            // Maximum of each block of `decimation` inputs
+    };
+
+    struct Config
+    {
+        Type type = Type::None;
+        uint16_t decimation = 1; // Inputs per output, 1 publishes every sample
+        uint8_t window = 1;      // Window length for the moving average
+        float cutoffHz = 0.0f;   // Cut-off frequency for the biquad, below sampleRateHz / (2 * decimation)
+        float sampleRateHz = 0.0f; // Input rate, used to design the biquad
+    };
+
+    StreamFilter();
+
+    bool configure(const Config &config); // Returns false and keeps the old config if invalid
+    const Config &getConfig() const { return config_; }
+    void reset();
+
+    // Feed one input, returns true and writes `out` when an output is due
+    bool push(float in, float &out);
+
+    static bool parseType(const char *name, Type &type);
+    static const char *typeName(Type type);
+
+private:
+    Config config_;
+    uint16_t count_; // Inputs seen in the current decimation block
+
+    // Block statistics
+    float accumulator_;
+
+    // Moving average ring
+    float window_[MAX_WINDOW];
+    uint8_t windowIndex_;
+    uint8_t windowFill_;
+
+    // Biquad coefficients and transposed direct form II state
+    float b0_, b1_, b2_, a1_, a2_;
+    float z1_, z2_;
+    bool primed_;
+};
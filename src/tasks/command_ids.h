@@ -0,0 +1,94 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Compile-time command ID (32-bit FNV-1a of the command name)
+constexpr uint32_t commandId(const char *name, uint32_t h = 2166136261u)
+{
+    return (*name == 0) ? h : commandId(name + 1, (h ^ static_cast<uint8_t>(*name)) * 16777619u);
+}
+
+// Every channel 254 command with its name and opcode. Opcodes are part of the host protocol,
+// never renumber them. Append new commands with the next free opcode, duplicates of a name,
+// an ID or an opcode stop the build below.
+#define COMMANDS(X)                                       \
+    X(Ping, "ping", 1)                                    \
+    X(GetWaterLevel, "get_water_level", 2)                \
+    X(GetHeapInfo, "get_heap_info", 3)                    \
+    X(GetBoards, "get_boards", 4)                         \
+    X(SetOrientation, "set_orientation", 5)               \
+    X(SetFilter, "set_filter", 6)                         \
+    X(GetLogFormats, "get_log_formats", 7)                \
+    X(GetHistory, "get_history", 8)                       \
+    X(GetHistoryInfo, "get_history_info", 9)              \
+    X(Ramp, "ramp", 10)                                   \
+    X(SetSlew, "set_slew", 11)                            \
+    X(SetFailsafe, "set_failsafe", 12)                    \
+    X(GetLatency, "get_latency", 13)                      \
+    X(ResetLatency, "reset_latency", 14)                  \
+    X(SetAllocation, "set_allocation", 15)                \
+    X(GetAllocation, "get_allocation", 16)                \
+    X(GetMotorStats, "get_motor_stats", 17)               \
+    X(ListCommands, "list_commands", 18)                  \
+    X(GetCpu, "get_cpu", 19)                              \
+    X(SetCpuProfile, "set_cpu_profile", 20)               \
+    X(GetSettings, "get_settings", 21)                    \
+    X(SetSettings, "set_settings", 22)                    \
+    X(ResetSettings, "reset_settings", 23)                \
+    X(GetAlloc, "get_alloc", 24)                          \
+    X(SetAlloc, "set_alloc", 25)                          \
+    X(SetBoardLeds, "set_board_leds", 26)                 \
+    X(SetBoardPattern, "set_board_pattern", 27)
+
+// Index into COMMAND_TABLE, what modules pass to CommandRegistry::add
+enum class Command : uint8_t
+{
+#define COMMAND_ENUM(symbol, name, opcode) symbol,
+    COMMANDS(COMMAND_ENUM)
+#undef COMMAND_ENUM
+        COUNT
+};
+
+enum class Opcode : uint8_t
+{
+    None = 0,
+#define COMMAND_OPCODE(symbol, name, opcode) symbol = opcode,
+    COMMANDS(COMMAND_OPCODE)
+#undef COMMAND_OPCODE
+};
+
+struct CommandInfo
+{
+    const char *name;
+    uint8_t opcode;
+    uint32_t id;
+};
+
+static constexpr CommandInfo COMMAND_TABLE[] = {
+#define COMMAND_INFO(symbol, name, opcode) {name, opcode, commandId(name)},
+    COMMANDS(COMMAND_INFO)
+#undef COMMAND_INFO
+};
+
+static constexpr size_t COMMAND_COUNT = static_cast<size_t>(Command::COUNT);
+
+constexpr const CommandInfo &commandInfo(Command command)
+{
+    return COMMAND_TABLE[static_cast<size_t>(command)];
+}
+
+// Recursive so it stays a C++11 constant expression
+constexpr bool commandsClash(size_t i, size_t j)
+{
+    return j >= COMMAND_COUNT ? false
+                              : (COMMAND_TABLE[i].id == COMMAND_TABLE[j].id ||
+                                 (COMMAND_TABLE[i].opcode != 0 && COMMAND_TABLE[i].opcode == COMMAND_TABLE[j].opcode) ||
+                                 commandsClash(i, j + 1));
+}
+
+constexpr bool anyCommandsClash(size_t i = 0)
+{
+    return i >= COMMAND_COUNT ? false : (commandsClash(i, i + 1) || anyCommandsClash(i + 1));
+}
+
+static_assert(!anyCommandsClash(), "Two commands share a name, an ID or an opcode");
@@ -0,0 +1,165 @@
+#include "command_registry.h"
+#include "serial_coms/serial_io.h"
+#include "logging/binary_log.h"
+#include "tasks/led_control.h"
+
+extern SerialIO serialio;
+
+CommandRegistry commandRegistry;
+
+static_assert(commandId("a") == 0xe40c292cu, "commandId must be 32-bit FNV-1a");
+static_assert(COMMAND_COUNT <= COMMAND_REGISTRY_SIZE, "COMMAND_REGISTRY_SIZE is smaller than the command table");
+
+// Same hash as commandId() without the recursion, for names only known at runtime
+static uint32_t runtimeCommandId(const char *name)
+{
+    uint32_t h = 2166136261u;
+    while (*name)
+    {
+        h = (h ^ static_cast<uint8_t>(*name++)) * 16777619u;
+    }
+    return h;
+}
+
+bool CommandRegistry::add(Command command, CommandHandler handler)
+{
+    const CommandInfo &info = commandInfo(command);
+    uint32_t id = info.id;
+    uint8_t opcode = info.opcode;
+    bool ok = false;
+
+    portENTER_CRITICAL(&mux);
+    size_t pos = 0;
+    while (pos < count && entries[pos].id < id)
+    {
+        ++pos;
+    }
+    bool clash = (pos < count && entries[pos].id == id) || (opcode != NO_OPCODE && opcodeTable[opcode] != 0);
+    if (count < COMMAND_REGISTRY_SIZE && !clash && handler != nullptr)
+    {
+        for (size_t i = count; i > pos; --i)
+        {
+            entries[i] = entries[i - 1];
+        }
+        entries[pos] = {id, opcode, info.name, handler};
+        ++count;
+
+        // Inserting shifted the entries behind pos, rebuild the opcode table
+        memset(opcodeTable, 0, sizeof(opcodeTable));
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (entries[i].opcode != NO_OPCODE)
+            {
+                opcodeTable[entries[i].opcode] = static_cast<uint8_t>(i + 1);
+            }
+        }
+        ok = true;
+    }
+    else
+    {
+        ++rejected;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    // A command registered twice is a wiring bug, make it show up on the link and the status LED
+    if (!ok)
+    {
+        LOG_WEBSERIALLN("Failed to register command " + String(info.name));
+        LOG_DEFERRED(COMMAND_REJECTED, opcode);
+        ledControl.signal(LedControl::EVENT_ERROR);
+    }
+    return ok;
+}
+
+bool CommandRegistry::find(JsonVariantConst command, Entry &entry) const
+{
+    bool found = false;
+    portENTER_CRITICAL(&mux);
+    if (command.is<uint8_t>())
+    {
+        uint8_t slot = opcodeTable[command.as<uint8_t>()];
+        if (slot != 0)
+        {
+            entry = entries[slot - 1];
+            found = true;
+        }
+    }
+    else if (command.is<const char *>())
+    {
+        const char *name = command.as<const char *>();
+        uint32_t id = runtimeCommandId(name);
+        size_t lo = 0;
+        size_t hi = count;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (entries[mid].id < id)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        // The hash only narrows the search, an unknown name may collide with a registered one
+        if (lo < count && entries[lo].id == id && strcmp(entries[lo].name, name) == 0)
+        {
+            entry = entries[lo];
+            found = true;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+    return found;
+}
+
+bool CommandRegistry::dispatch(const JsonDocument &request)
+{
+    Entry entry;
+    if (!find(request["cmd"], entry))
+    {
+        LOG_WEBSERIALLN("Unknown command: " + request["cmd"].as<String>());
+        return false;
+    }
+
+    JsonDocument response;
+    int status = entry.handler(request, response);
+    response["status"] = status;
+    response["timestamp"] = millis();
+    // Echo the request id so the host can match replies with requests
+    if (!request["id"].isNull())
+    {
+        response["id"] = request["id"];
+    }
+    serialio.publish(254, response);
+    return true;
+}
+
+void CommandRegistry::list(JsonDocument &doc) const
+{
+    Entry snapshot[COMMAND_REGISTRY_SIZE];
+    portENTER_CRITICAL(&mux);
+    size_t n = count;
+    uint32_t failed = rejected;
+    for (size_t i = 0; i < n; ++i)
+    {
+        snapshot[i] = entries[i];
+    }
+    portEXIT_CRITICAL(&mux);
+
+    JsonArray commands = doc["commands"].to<JsonArray>();
+    for (size_t i = 0; i < n; ++i)
+    {
+        JsonObject command = commands.add<JsonObject>();
+        command["n"] = snapshot[i].name;
+        command["id"] = snapshot[i].id;
+        if (snapshot[i].opcode != NO_OPCODE)
+        {
+            command["op"] = snapshot[i].opcode;
+        }
+    }
+    if (failed != 0)
+    {
+        doc["rejected"] = failed;
+    }
+}
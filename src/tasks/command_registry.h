@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "configuration.h"
+#include "command_ids.h"
+
+// Fills the response and returns its status code, status and timestamp are added by the registry
+using CommandHandler = int (*)(const JsonDocument &request, JsonDocument &response);
+
+// Table of channel 254 commands. Names, IDs and opcodes are fixed at compile time in
+// command_ids.h, modules register their handlers at startup. The host sends either
+// {"cmd": "name"} or the compact {"cmd": opcode}; opcodes index a flat table, names are
+// hashed without copying and binary searched.
+class CommandRegistry
+{
+public:
+    static constexpr uint8_t NO_OPCODE = 0;
+
+    struct Entry
+    {
+        uint32_t id;
+        uint8_t opcode;
+        const char *name; // Must outlive the registry, normally a string literal
+        CommandHandler handler;
+    };
+
+    bool add(Command command, CommandHandler handler); // False on a full table or a second registration, logged on channel 10
+    bool dispatch(const JsonDocument &request);                         // Runs the handler and publishes the response on 254
+    bool find(JsonVariantConst command, Entry &entry) const;
+    void list(JsonDocument &doc) const;
+
+private:
+    Entry entries[COMMAND_REGISTRY_SIZE]; // Sorted by id
+    size_t count = 0;
+    uint32_t rejected = 0; // Failed registrations, reported by list()
+    uint8_t opcodeTable[256] = {}; // Entry index + 1 per opcode, 0 when unused
+    mutable portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+extern CommandRegistry commandRegistry;
@@ -1,18 +1,26 @@
 #include "led_control.h"
 
+static const Ws2812Strip::Color BLACK = {0, 0, 0};
+static const Ws2812Strip::Color GREEN = {0, 255, 0};
+
 void LedControl::setup()
 {
-    // Initialize the LED array
-    FastLED.addLeds<WS2812, LED_PIN, GRB>(leds, NUM_LEDS);
-    FastLED.setBrightness(50);
+    strip.begin(LED_PIN, static_cast<rmt_channel_t>(LED_RMT_CHANNEL));
 
     // flash 3 times to indicate setup
     for (int i = 0; i < 3; ++i)
     {
-        FastLED.showColor(CRGB::Green);
+        for (auto &led : leds)
+        {
+            led = GREEN;
+        }
+        strip.show(leds, NUM_LEDS, LED_BRIGHTNESS);
         delay(50);
-        FastLED.clear();
-        FastLED.show();
+        for (auto &led : leds)
+        {
+            led = BLACK;
+        }
+        strip.show(leds, NUM_LEDS, LED_BRIGHTNESS);
         delay(50);
     }
 
@@ -33,15 +41,67 @@ void LedControl::ledBlinkTaskWrapper(void *parameter)
     instance->ledBlinkTask();
 }
 
+// Seconds-scale brightness ramp, 0 to 255 and back over periodMs
+static uint8_t triangle(uint32_t now, uint32_t periodMs)
+{
+    uint32_t phase = (now % periodMs) * 510 / periodMs;
+    return phase < 256 ? phase : 510 - phase;
+}
+
+static Ws2812Strip::Color scaled(Ws2812Strip::Color color, uint8_t level)
+{
+    return {static_cast<uint8_t>(color.r * level / 255), static_cast<uint8_t>(color.g * level / 255), static_cast<uint8_t>(color.b * level / 255)};
+}
+
+void LedControl::render(uint32_t now)
+{
+    uint32_t events = pending.exchange(0, std::memory_order_relaxed);
+    for (uint8_t e = 0; e < EVENT_COUNT; ++e)
+    {
+        if (events & (1u << e))
+        {
+            lastEventMs[e] = now | 1; // 0 means never
+        }
+    }
+    auto since = [&](Event event) -> uint32_t
+    {
+        uint8_t e = __builtin_ctz(event);
+        return lastEventMs[e] == 0 ? UINT32_MAX : now - lastEventMs[e];
+    };
+    bool blinkOn = (now / LED_SPEED) % 2 == 0;
+
+    Ws2812Strip::Color frame[6];
+    frame[0] = since(EVENT_RX) < STATUS_LINK_TIMEOUT_MS ? scaled(GREEN, 32 + triangle(now, 2000) * 223 / 255)
+                                                      : (blinkOn ? Ws2812Strip::Color{255, 0, 0} : BLACK);
+    frame[1] = since(EVENT_RX) < STATUS_FLASH_MS ? Ws2812Strip::Color{0, 0, 255} : BLACK;
+    frame[2] = since(EVENT_TX) < STATUS_FLASH_MS ? Ws2812Strip::Color{0, 255, 255} : BLACK;
+    frame[3] = since(EVENT_ERROR) < STATUS_HOLD_MS ? Ws2812Strip::Color{255, 0, 0} : BLACK;
+    frame[4] = since(EVENT_FAILSAFE) < STATUS_HOLD_MS && blinkOn ? Ws2812Strip::Color{255, 120, 0} : BLACK;
+    frame[5] = now % 1000 < 100 ? Ws2812Strip::Color{64, 64, 64} : BLACK;
+
+    for (size_t i = 0; i < NUM_LEDS; ++i)
+    {
+        Ws2812Strip::Color color = i < 6 ? frame[i] : BLACK;
+        if (memcmp(&color, &leds[i], sizeof(color)) != 0)
+        {
+            leds[i] = color;
+            dirty = true;
+        }
+    }
+}
+
 void LedControl::ledBlinkTask()
 {
+    const TickType_t period = pdMS_TO_TICKS(1000 / STATUS_LED_FPS);
+    TickType_t lastWake = xTaskGetTickCount();
     for (;;)
     {
-        // Blink the LEDs
-        FastLED.showColor(CRGB::Red);
-        vTaskDelay(pdMS_TO_TICKS(500));
-        FastLED.clear();
-        FastLED.show();
-        vTaskDelay(pdMS_TO_TICKS(500));
+        render(millis());
+        // A frame that is still being sent is simply retried on the next tick
+        if (dirty && strip.show(leds, NUM_LEDS, LED_BRIGHTNESS))
+        {
+            dirty = false;
+        }
+        vTaskDelayUntil(&lastWake, period);
     }
 }
@@ -1,16 +1,42 @@
 #pragma once
 #include <Arduino.h>
-#define FASTLED_INTERRUPT_RETRY_COUNT 3
-#include <FastLED.h>
+#include <atomic>
 #include "configuration.h"
+#include "led/ws2812_strip.h"
 
+// Status LEDs. Any task reports events with signal(), which only sets bits, and the LED task
+// turns the accumulated events into patterns at STATUS_LED_FPS:
+//   LED 0: link, green breathing while frames arrive, red blink after STATUS_LINK_TIMEOUT_MS without one
+//   LED 1: blue flash on every received frame
+//   LED 2: cyan flash on every published frame
+//   LED 3: red while a framing, CRC or decode error happened in the last STATUS_HOLD_MS
+//   LED 4: amber blink while an ESC failsafe tripped in the last STATUS_HOLD_MS
+//   LED 5: heartbeat of the LED task
 class LedControl
 {
 public:
+    enum Event : uint32_t
+    {
+        EVENT_RX = 1u << 0,
+        EVENT_TX = 1u << 1,
+        EVENT_ERROR = 1u << 2,
+        EVENT_FAILSAFE = 1u << 3,
+        EVENT_COUNT = 4
+    };
+
     void setup();
+    void signal(uint32_t events) { pending.fetch_or(events, std::memory_order_relaxed); }
 
 private:
     static void ledBlinkTaskWrapper(void *parameter);
     void ledBlinkTask();
-    CRGB leds[NUM_LEDS]; // Array to hold LED colors
+    void render(uint32_t now);
+
+    Ws2812Strip strip;
+    Ws2812Strip::Color leds[NUM_LEDS];
+    bool dirty = true; // Unchanged frames are not resent
+    std::atomic<uint32_t> pending{0};
+    uint32_t lastEventMs[EVENT_COUNT] = {};
 };
+
+extern LedControl ledControl;
@@ -1,77 +1,453 @@
 #include "motor_control.h"
 #include "ArduinoJson.h"
+#include "esp_timer.h"
+#include "serial_coms/serial_io.h"
+#include "diagnostics/latency_probe.h"
+#include "tasks/led_control.h"
 
-QueueHandle_t motorQueue;
-double lastRequestTime = 0.0;
+extern SerialIO serialio;
 
-void motorControlTask(void *parameter)
+#if USE_DUTY_US
+// Profiles run in microseconds, limits are given in throttle units and scaled to match
+#define PROFILE_NEUTRAL static_cast<float>(ESC_MID)
+#define PROFILE_SCALE static_cast<float>(ESC_MAX - ESC_MID)
+#else
+#define PROFILE_NEUTRAL 0.0f
+#define PROFILE_SCALE 1.0f
+#endif
+
+// Host values are throttle (-1..1), profiles and the failsafe fallbacks run in profile units
+static float throttleToProfile(float throttle)
+{
+    throttle = throttle < -1.0f ? -1.0f : (throttle > 1.0f ? 1.0f : throttle);
+    return PROFILE_NEUTRAL + throttle * PROFILE_SCALE;
+}
+
+static float profileToThrottle(float value)
+{
+    return (value - PROFILE_NEUTRAL) / PROFILE_SCALE;
+}
+
+CommandMailbox motorMailbox;
+ESCWatchdog motorWatchdog;
+
+static ESCBank escBank;
+static ThrustProfile profiles[NUM_ESC];
+static portMUX_TYPE profileMux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t profileTimer = nullptr;
+static float appliedOutput[NUM_ESC];
+static float failsafeValue[NUM_ESC];
+static volatile uint32_t hostCommandMs[NUM_ESC]; // Last host command per ESC, for controller override
+
+static ThrustAllocator allocator(NUM_ESC);
+static ThrustAllocator::Result lastAllocation = {{1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f}, false};
+static portMUX_TYPE allocMux = portMUX_INITIALIZER_UNLOCKED;
+static float pendingWrench[ThrustAllocator::DOF]; // Latest wrench, overwritten like the mailbox
+static bool wrenchPending = false;
+
+static void setupAllocator()
+{
+    static const float matrix[NUM_ESC][ThrustAllocator::DOF] = ALLOCATION_MATRIX;
+    static const uint8_t priorities[ThrustAllocator::DOF] = ALLOCATION_PRIORITIES;
+
+    ThrustAllocator::Curve curve;
+    curve.maxForward = THRUSTER_MAX_FORWARD_N;
+    curve.maxReverse = THRUSTER_MAX_REVERSE_N;
+    curve.exponent = THRUSTER_CURVE_EXPONENT;
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        allocator.setRow(i, matrix[i]);
+        allocator.setCurve(i, curve);
+    }
+    allocator.setPriorities(priorities);
+}
+
+// Allocate a pending wrench onto the profiles, returns the ESCs it was applied to
+static uint32_t applyPendingWrench()
 {
-    ESCDriver *escDrivers[NUM_ESC];
-    int esc_pins[NUM_ESC] = ESC_PINS;
+    float wrench[ThrustAllocator::DOF];
+    portENTER_CRITICAL(&allocMux);
+    bool pending = wrenchPending;
+    wrenchPending = false;
+    for (size_t j = 0; j < ThrustAllocator::DOF; ++j)
+    {
+        wrench[j] = pendingWrench[j];
+    }
+    portEXIT_CRITICAL(&allocMux);
+    if (!pending)
+    {
+        return 0;
+    }
 
-    for (size_t i = 0; i < NUM_ESC; ++i)
+    float throttles[NUM_ESC];
+    ThrustAllocator::Result result;
+    portENTER_CRITICAL(&allocMux);
+    allocator.allocate(wrench, throttles, &result);
+    lastAllocation = result;
+    portEXIT_CRITICAL(&allocMux);
+
+    uint32_t now = millis() | 1;
+    portENTER_CRITICAL(&profileMux);
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
     {
-        escDrivers[i] = new ESCDriver(esc_pins[i], ESC_PWM_FREQUENCY, ESC_PWM_RESOLUTION, i);
-        escDrivers[i]->setThrottle(0.0f); // Initialize ESC with 0% throttle
+        hostCommandMs[i] = now;
+        profiles[i].setTarget(PROFILE_NEUTRAL + throttles[i] * PROFILE_SCALE);
     }
+    portEXIT_CRITICAL(&profileMux);
+    return (1u << NUM_ESC) - 1;
+}
 
-    JsonDocument *doc;
+// Called from the failsafe timer, skips the profile limits and goes straight to the fallback
+static void onFailsafe(uint8_t index)
+{
+    portENTER_CRITICAL(&profileMux);
+    profiles[index].reset(failsafeValue[index]);
+    portEXIT_CRITICAL(&profileMux);
+}
 
-    for (;;)
+static void publishFailsafe(uint32_t expired)
+{
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
     {
-        if (xQueueReceive(motorQueue, &doc, pdMS_TO_TICKS(100)) == pdPASS)
+        if (!(expired & (1u << i)))
         {
-            lastRequestTime = millis() / 1000.0;
-            for (JsonPair kv : (*doc).as<JsonObject>())
-            {
-                int idx = atoi(kv.key().c_str());
-                if (idx >= 0 && idx < NUM_ESC)
-                {
+            continue;
+        }
+        JsonDocument doc;
+        doc["e"] = i;
+        doc["v"] = profileToThrottle(failsafeValue[i]);
+        doc["ms"] = motorWatchdog.getTimeoutMs(i);
+        doc["n"] = motorWatchdog.getTrips(i);
+        serialio.publish(FAILSAFE_CHANNEL, doc);
+        ledControl.signal(LedControl::EVENT_FAILSAFE);
+    }
+}
+
+// Runs once per PWM frame, advances every profile and latches the changed outputs together
+static void profileTimerCallback(void *arg)
+{
+    const float dt = 1.0f / MOTOR_PROFILE_RATE_HZ;
+    float outputs[NUM_ESC];
+
+    portENTER_CRITICAL(&profileMux);
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        outputs[i] = profiles[i].step(dt);
+    }
+    portEXIT_CRITICAL(&profileMux);
+
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        if (outputs[i] == appliedOutput[i])
+        {
+            continue;
+        }
+        appliedOutput[i] = outputs[i];
 #if USE_DUTY_US
-                    uint32_t dutyUs = kv.value().as<uint32_t>() | ESC_MID; // Default to the 0 value
-                    escDrivers[idx]->setDutyUs(dutyUs);
+        escBank.setDutyUs(i, static_cast<uint32_t>(lroundf(outputs[i])));
 #else
-                    float throttle = kv.value().as<float>();
-
-                    escDrivers[idx]
-                        ->setThrottle(throttle);
+        escBank.setThrottle(i, outputs[i]);
 #endif
-                }
+    }
+    escBank.commit();
+    LATENCY_MARK(PwmWrite);
+}
+
+static bool startProfileTimer()
+{
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        profiles[i].reset(PROFILE_NEUTRAL);
+        profiles[i].setLimits(MOTOR_SLEW_LIMIT * PROFILE_SCALE, MOTOR_ACCEL_LIMIT * PROFILE_SCALE);
+        appliedOutput[i] = PROFILE_NEUTRAL;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = profileTimerCallback;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "thrust_profile";
+    if (esp_timer_create(&args, &profileTimer) != ESP_OK ||
+        esp_timer_start_periodic(profileTimer, 1000000ULL / MOTOR_PROFILE_RATE_HZ) != ESP_OK)
+    {
+        LOG_WEBSERIALLN("Failed to start thrust profile timer");
+        return false;
+    }
+    return true;
+}
+
+void motorControlTask(void *parameter)
+{
+    escBank.begin(); // Initialize ESCs with 0% throttle
+    startProfileTimer();
+
+    for (;;)
+    {
+        // Woken as soon as a batch of setpoints has been posted or a failsafe fired
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t applied = 0;
+        portENTER_CRITICAL(&profileMux);
+        for (uint8_t idx = 0; idx < NUM_ESC; ++idx)
+        {
+            float value;
+            if (!motorMailbox.take(idx, value))
+            {
+                continue;
             }
-            delete doc;
+            applied |= 1u << idx;
+            hostCommandMs[idx] = millis() | 1; // Never 0, which means never commanded
+            profiles[idx].setTarget(value);    // Shaped by the profile timer
         }
-        else
+        portEXIT_CRITICAL(&profileMux);
+        applied |= applyPendingWrench();
+        if (applied)
         {
-            double now = millis() / 1000.0;
-            if (now - lastRequestTime > SAFETY_TIMEOUT)
+            LATENCY_MARK(Taken);
+        }
+
+        // Only the ESCs that received a command get their deadline pushed back
+        for (uint8_t idx = 0; idx < NUM_ESC; ++idx)
+        {
+            if (applied & (1u << idx))
             {
-                for (size_t i = 0; i < NUM_ESC; ++i)
-                {
-                    escDrivers[i]->setThrottle(0.0f);
-                }
-                lastRequestTime = now; // Prevent repeated resets
+                motorWatchdog.feed(idx);
             }
         }
-        taskYIELD(); // Yield only if there are higher priority tasks ready to run
+
+        uint32_t expired = motorWatchdog.takeExpired();
+        if (expired)
+        {
+            publishFailsafe(expired);
+        }
+    }
+}
+
+void postMotorCommand(const JsonDocument &doc)
+{
+    for (JsonPairConst kv : doc.as<JsonObjectConst>())
+    {
+        int idx = atoi(kv.key().c_str());
+        if (idx >= 0 && idx < NUM_ESC)
+        {
+#if USE_DUTY_US
+            uint32_t dutyUs = kv.value() | ESC_MID; // Default to the 0 value
+            motorMailbox.post(idx, static_cast<float>(dutyUs));
+#else
+            motorMailbox.post(idx, kv.value().as<float>());
+#endif
+        }
+    }
+    LATENCY_MARK(Posted);
+    motorMailbox.notify();
+}
+
+void postWrenchCommand(const JsonDocument &doc)
+{
+    JsonArrayConst values = doc["w"];
+    if (values.size() != ThrustAllocator::DOF)
+    {
+        return;
+    }
+    portENTER_CRITICAL(&allocMux);
+    for (size_t j = 0; j < ThrustAllocator::DOF; ++j)
+    {
+        pendingWrench[j] = values[j] | 0.0f;
+    }
+    wrenchPending = true;
+    portEXIT_CRITICAL(&allocMux);
+    motorMailbox.notify();
+}
+
+bool setAllocationRow(uint8_t index, const float (&row)[ThrustAllocator::DOF])
+{
+    portENTER_CRITICAL(&allocMux);
+    bool ok = allocator.setRow(index, row);
+    portEXIT_CRITICAL(&allocMux);
+    return ok;
+}
+
+bool setAllocationCurve(uint8_t index, const ThrustAllocator::Curve &curve)
+{
+    portENTER_CRITICAL(&allocMux);
+    bool ok = allocator.setCurve(index, curve);
+    portEXIT_CRITICAL(&allocMux);
+    return ok;
+}
+
+bool getAllocationCurve(uint8_t index, ThrustAllocator::Curve &curve)
+{
+    portENTER_CRITICAL(&allocMux);
+    bool ok = allocator.getCurve(index, curve);
+    portEXIT_CRITICAL(&allocMux);
+    return ok;
+}
+
+void setAllocationPriorities(const uint8_t (&priorities)[ThrustAllocator::DOF])
+{
+    portENTER_CRITICAL(&allocMux);
+    allocator.setPriorities(priorities);
+    portEXIT_CRITICAL(&allocMux);
+}
+
+void getAllocation(JsonDocument &doc)
+{
+    float rows[NUM_ESC][ThrustAllocator::DOF];
+    ThrustAllocator::Curve curves[NUM_ESC];
+    uint8_t priorities[ThrustAllocator::DOF];
+    ThrustAllocator::Result result;
+    portENTER_CRITICAL(&allocMux);
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        allocator.getRow(i, rows[i]);
+        allocator.getCurve(i, curves[i]);
+    }
+    allocator.getPriorities(priorities);
+    result = lastAllocation;
+    portEXIT_CRITICAL(&allocMux);
+
+    JsonArray matrix = doc["m"].to<JsonArray>();
+    JsonArray curveArray = doc["c"].to<JsonArray>();
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        JsonArray row = matrix.add<JsonArray>();
+        for (size_t j = 0; j < ThrustAllocator::DOF; ++j)
+        {
+            row.add(rows[i][j]);
+        }
+        JsonObject curve = curveArray.add<JsonObject>();
+        curve["fw"] = curves[i].maxForward;
+        curve["rv"] = curves[i].maxReverse;
+        curve["e"] = curves[i].exponent;
+    }
+    JsonArray priorityArray = doc["p"].to<JsonArray>();
+    JsonArray scaleArray = doc["s"].to<JsonArray>();
+    for (size_t j = 0; j < ThrustAllocator::DOF; ++j)
+    {
+        priorityArray.add(priorities[j]);
+        scaleArray.add(result.scale[j]);
+    }
+    doc["sat"] = result.saturated;
+}
+
+bool setMotorRamp(uint8_t index, float target, uint32_t durationMs)
+{
+    if (index >= NUM_ESC)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&profileMux);
+    profiles[index].rampTo(throttleToProfile(target), durationMs / 1000.0f);
+    portEXIT_CRITICAL(&profileMux);
+    hostCommandMs[index] = millis() | 1;
+    motorWatchdog.feed(index);
+    return true;
+}
+
+bool setMotorLimits(uint8_t index, float slewPerS, float accelPerS2)
+{
+    if (index >= NUM_ESC || slewPerS < 0.0f || accelPerS2 < 0.0f)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&profileMux);
+    profiles[index].setLimits(slewPerS * PROFILE_SCALE, accelPerS2 * PROFILE_SCALE);
+    portEXIT_CRITICAL(&profileMux);
+    return true;
+}
+
+bool getMotorProfile(uint8_t index, float &output, float &target)
+{
+    if (index >= NUM_ESC)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&profileMux);
+    output = profiles[index].getOutput();
+    target = profiles[index].getTarget();
+    portEXIT_CRITICAL(&profileMux);
+    return true;
+}
+
+bool setMotorFailsafe(uint8_t index, uint32_t timeoutMs, float fallback)
+{
+    if (index >= NUM_ESC)
+    {
+        return false;
+    }
+    portENTER_CRITICAL(&profileMux);
+    failsafeValue[index] = throttleToProfile(fallback);
+    portEXIT_CRITICAL(&profileMux);
+    return motorWatchdog.setTimeoutMs(index, timeoutMs);
+}
+
+float getMotorFailsafeValue(uint8_t index)
+{
+    return index < NUM_ESC ? profileToThrottle(failsafeValue[index]) : 0.0f;
+}
+
+static bool isOverridden(uint8_t index, uint32_t now)
+{
+    uint32_t last = hostCommandMs[index];
+    return last != 0 && now - last < HOLD_OVERRIDE_MS;
+}
+
+// Does not feed the watchdog: an on-device controller must not keep an ESC alive once the
+// host has gone quiet, and a tripped ESC stays at its fallback until the host feeds it again
+bool setMotorControlOutput(uint8_t index, float throttle)
+{
+    if (index >= NUM_ESC || isOverridden(index, millis()))
+    {
+        return false;
+    }
+    float target = throttleToProfile(throttle);
+    // Checked under the lock onFailsafe takes, so a trip can't land between the check and the write
+    portENTER_CRITICAL(&profileMux);
+    bool tripped = motorWatchdog.getTripped() & (1u << index);
+    if (!tripped)
+    {
+        profiles[index].setTarget(target);
+    }
+    portEXIT_CRITICAL(&profileMux);
+    return !tripped;
+}
+
+uint32_t getMotorOverrideMask()
+{
+    uint32_t now = millis();
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        if (isOverridden(i, now))
+        {
+            mask |= 1u << i;
+        }
     }
+    return mask;
 }
 
-QueueHandle_t *setupMotorControl()
+CommandMailbox *setupMotorControl()
 {
-    motorQueue = xQueueCreate(MOTOR_QUEUE_SIZE, sizeof(JsonDocument *));
-    if (motorQueue == NULL)
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        failsafeValue[i] = PROFILE_NEUTRAL;
+    }
+    setupAllocator();
+    if (!motorWatchdog.begin(onFailsafe))
     {
-        LOG_WEBSERIALLN("Failed to create motor control queue");
+        LOG_WEBSERIALLN("Failed to start the ESC failsafe watchdog");
         return nullptr;
     }
 
-    BaseType_t taskResult = xTaskCreatePinnedToCore(motorControlTask, "MotorControlTask", MOTOR_TASK_STACK_SIZE, NULL, MOTOR_TASK_PRIORITY, NULL, 1);
+    TaskHandle_t taskHandle = NULL;
+    BaseType_t taskResult = xTaskCreatePinnedToCore(motorControlTask, "MotorControlTask", MOTOR_TASK_STACK_SIZE, NULL, MOTOR_TASK_PRIORITY, &taskHandle, 1);
     if (taskResult != pdPASS)
     {
         LOG_WEBSERIALLN("Failed to create motor control task");
         return nullptr;
     }
+    motorMailbox.setConsumer(taskHandle);
+    motorWatchdog.setConsumer(taskHandle);
 
-    LOG_WEBSERIALLN("Motor control task and queue created successfully");
-    return &motorQueue;
+    LOG_WEBSERIALLN("Motor control task and mailbox created successfully");
+    return &motorMailbox;
 }
@@ -1,6 +1,28 @@
 #pragma once
 #include <Arduino.h>
-#include "motor_control/esc_driver.h"
+#include <ArduinoJson.h>
+#include "motor_control/esc_bank.h"
+#include "motor_control/command_mailbox.h"
+#include "motor_control/thrust_profile.h"
+#include "motor_control/esc_watchdog.h"
+#include "control/thrust_allocator.h"
+
+extern CommandMailbox motorMailbox;
+extern ESCWatchdog motorWatchdog;
 
 void motorControlTask(void *parameter);
-QueueHandle_t *setupMotorControl();
+void postMotorCommand(const JsonDocument &doc); // Post a channel 1 command, safe from any task
+void postWrenchCommand(const JsonDocument &doc); // Post a WRENCH_CHANNEL command, safe from any task
+bool setAllocationRow(uint8_t index, const float (&row)[ThrustAllocator::DOF]);
+bool setAllocationCurve(uint8_t index, const ThrustAllocator::Curve &curve);
+bool getAllocationCurve(uint8_t index, ThrustAllocator::Curve &curve);
+void setAllocationPriorities(const uint8_t (&priorities)[ThrustAllocator::DOF]);
+void getAllocation(JsonDocument &doc); // Matrix, priorities, curves and the scales of the last wrench
+bool setMotorRamp(uint8_t index, float target, uint32_t durationMs); // Reach target (throttle, -1..1) over durationMs
+bool setMotorLimits(uint8_t index, float slewPerS, float accelPerS2); // Throttle units, 0 disables
+bool getMotorProfile(uint8_t index, float &output, float &target);
+bool setMotorFailsafe(uint8_t index, uint32_t timeoutMs, float fallback); // Fallback is throttle (-1..1), timeout 0 disables
+float getMotorFailsafeValue(uint8_t index);                                // Throttle units
+bool setMotorControlOutput(uint8_t index, float throttle); // On-device controllers, false while the host overrides the ESC or it is in failsafe
+uint32_t getMotorOverrideMask();                          // Bit per ESC the host has commanded within HOLD_OVERRIDE_MS
+CommandMailbox *setupMotorControl();
@@ -2,49 +2,430 @@
 #include "configuration.h"
 #include "ArduinoJson.h"
 #include "serial_coms/serial_io.h"
+#include "device_bus/sensor_handler.h"
+#include "logging/binary_log.h"
+#include "serial_coms/telemetry_history.h"
+#include "tasks/motor_control.h"
+#include "diagnostics/latency_probe.h"
+#include "diagnostics/cpu_profiler.h"
+#include "tasks/command_registry.h"
+#include "settings/settings.h"
 // #include "freertos/FreeRTOS.h"
 // #include "freertos/task.h"
 
-extern SerialIO serialio; // Serial communication handler
+extern SerialIO serialio;           // Serial communication handler
+extern SensorHandler sensorHandler; // Sensor board bookkeeping
 
-// string hash function for switch case statements
-constexpr unsigned long long hash_str(const char *str, unsigned long long h = 0)
+QueueHandle_t signalQueue;
+
+void getHeapInfo(JsonDocument &doc)
 {
-    return (*str == 0) ? h : hash_str(str + 1, h * 31 + *str);
+    size_t freeHeap = esp_get_free_heap_size();
+    size_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    doc["free_heap"] = freeHeap;
+    doc["largest_free_block"] = largestBlock;
 }
 
-QueueHandle_t signalQueue;
+static int handlePing(const JsonDocument &request, JsonDocument &response)
+{
+    response["msg"] = "pong";
+    return 200;
+}
+
+static int handleGetWaterLevel(const JsonDocument &request, JsonDocument &response)
+{
+    LOG_WEBSERIALLN("Received get_water_level command");
+    cpuProfiler.getStackHighWater(response);
+    return 200;
+}
+
+static int handleGetHeapInfo(const JsonDocument &request, JsonDocument &response)
+{
+    getHeapInfo(response);
+    return 200;
+}
+
+static int handleGetBoards(const JsonDocument &request, JsonDocument &response)
+{
+    sensorHandler.getBoards(response);
+    return 200;
+}
 
-void getHighWater(JsonDocument &doc)
+static int handleSetOrientation(const JsonDocument &request, JsonDocument &response)
 {
-    UBaseType_t numTasks = uxTaskGetNumberOfTasks();
-    TaskStatus_t *taskStatusArray = (TaskStatus_t *)pvPortMalloc(numTasks * sizeof(TaskStatus_t));
-    if (!taskStatusArray)
+    // Same values as the ahrs_ms and ahrs_en settings, not saved
+    bool ok = true;
+    if (!request["ms"].isNull())
     {
-        doc["error"] = "Memory allocation failed";
-        return;
+        ok &= setSetting(Setting::OrientationPeriodMs, request["ms"]);
     }
+    if (request["en"].isNull())
+    {
+        ok &= setSetting(Setting::OrientationEnabled, 1.0f);
+    }
+    else
+    {
+        ok &= setSetting(Setting::OrientationEnabled, request["en"]);
+    }
+    if (!ok)
+    {
+        response["error"] = "Invalid orientation configuration";
+        return 400;
+    }
+    return 200;
+}
 
-    numTasks = uxTaskGetSystemState(taskStatusArray, numTasks, NULL);
+static int handleSetFilter(const JsonDocument &request, JsonDocument &response)
+{
+    SensorHandler::StreamKind kind;
+    StreamFilter::Config config;
+    config.decimation = request["n"] | 1;
+    config.window = request["w"] | 1;
+    config.cutoffHz = request["fc"] | 0.0f;
+    uint8_t address = request["a"] | 0;
+    uint8_t index = request["i"] | 0;
 
-    JsonArray tasks = doc["tasks"].to<JsonArray>();
-    for (UBaseType_t i = 0; i < numTasks; i++)
+    if (!SensorHandler::parseStreamKind(request["s"], kind) ||
+        !StreamFilter::parseType(request["f"] | "none", config.type) ||
+        !sensorHandler.setStreamFilter(kind, address, index, config))
     {
-        JsonObject t = tasks.add<JsonObject>();
-        t["name"] = taskStatusArray[i].pcTaskName;
-        t["stack_high_water_mark"] = taskStatusArray[i].usStackHighWaterMark;
+        response["error"] = "Invalid filter configuration";
+        return 400;
     }
+    return 200;
+}
 
-    vPortFree(taskStatusArray);
+static int handleGetLogFormats(const JsonDocument &request, JsonDocument &response)
+{
+    binaryLog.getFormats(response);
+    response["dropped"] = binaryLog.dropped();
+    return 200;
 }
 
-void getHeapInfo(JsonDocument &doc)
+static int handleGetHistory(const JsonDocument &request, JsonDocument &response)
 {
-    size_t freeHeap = esp_get_free_heap_size();
-    size_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    uint8_t channel = request["c"] | 0;
+    uint32_t sinceSeq = request["since"] | 0;
+    uint32_t sinceMs = request["since_ms"] | 0;
+    if (!telemetryHistory.requestReplay(channel, sinceSeq, sinceMs))
+    {
+        response["error"] = "Channel not retained or replay queue full";
+        return 400;
+    }
+    return 200;
+}
 
-    doc["free_heap"] = freeHeap;
-    doc["largest_free_block"] = largestBlock;
+static int handleGetHistoryInfo(const JsonDocument &request, JsonDocument &response)
+{
+    telemetryHistory.getInfo(response);
+    return 200;
+}
+
+// Range-checked before it narrows to uint8_t, so "x", 256 or -1 never silently address ESC 0
+static bool toEscIndex(long raw, uint8_t &index)
+{
+    if (raw < 0 || raw >= NUM_ESC)
+    {
+        return false;
+    }
+    index = static_cast<uint8_t>(raw);
+    return true;
+}
+
+static int handleRamp(const JsonDocument &request, JsonDocument &response)
+{
+    uint32_t durationMs = request["ms"] | 0;
+    bool ok = request["t"].is<JsonObjectConst>();
+    for (JsonPairConst kv : request["t"].as<JsonObjectConst>())
+    {
+        const char *key = kv.key().c_str();
+        char *end = nullptr;
+        long raw = strtol(key, &end, 10);
+        uint8_t index;
+        if (end == key || *end != '\0' || !toEscIndex(raw, index))
+        {
+            ok = false;
+            continue;
+        }
+        ok &= setMotorRamp(index, kv.value().as<float>(), durationMs);
+    }
+    if (!ok)
+    {
+        response["error"] = "Invalid ramp";
+        return 400;
+    }
+    return 200;
+}
+
+static int handleSetSlew(const JsonDocument &request, JsonDocument &response)
+{
+    float slew = request["s"] | MOTOR_SLEW_LIMIT;
+    float accel = request["a"] | MOTOR_ACCEL_LIMIT;
+    bool ok = true;
+    if (!request["i"].isNull())
+    {
+        uint8_t index;
+        ok = request["i"].is<long>() && toEscIndex(request["i"].as<long>(), index) && setMotorLimits(index, slew, accel);
+    }
+    else
+    {
+        for (uint8_t i = 0; i < NUM_ESC; ++i)
+        {
+            ok &= setMotorLimits(i, slew, accel);
+        }
+    }
+    if (!ok)
+    {
+        response["error"] = "Invalid limits";
+        return 400;
+    }
+    return 200;
+}
+
+static int handleSetFailsafe(const JsonDocument &request, JsonDocument &response)
+{
+    uint8_t first = 0;
+    uint8_t last = NUM_ESC - 1;
+    if (!request["i"].isNull())
+    {
+        if (!request["i"].is<long>() || !toEscIndex(request["i"].as<long>(), first))
+        {
+            response["error"] = "Invalid ESC index";
+            return 400;
+        }
+        last = first;
+    }
+    JsonVariantConst timeout = request["ms"];
+    if (!timeout.isNull() && !settings.validate(static_cast<size_t>(Setting::SafetyTimeoutMs), timeout))
+    {
+        response["error"] = "Invalid timeout";
+        return 400;
+    }
+    bool ok = true;
+    for (uint8_t i = first; i <= last && ok; ++i)
+    {
+        uint32_t timeoutMs = timeout | motorWatchdog.getTimeoutMs(i);
+        float fallback = request["v"] | getMotorFailsafeValue(i);
+        ok = setMotorFailsafe(i, timeoutMs, fallback);
+    }
+    if (!ok)
+    {
+        response["error"] = "Invalid ESC index";
+        return 400;
+    }
+    // A timeout for every ESC is the safety_ms setting, so get_settings and "save" see it.
+    // Per-ESC timeouts and the fallbacks are runtime only
+    if (request["i"].isNull() && !timeout.isNull())
+    {
+        setSetting(Setting::SafetyTimeoutMs, timeout);
+    }
+    if ((request["save"] | false) && !saveSettings())
+    {
+        response["error"] = "Failed to save settings";
+        return 500;
+    }
+    return 200;
+}
+
+static int handleGetLatency(const JsonDocument &request, JsonDocument &response)
+{
+    latencyProbe.getStats(response);
+    return 200;
+}
+
+static int handleResetLatency(const JsonDocument &request, JsonDocument &response)
+{
+    latencyProbe.reset();
+    return 200;
+}
+
+static int handleSetAllocation(const JsonDocument &request, JsonDocument &response)
+{
+    // Parse and validate everything first, a rejected request leaves the allocator untouched
+    bool hasPriorities = request["p"].is<JsonArrayConst>();
+    bool hasIndex = request["i"].is<int>();
+    bool hasRow = hasIndex && request["r"].is<JsonArrayConst>();
+    bool hasCurve = hasIndex && (request["fw"].is<float>() || request["rv"].is<float>() || request["e"].is<float>());
+    int index = request["i"] | -1;
+    bool ok = !hasIndex || (index >= 0 && index < NUM_ESC);
+
+    uint8_t priorities[ThrustAllocator::DOF];
+    if (ok && hasPriorities)
+    {
+        JsonArrayConst values = request["p"];
+        ok = values.size() == ThrustAllocator::DOF;
+        for (size_t j = 0; ok && j < ThrustAllocator::DOF; ++j)
+        {
+            priorities[j] = values[j] | 0;
+        }
+    }
+
+    float row[ThrustAllocator::DOF];
+    if (ok && hasRow)
+    {
+        JsonArrayConst values = request["r"];
+        ok = values.size() == ThrustAllocator::DOF;
+        for (size_t j = 0; ok && j < ThrustAllocator::DOF; ++j)
+        {
+            row[j] = values[j] | 0.0f;
+        }
+    }
+
+    // Keys left out keep the current curve of that thruster
+    ThrustAllocator::Curve curve;
+    if (ok && hasCurve)
+    {
+        ok = getAllocationCurve(index, curve);
+        curve.maxForward = request["fw"] | curve.maxForward;
+        curve.maxReverse = request["rv"] | curve.maxReverse;
+        curve.exponent = request["e"] | curve.exponent;
+        ok = ok && ThrustAllocator::isValid(curve);
+    }
+
+    if (!ok)
+    {
+        response["error"] = "Invalid allocation";
+        return 400;
+    }
+    if (hasPriorities)
+    {
+        setAllocationPriorities(priorities);
+    }
+    if (hasRow)
+    {
+        setAllocationRow(index, row);
+    }
+    if (hasCurve)
+    {
+        setAllocationCurve(index, curve);
+    }
+    return 200;
+}
+
+static int handleGetAllocation(const JsonDocument &request, JsonDocument &response)
+{
+    getAllocation(response);
+    return 200;
+}
+
+static int handleGetMotorStats(const JsonDocument &request, JsonDocument &response)
+{
+    JsonArray posted = response["posted"].to<JsonArray>();
+    JsonArray skipped = response["skipped"].to<JsonArray>();
+    JsonArray outputs = response["out"].to<JsonArray>();
+    JsonArray targets = response["tgt"].to<JsonArray>();
+    JsonArray trips = response["fs"].to<JsonArray>();
+    for (uint8_t i = 0; i < NUM_ESC; ++i)
+    {
+        posted.add(motorMailbox.getPosted(i));
+        skipped.add(motorMailbox.getSkipped(i));
+        float output, target;
+        getMotorProfile(i, output, target);
+        outputs.add(output);
+        targets.add(target);
+        trips.add(motorWatchdog.getTrips(i));
+    }
+    return 200;
+}
+
+static DeviceBus::RGB unpackColor(uint32_t rgb)
+{
+    return {static_cast<uint8_t>(rgb >> 16), static_cast<uint8_t>(rgb >> 8), static_cast<uint8_t>(rgb)};
+}
+
+// Reads an optional integer field into value, false when it is present but not an integer
+// in min..max. Checked before the field narrows, so 256 or -1 never wrap to a valid board
+static bool readRange(JsonVariantConst field, long min, long max, long &value)
+{
+    if (field.isNull())
+    {
+        return true;
+    }
+    if (!field.is<long>() || field.as<long>() < min || field.as<long>() > max)
+    {
+        return false;
+    }
+    value = field.as<long>();
+    return true;
+}
+
+static int handleSetBoardLeds(const JsonDocument &request, JsonDocument &response)
+{
+    JsonArrayConst values = request["c"];
+    DeviceBus::RGB colors[BOARD_LED_MAX];
+    size_t count = values.size();
+    if (count == 0 || count > BOARD_LED_MAX)
+    {
+        response["error"] = "Invalid LED colors";
+        return 400;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        colors[i] = unpackColor(values[i] | 0u);
+    }
+    long address = 0;
+    long start = 0;
+    if (!readRange(request["a"], 0, 0x7F, address) || !readRange(request["s"], 0, BOARD_LED_MAX - 1, start))
+    {
+        response["error"] = "Invalid board address or LED index";
+        return 400;
+    }
+    if (!sensorHandler.setBoardLeds(address, start, colors, count))
+    {
+        response["error"] = "Unknown board or LED range";
+        return 400;
+    }
+    return 200;
+}
+
+static int handleSetBoardPattern(const JsonDocument &request, JsonDocument &response)
+{
+    long address = 0;
+    long periodMs = 1000;
+    if (!readRange(request["a"], 0, 0x7F, address) || !readRange(request["ms"], 0, UINT16_MAX, periodMs))
+    {
+        response["error"] = "Invalid board address or period";
+        return 400;
+    }
+    DeviceBus::LedPattern pattern;
+    if (!DeviceBus::parseLedPattern(request["p"] | "", pattern) ||
+        !sensorHandler.setBoardLedPattern(address, pattern, unpackColor(request["c"] | 0xFFFFFFu), periodMs))
+    {
+        response["error"] = "Unknown board or pattern";
+        return 400;
+    }
+    return 200;
+}
+
+static int handleListCommands(const JsonDocument &request, JsonDocument &response)
+{
+    commandRegistry.list(response);
+    return 200;
+}
+
+static void registerSignalingCommands()
+{
+    commandRegistry.add(Command::Ping, handlePing);
+    commandRegistry.add(Command::GetWaterLevel, handleGetWaterLevel);
+    commandRegistry.add(Command::GetHeapInfo, handleGetHeapInfo);
+    commandRegistry.add(Command::GetBoards, handleGetBoards);
+    commandRegistry.add(Command::SetOrientation, handleSetOrientation);
+    commandRegistry.add(Command::SetFilter, handleSetFilter);
+    commandRegistry.add(Command::GetLogFormats, handleGetLogFormats);
+    commandRegistry.add(Command::GetHistory, handleGetHistory);
+    commandRegistry.add(Command::GetHistoryInfo, handleGetHistoryInfo);
+    commandRegistry.add(Command::Ramp, handleRamp);
+    commandRegistry.add(Command::SetSlew, handleSetSlew);
+    commandRegistry.add(Command::SetFailsafe, handleSetFailsafe);
+    commandRegistry.add(Command::GetLatency, handleGetLatency);
+    commandRegistry.add(Command::ResetLatency, handleResetLatency);
+    commandRegistry.add(Command::SetAllocation, handleSetAllocation);
+    commandRegistry.add(Command::GetAllocation, handleGetAllocation);
+    commandRegistry.add(Command::GetMotorStats, handleGetMotorStats);
+    commandRegistry.add(Command::ListCommands, handleListCommands);
+    commandRegistry.add(Command::SetBoardLeds, handleSetBoardLeds);
+    commandRegistry.add(Command::SetBoardPattern, handleSetBoardPattern);
 }
 
 void signalingTask(void *parameter)
@@ -55,65 +436,7 @@ void signalingTask(void *parameter)
     {
         if (xQueueReceive(signalQueue, &doc, pdMS_TO_TICKS(20)) == pdPASS && doc != nullptr)
         {
-            // get the command type from the document
-            String commandType = (*doc)["cmd"] | "unknown";
-            unsigned long long commandHash = hash_str(commandType.c_str());
-            switch (commandHash)
-            {
-            case hash_str("ping"):
-            {
-                JsonDocument response;
-                response.clear();
-
-                // LOG_WEBSERIALLN("Received ping command");
-                // Respond with a pong message
-                response["msg"] = "pong";
-                response["status"] = 200;
-                response["timestamp"] = millis();
-
-                if (response
-                        .overflowed())
-                {
-
-                    LOG_WEBSERIALLN("Response document overflowed");
-                    response.clear();
-                    response["status"] = 500;
-                    response["error"] = "Response document overflowed";
-                }
-
-                serialio.publish(254, response);
-                break;
-            }
-
-            case hash_str("get_water_level"):
-            {
-                JsonDocument response;
-                response.clear();
-
-                LOG_WEBSERIALLN("Received get_water_level command");
-                // Respond with the current water level
-                getHighWater(response); // Assume this function exists
-                response["status"] = 200;
-                response["timestamp"] = millis();
-                serialio.publish(254, response);
-                break;
-            }
-
-            case hash_str("get_heap_info"):
-            {
-                JsonDocument response;
-                response.clear();
-                getHeapInfo(response);
-                response["status"] = 200;
-                response["timestamp"] = millis();
-                serialio.publish(254, response);
-                break;
-            }
-
-            default:
-                LOG_WEBSERIALLN("Unknown command: " + commandType);
-                break;
-            }
+            commandRegistry.dispatch(*doc);
 
             delete doc;    // ✅ Only delete when we actually received something
             doc = nullptr; // Reset for safety
@@ -131,6 +454,8 @@ QueueHandle_t *setupSignalingControl()
         return nullptr;
     }
 
+    registerSignalingCommands();
+
     BaseType_t taskResult = xTaskCreatePinnedToCore(signalingTask, "SignalingTask", SIGNALING_TASK_STACK_SIZE, NULL, SIGNALING_TASK_PRIORITY, NULL, 1);
     if (taskResult != pdPASS)
     {